@@ -0,0 +1,259 @@
+#include "audio_stream_hatch.h"
+
+void AudioStreamPlaybackHatch::_prefetch_thread_func(void *p_userdata){
+	((AudioStreamPlaybackHatch *)p_userdata)->_prefetch();
+}
+
+void AudioStreamPlaybackHatch::_prefetch(){
+	bool just_looped = false;
+
+	while (not exit_requested.is_set()){
+		if (seek_pending.is_set()){
+			decoder->seek(seek_frame.get());
+			stream_ended.clear();
+			just_looped = false;
+
+			//order matters: the mixer trusts flush_position once it sees the seek is done
+			flush_position.set(ring_write.get());
+			seek_pending.clear();
+		}
+
+		uint64_t write = ring_write.get();
+		uint64_t free = HATCH_AUDIO_RING_FRAMES - (write - ring_read.get());
+
+		if (free < HATCH_AUDIO_DECODE_FRAMES or stream_ended.is_set()){
+			prefetch_semaphore.wait();
+			continue;
+		}
+
+		uint32_t offset = write & (HATCH_AUDIO_RING_FRAMES - 1);
+		int count = MIN(HATCH_AUDIO_DECODE_FRAMES, HATCH_AUDIO_RING_FRAMES - offset);
+
+		int got = decoder->decode(ring.ptr() + offset, count);
+
+		if (got == 0){
+			//a loop that immediately ends again has nothing left to play
+			if (loop and not just_looped){
+				decoder->seek(loop_offset_frames);
+				just_looped = true;
+			} else {
+				stream_ended.set();
+			}
+			continue;
+		}
+
+		just_looped = false;
+		ring_write.set(write + got);
+	}
+}
+
+void AudioStreamPlaybackHatch::_start_thread(){
+	if (prefetch_thread.is_started()){
+		return;
+	}
+
+	exit_requested.clear();
+	prefetch_thread.start(_prefetch_thread_func, this);
+}
+
+void AudioStreamPlaybackHatch::_stop_thread(){
+	if (not prefetch_thread.is_started()){
+		return;
+	}
+
+	exit_requested.set();
+	prefetch_semaphore.post();
+	prefetch_thread.wait_to_finish();
+}
+
+uint64_t AudioStreamPlaybackHatch::_get_stream_frame() const {
+	uint64_t frame = start_frame.get() + frames_mixed.get();
+
+	if (loop and length_frames > loop_offset_frames and frame >= length_frames){
+		frame = loop_offset_frames + (frame - length_frames) % (length_frames - loop_offset_frames);
+	}
+
+	return frame;
+}
+
+int AudioStreamPlaybackHatch::_mix_internal(AudioFrame *p_buffer, int p_frames){
+	if (not active.is_set() or seek_pending.is_set()){
+		memset(p_buffer, 0, sizeof(AudioFrame) * p_frames);
+		return p_frames;
+	}
+
+	//drop whatever was decoded before the last seek
+	uint64_t read = MAX(ring_read.get(), flush_position.get());
+	uint64_t available = ring_write.get() - read;
+	int mixed = MIN((uint64_t)p_frames, available);
+
+	for (int i = 0; i < mixed; i++){
+		p_buffer[i] = ring[(read + i) & (HATCH_AUDIO_RING_FRAMES - 1)];
+	}
+
+	ring_read.set(read + mixed);
+	frames_mixed.add(mixed);
+	prefetch_semaphore.post();
+
+	if (mixed < p_frames){
+		//an underrun plays silence rather than stalling the mixer
+		memset(p_buffer + mixed, 0, sizeof(AudioFrame) * (p_frames - mixed));
+
+		if (stream_ended.is_set() and ring_write.get() == read + mixed){
+			active.clear();
+		}
+	}
+
+	return p_frames;
+}
+
+float AudioStreamPlaybackHatch::get_stream_sampling_rate(){
+	return mix_rate;
+}
+
+void AudioStreamPlaybackHatch::start(double p_from_pos){
+	ERR_FAIL_NULL(decoder);
+
+	seek(p_from_pos);
+	begin_resample();
+	active.set();
+
+	_start_thread();
+}
+
+void AudioStreamPlaybackHatch::stop(){
+	active.clear();
+	_stop_thread();
+}
+
+bool AudioStreamPlaybackHatch::is_playing() const {
+	return active.is_set();
+}
+
+int AudioStreamPlaybackHatch::get_loop_count() const {
+	uint64_t frame = start_frame.get() + frames_mixed.get();
+
+	if (not loop or length_frames <= loop_offset_frames or frame < length_frames){
+		return 0;
+	}
+
+	return 1 + (frame - length_frames) / (length_frames - loop_offset_frames);
+}
+
+double AudioStreamPlaybackHatch::get_playback_position() const {
+	return mix_rate > 0 ? (double)_get_stream_frame() / mix_rate : 0.0;
+}
+
+void AudioStreamPlaybackHatch::seek(double p_time){
+	uint64_t frame = MAX(p_time, 0.0) * mix_rate;
+	if (length_frames > 0){
+		frame = MIN(frame, length_frames);
+	}
+
+	start_frame.set(frame);
+	frames_mixed.set(0);
+
+	seek_frame.set(frame);
+	seek_pending.set();
+	prefetch_semaphore.post();
+}
+
+void AudioStreamPlaybackHatch::tag_used_streams(){
+	hatch_stream->tag_used(get_playback_position());
+}
+
+AudioStreamPlaybackHatch::~AudioStreamPlaybackHatch(){
+	_stop_thread();
+
+	if (decoder != nullptr){
+		memdelete(decoder);
+	}
+}
+
+void AudioStreamHatch::set_file_path(String p_file_path){
+	file_path = p_file_path;
+	mix_rate = 0;
+	length_frames = 0;
+
+	if (file_path.is_empty()){
+		return;
+	}
+
+	//read the headers once up front, so every playback doesn't have to scan for the length
+	HatchEntryStream entry;
+	ERR_FAIL_COND_MSG(entry.open_path(file_path) != OK, "Could not open Hatch audio \"" + file_path + "\".");
+
+	HatchAudioDecoder *decoder = HatchAudioDecoder::create(&entry);
+	ERR_FAIL_NULL_MSG(decoder, "Could not decode Hatch audio \"" + file_path + "\".");
+
+	mix_rate = decoder->get_mix_rate();
+	length_frames = decoder->get_length_frames();
+
+	memdelete(decoder);
+}
+
+String AudioStreamHatch::get_file_path() const {
+	return file_path;
+}
+
+void AudioStreamHatch::set_loop(bool enable){
+	loop = enable;
+}
+
+bool AudioStreamHatch::has_loop() const {
+	return loop;
+}
+
+void AudioStreamHatch::set_loop_offset(double seconds){
+	loop_offset = MAX(seconds, 0.0);
+}
+
+double AudioStreamHatch::get_loop_offset() const {
+	return loop_offset;
+}
+
+Ref<AudioStreamPlayback> AudioStreamHatch::instantiate_playback(){
+	ERR_FAIL_COND_V_MSG(mix_rate <= 0, Ref<AudioStreamPlayback>(), "Hatch audio stream has no playable file set.");
+
+	Ref<AudioStreamPlaybackHatch> playback;
+	playback.instantiate();
+
+	ERR_FAIL_COND_V(playback->entry.open_path(file_path) != OK, Ref<AudioStreamPlayback>());
+
+	playback->decoder = HatchAudioDecoder::create(&playback->entry);
+	ERR_FAIL_NULL_V(playback->decoder, Ref<AudioStreamPlayback>());
+
+	playback->hatch_stream = Ref<AudioStreamHatch>(this);
+	playback->mix_rate = mix_rate;
+	playback->length_frames = length_frames;
+	playback->loop = loop;
+	playback->loop_offset_frames = loop_offset * mix_rate;
+	playback->ring.resize(HATCH_AUDIO_RING_FRAMES);
+
+	return playback;
+}
+
+String AudioStreamHatch::get_stream_name() const {
+	return file_path.get_file();
+}
+
+double AudioStreamHatch::get_length() const {
+	return mix_rate > 0 ? (double)length_frames / mix_rate : 0.0;
+}
+
+bool AudioStreamHatch::is_monophonic() const {
+	return false;
+}
+
+void AudioStreamHatch::_bind_methods(){
+	ClassDB::bind_method(D_METHOD("set_file_path", "file_path"), &AudioStreamHatch::set_file_path);
+	ClassDB::bind_method(D_METHOD("get_file_path"), &AudioStreamHatch::get_file_path);
+	ClassDB::bind_method(D_METHOD("set_loop", "enable"), &AudioStreamHatch::set_loop);
+	ClassDB::bind_method(D_METHOD("has_loop"), &AudioStreamHatch::has_loop);
+	ClassDB::bind_method(D_METHOD("set_loop_offset", "seconds"), &AudioStreamHatch::set_loop_offset);
+	ClassDB::bind_method(D_METHOD("get_loop_offset"), &AudioStreamHatch::get_loop_offset);
+
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "file_path"), "set_file_path", "get_file_path");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "loop"), "set_loop", "has_loop");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "loop_offset", PROPERTY_HINT_RANGE, "0,3600,0.001,suffix:s"), "set_loop_offset", "get_loop_offset");
+}
@@ -0,0 +1,118 @@
+#ifndef AUDIO_STREAM_HATCH_H
+#define AUDIO_STREAM_HATCH_H
+
+#include "hatch_audio_decoder.h"
+
+#include "core/os/semaphore.h"
+#include "core/os/thread.h"
+#include "core/templates/safe_refcount.h"
+#include "servers/audio/audio_stream.h"
+
+//Decoded frames buffered ahead of the mixer, must be a power of two (~370ms at 44.1kHz)
+#define HATCH_AUDIO_RING_FRAMES 16384
+#define HATCH_AUDIO_DECODE_FRAMES 1024
+
+class AudioStreamHatch;
+
+/*
+ A background thread keeps a small ring of decoded frames topped up, and the mixer only ever
+ copies out of it, so no file IO, inflating or decrypting happens on the audio thread. Seeks
+ and loops are handled by the prefetch thread; the mixer plays silence while one is pending.
+ */
+class AudioStreamPlaybackHatch : public AudioStreamPlaybackResampled {
+	GDCLASS(AudioStreamPlaybackHatch, AudioStreamPlaybackResampled);
+
+	friend class AudioStreamHatch;
+
+	Ref<AudioStreamHatch> hatch_stream;
+
+	HatchEntryStream entry;
+	HatchAudioDecoder *decoder = nullptr;
+
+	int mix_rate = 0;
+	uint64_t length_frames = 0;
+	bool loop = false;
+	uint64_t loop_offset_frames = 0;
+
+	LocalVector<AudioFrame> ring;
+	SafeNumeric<uint64_t> ring_read;
+	SafeNumeric<uint64_t> ring_write;
+
+	Thread prefetch_thread;
+	Semaphore prefetch_semaphore;
+	SafeFlag exit_requested;
+
+	SafeFlag seek_pending;
+	SafeNumeric<uint64_t> seek_frame;
+	SafeNumeric<uint64_t> flush_position; //ring position where frames from the latest seek start
+	SafeFlag stream_ended;
+
+	SafeFlag active;
+	SafeNumeric<uint64_t> start_frame;
+	SafeNumeric<uint64_t> frames_mixed;
+
+	static void _prefetch_thread_func(void *p_userdata);
+	void _prefetch();
+
+	void _start_thread();
+	void _stop_thread();
+
+	uint64_t _get_stream_frame() const;
+
+protected:
+	virtual int _mix_internal(AudioFrame *p_buffer, int p_frames) override;
+	virtual float get_stream_sampling_rate() override;
+
+public:
+	virtual void start(double p_from_pos = 0.0) override;
+	virtual void stop() override;
+	virtual bool is_playing() const override;
+
+	virtual int get_loop_count() const override;
+
+	virtual double get_playback_position() const override;
+	virtual void seek(double p_time) override;
+
+	virtual void tag_used_streams() override;
+
+	~AudioStreamPlaybackHatch();
+};
+
+/*
+ Plays WAV or Ogg Vorbis straight out of a Hatch archive (or any file) without loading it into
+ memory. Paths starting with "hatch://" come from the mounted HatchArchiveReader. Each playback
+ keeps a few hundred KB resident no matter how long the track is.
+ */
+class AudioStreamHatch : public AudioStream {
+	GDCLASS(AudioStreamHatch, AudioStream);
+
+	friend class AudioStreamPlaybackHatch;
+
+	String file_path;
+	bool loop = false;
+	double loop_offset = 0.0;
+
+	int mix_rate = 0;
+	uint64_t length_frames = 0;
+
+protected:
+	static void _bind_methods();
+
+public:
+	void set_file_path(String file_path);
+	String get_file_path() const;
+
+	void set_loop(bool enable);
+	bool has_loop() const;
+
+	void set_loop_offset(double seconds);
+	double get_loop_offset() const;
+
+	virtual Ref<AudioStreamPlayback> instantiate_playback() override;
+	virtual String get_stream_name() const override;
+
+	virtual double get_length() const override;
+	virtual bool is_monophonic() const override;
+};
+
+#endif
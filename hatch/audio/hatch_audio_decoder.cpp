@@ -0,0 +1,373 @@
+#include "hatch_audio_decoder.h"
+
+#include "core/io/marshalls.h"
+
+//How far before a seek target page skipping stops, so the codec has a packet to prime with
+#define HATCH_VORBIS_SEEK_MARGIN 4096
+
+//How far from the end the last Ogg page is searched for
+#define HATCH_VORBIS_LENGTH_SCAN (64 * 1024)
+
+HatchAudioDecoder *HatchAudioDecoder::create(HatchEntryStream *p_stream){
+	ERR_FAIL_COND_V(p_stream == nullptr or not p_stream->is_open(), nullptr);
+
+	uint8_t magic[4] = {};
+	p_stream->seek(0);
+	p_stream->read(magic, 4);
+	p_stream->seek(0);
+
+	HatchAudioDecoder *decoder = nullptr;
+
+	if (memcmp(magic, "RIFF", 4) == 0){
+		decoder = memnew(HatchAudioDecoderWAV);
+	} else if (memcmp(magic, "OggS", 4) == 0){
+		decoder = memnew(HatchAudioDecoderVorbis);
+	} else {
+		ERR_FAIL_V_MSG(nullptr, "Hatch audio streams must be WAV or Ogg Vorbis.");
+	}
+
+	if (decoder->open(p_stream) != OK){
+		memdelete(decoder);
+		return nullptr;
+	}
+
+	return decoder;
+}
+
+float HatchAudioDecoderWAV::_sample(const uint8_t *p_data) const {
+	switch (format){
+		case FORMAT_PCM8:
+			return ((int)p_data[0] - 128) / 128.0f;
+		case FORMAT_PCM16:
+			return (int16_t)decode_uint16(p_data) / 32768.0f;
+		case FORMAT_PCM24:
+			return ((int32_t)(((uint32_t)p_data[0] << 8) | ((uint32_t)p_data[1] << 16) | ((uint32_t)p_data[2] << 24)) >> 8) / 8388608.0f;
+		case FORMAT_FLOAT32:
+			return decode_float(p_data);
+	}
+	return 0;
+}
+
+Error HatchAudioDecoderWAV::open(HatchEntryStream *p_stream){
+	stream = p_stream;
+	stream->seek(0);
+
+	uint8_t header[12];
+	ERR_FAIL_COND_V(stream->read(header, 12) != 12, ERR_FILE_CORRUPT);
+	ERR_FAIL_COND_V_MSG(memcmp(header, "RIFF", 4) != 0 or memcmp(header + 8, "WAVE", 4) != 0, ERR_FILE_UNRECOGNIZED, "Not a WAV file.");
+
+	bool has_format = false;
+	uint8_t chunk[8];
+
+	while (stream->read(chunk, 8) == 8){
+		uint32_t chunk_size = decode_uint32(chunk + 4);
+		uint64_t next_chunk = stream->get_position() + chunk_size + (chunk_size & 1);
+
+		if (memcmp(chunk, "fmt ", 4) == 0){
+			uint8_t fmt[40] = {};
+			stream->read(fmt, MIN(chunk_size, (uint32_t)sizeof(fmt)));
+
+			uint16_t tag = decode_uint16(fmt);
+			channels = decode_uint16(fmt + 2);
+			mix_rate = decode_uint32(fmt + 4);
+			block_align = decode_uint16(fmt + 12);
+			int bits = decode_uint16(fmt + 14);
+
+			//WAVE_FORMAT_EXTENSIBLE keeps the real tag at the start of the sub-format GUID
+			if (tag == 0xFFFE and chunk_size >= 26){
+				tag = decode_uint16(fmt + 24);
+			}
+
+			if (tag == 1 and bits == 8){
+				format = FORMAT_PCM8;
+			} else if (tag == 1 and bits == 16){
+				format = FORMAT_PCM16;
+			} else if (tag == 1 and bits == 24){
+				format = FORMAT_PCM24;
+			} else if (tag == 3 and bits == 32){
+				format = FORMAT_FLOAT32;
+			} else {
+				ERR_FAIL_V_MSG(ERR_UNAVAILABLE, "Unsupported WAV sample format " + itos(tag) + " with " + itos(bits) + " bits.");
+			}
+
+			ERR_FAIL_COND_V(channels <= 0 or mix_rate <= 0 or block_align < channels * (bits / 8), ERR_FILE_CORRUPT);
+			has_format = true;
+		} else if (memcmp(chunk, "data", 4) == 0){
+			ERR_FAIL_COND_V_MSG(not has_format, ERR_FILE_CORRUPT, "WAV data chunk comes before its format chunk.");
+
+			data_offset = stream->get_position();
+			data_frames = MIN((uint64_t)chunk_size, stream->get_length() - data_offset) / block_align;
+			frame_position = 0;
+			return OK;
+		}
+
+		stream->seek(next_chunk);
+	}
+
+	ERR_FAIL_V_MSG(ERR_FILE_CORRUPT, "WAV file has no data chunk.");
+}
+
+int HatchAudioDecoderWAV::decode(AudioFrame *r_frames, int p_count){
+	int bytes_per_sample = format == FORMAT_PCM8 ? 1 : (format == FORMAT_PCM16 ? 2 : (format == FORMAT_PCM24 ? 3 : 4));
+	int written = 0;
+
+	while (written < p_count and frame_position < data_frames){
+		uint64_t frames = MIN((uint64_t)(p_count - written), data_frames - frame_position);
+		frames = MIN(frames, (uint64_t)(sizeof(read_buffer) / block_align));
+
+		uint64_t got = stream->read(read_buffer, frames * block_align) / block_align;
+		if (got == 0){
+			break;
+		}
+
+		for (uint64_t i = 0; i < got; i++){
+			const uint8_t *frame = read_buffer + i * block_align;
+			float left = _sample(frame);
+			float right = channels > 1 ? _sample(frame + bytes_per_sample) : left;
+			r_frames[written++] = AudioFrame(left, right);
+		}
+
+		frame_position += got;
+	}
+
+	return written;
+}
+
+void HatchAudioDecoderWAV::seek(uint64_t p_frame){
+	frame_position = MIN(p_frame, data_frames);
+	stream->seek(data_offset + frame_position * block_align);
+}
+
+bool HatchAudioDecoderVorbis::_read_page(ogg_page &r_page){
+	while (ogg_sync_pageout(&sync_state, &r_page) != 1){
+		char *buffer = ogg_sync_buffer(&sync_state, HATCH_OGG_READ_CHUNK);
+		uint64_t got = stream->read((uint8_t *)buffer, HATCH_OGG_READ_CHUNK);
+		ogg_sync_wrote(&sync_state, got);
+
+		if (got == 0){
+			return false;
+		}
+	}
+	return true;
+}
+
+Error HatchAudioDecoderVorbis::_start(){
+	ogg_sync_init(&sync_state);
+	ogg_stream_init(&stream_state, 0);
+	vorbis_info_init(&info);
+	vorbis_comment_init(&comment);
+
+	ogg_page page;
+	ERR_FAIL_COND_V(not _read_page(page), ERR_FILE_CORRUPT);
+
+	ogg_stream_reset_serialno(&stream_state, ogg_page_serialno(&page));
+	ogg_stream_pagein(&stream_state, &page);
+
+	//identification, comment and setup headers
+	int headers = 0;
+	while (headers < 3){
+		ogg_packet packet;
+		int status = ogg_stream_packetout(&stream_state, &packet);
+
+		if (status == 1){
+			ERR_FAIL_COND_V_MSG(vorbis_synthesis_headerin(&info, &comment, &packet) < 0, ERR_FILE_CORRUPT, "Ogg stream is not Vorbis.");
+			headers++;
+			continue;
+		}
+
+		ERR_FAIL_COND_V(status < 0, ERR_FILE_CORRUPT);
+		ERR_FAIL_COND_V_MSG(not _read_page(page), ERR_FILE_CORRUPT, "Ogg Vorbis headers are truncated.");
+		ogg_stream_pagein(&stream_state, &page);
+	}
+
+	ERR_FAIL_COND_V(vorbis_synthesis_init(&dsp_state, &info) != 0, ERR_FILE_CORRUPT);
+	vorbis_block_init(&dsp_state, &block);
+	initialized = true;
+
+	pcm_position = 0;
+	end_position = -1;
+	seek_target = 0;
+	end_of_stream = false;
+
+	return OK;
+}
+
+void HatchAudioDecoderVorbis::_clear(){
+	if (stream == nullptr){
+		return;
+	}
+
+	if (initialized){
+		vorbis_block_clear(&block);
+		vorbis_dsp_clear(&dsp_state);
+		initialized = false;
+	}
+
+	ogg_stream_clear(&stream_state);
+	vorbis_comment_clear(&comment);
+	vorbis_info_clear(&info);
+	ogg_sync_clear(&sync_state);
+}
+
+Error HatchAudioDecoderVorbis::open(HatchEntryStream *p_stream){
+	_clear();
+
+	stream = p_stream;
+	stream->seek(0);
+
+	return _start();
+}
+
+int HatchAudioDecoderVorbis::decode(AudioFrame *r_frames, int p_count){
+	ERR_FAIL_COND_V(not initialized, 0);
+
+	int written = 0;
+
+	while (written < p_count){
+		float **pcm;
+		int available = vorbis_synthesis_pcmout(&dsp_state, &pcm);
+
+		if (available > 0){
+			int consumed = available;
+
+			if (pcm_position < 0){
+				//position is unknown right after a seek, so these frames can't be placed
+			} else if (pcm_position < seek_target){
+				consumed = MIN((int64_t)available, seek_target - pcm_position);
+			} else if (end_position >= 0 and pcm_position >= end_position){
+				//padding after the last granule position
+			} else {
+				consumed = MIN(available, p_count - written);
+				if (end_position >= 0){
+					consumed = MIN((int64_t)consumed, end_position - pcm_position);
+				}
+
+				float *left = pcm[0];
+				float *right = info.channels > 1 ? pcm[1] : pcm[0];
+
+				for (int i = 0; i < consumed; i++){
+					r_frames[written++] = AudioFrame(left[i], right[i]);
+				}
+			}
+
+			vorbis_synthesis_read(&dsp_state, consumed);
+			if (pcm_position >= 0){
+				pcm_position += consumed;
+			}
+			continue;
+		}
+
+		if (end_of_stream){
+			break;
+		}
+
+		ogg_packet packet;
+		int status = ogg_stream_packetout(&stream_state, &packet);
+
+		if (status == 1){
+			if (vorbis_synthesis(&block, &packet) == 0){
+				vorbis_synthesis_blockin(&dsp_state, &block);
+			}
+
+			if (packet.granulepos >= 0){
+				int pending = vorbis_synthesis_pcmout(&dsp_state, nullptr);
+				if (pcm_position < 0){
+					pcm_position = MAX(packet.granulepos - pending, (int64_t)0);
+				}
+				if (packet.e_o_s){
+					end_position = packet.granulepos;
+				}
+			}
+
+			end_of_stream = packet.e_o_s;
+			continue;
+		}
+
+		if (status < 0){
+			continue; //a hole in the data, decoding picks up at the next packet
+		}
+
+		ogg_page page;
+		if (not _read_page(page)){
+			end_of_stream = true;
+			continue;
+		}
+
+		ogg_stream_pagein(&stream_state, &page);
+	}
+
+	return written;
+}
+
+void HatchAudioDecoderVorbis::seek(uint64_t p_frame){
+	ERR_FAIL_NULL(stream);
+
+	_clear();
+	stream->seek(0);
+	ERR_FAIL_COND(_start() != OK);
+
+	if (p_frame == 0){
+		return;
+	}
+
+	seek_target = p_frame;
+
+	//skip whole pages that end well before the target without decoding them
+	ogg_page page;
+	while (_read_page(page)){
+		if (ogg_page_serialno(&page) != stream_state.serialno){
+			continue;
+		}
+
+		int64_t granule = ogg_page_granulepos(&page);
+		if (granule < 0 or granule + HATCH_VORBIS_SEEK_MARGIN < (int64_t)p_frame){
+			continue;
+		}
+
+		ogg_stream_reset(&stream_state);
+		ogg_stream_pagein(&stream_state, &page);
+		vorbis_synthesis_restart(&dsp_state);
+		pcm_position = -1;
+		return;
+	}
+
+	end_of_stream = true;
+}
+
+uint64_t HatchAudioDecoderVorbis::get_length_frames(){
+	ERR_FAIL_NULL_V(stream, 0);
+
+	//the last page's granule position is the length, so only the tail has to be read
+	uint64_t tail = stream->get_length() > HATCH_VORBIS_LENGTH_SCAN ? stream->get_length() - HATCH_VORBIS_LENGTH_SCAN : 0;
+	stream->seek(tail);
+
+	ogg_sync_state scan;
+	ogg_sync_init(&scan);
+
+	int64_t length = 0;
+	bool done = false;
+
+	while (not done){
+		char *buffer = ogg_sync_buffer(&scan, HATCH_OGG_READ_CHUNK);
+		uint64_t got = stream->read((uint8_t *)buffer, HATCH_OGG_READ_CHUNK);
+		ogg_sync_wrote(&scan, got);
+		done = got == 0;
+
+		ogg_page page;
+		int status;
+		while ((status = ogg_sync_pageout(&scan, &page)) != 0){
+			if (status > 0 and ogg_page_serialno(&page) == stream_state.serialno and ogg_page_granulepos(&page) > length){
+				length = ogg_page_granulepos(&page);
+			}
+		}
+	}
+
+	ogg_sync_clear(&scan);
+
+	seek(0);
+	return length;
+}
+
+HatchAudioDecoderVorbis::~HatchAudioDecoderVorbis(){
+	_clear();
+}
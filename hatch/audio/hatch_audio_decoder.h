@@ -0,0 +1,102 @@
+#ifndef HATCH_AUDIO_DECODER_H
+#define HATCH_AUDIO_DECODER_H
+
+#include "../file_io/hatch_entry_stream.h"
+
+#include "core/math/audio_frame.h"
+
+#include <ogg/ogg.h>
+#include <vorbis/codec.h>
+
+//Compressed bytes handed to libogg per page refill
+#define HATCH_OGG_READ_CHUNK 4096
+
+/*
+ Pull decoders for streamed Hatch audio. They read from a HatchEntryStream and produce stereo
+ frames a block at a time, so only the codec state and one read chunk are ever resident.
+ */
+class HatchAudioDecoder {
+public:
+	//Sniffs the stream and returns a decoder that already parsed its headers, or nullptr
+	static HatchAudioDecoder *create(HatchEntryStream *p_stream);
+
+	virtual Error open(HatchEntryStream *p_stream) = 0;
+
+	//Returns how many frames were written, 0 once the stream has ended
+	virtual int decode(AudioFrame *r_frames, int p_count) = 0;
+	virtual void seek(uint64_t p_frame) = 0;
+
+	virtual int get_mix_rate() const = 0;
+
+	//0 if unknown; may have to read through the stream, so call it once and keep the result
+	virtual uint64_t get_length_frames() = 0;
+
+	virtual ~HatchAudioDecoder() {}
+};
+
+class HatchAudioDecoderWAV : public HatchAudioDecoder {
+	enum SampleFormat {
+		FORMAT_PCM8,
+		FORMAT_PCM16,
+		FORMAT_PCM24,
+		FORMAT_FLOAT32,
+	};
+
+	HatchEntryStream *stream = nullptr;
+
+	SampleFormat format = FORMAT_PCM16;
+	int channels = 0;
+	int mix_rate = 0;
+	int block_align = 0;
+
+	uint64_t data_offset = 0;
+	uint64_t data_frames = 0;
+	uint64_t frame_position = 0;
+
+	uint8_t read_buffer[4096];
+
+	float _sample(const uint8_t *p_data) const;
+
+public:
+	virtual Error open(HatchEntryStream *p_stream) override;
+	virtual int decode(AudioFrame *r_frames, int p_count) override;
+	virtual void seek(uint64_t p_frame) override;
+
+	virtual int get_mix_rate() const override { return mix_rate; }
+	virtual uint64_t get_length_frames() override { return data_frames; }
+};
+
+class HatchAudioDecoderVorbis : public HatchAudioDecoder {
+	HatchEntryStream *stream = nullptr;
+
+	ogg_sync_state sync_state;
+	ogg_stream_state stream_state;
+	vorbis_info info;
+	vorbis_comment comment;
+	vorbis_dsp_state dsp_state;
+	vorbis_block block;
+
+	bool initialized = false;
+	bool end_of_stream = false;
+
+	//sample position of the next decoded frame, -1 until a granule position pins it down after a seek
+	int64_t pcm_position = 0;
+	int64_t end_position = -1;
+	int64_t seek_target = 0;
+
+	bool _read_page(ogg_page &r_page);
+	Error _start();
+	void _clear();
+
+public:
+	virtual Error open(HatchEntryStream *p_stream) override;
+	virtual int decode(AudioFrame *r_frames, int p_count) override;
+	virtual void seek(uint64_t p_frame) override;
+
+	virtual int get_mix_rate() const override { return info.rate; }
+	virtual uint64_t get_length_frames() override;
+
+	~HatchAudioDecoderVorbis();
+};
+
+#endif
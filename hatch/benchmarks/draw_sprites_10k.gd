@@ -0,0 +1,64 @@
+extends Node2D
+
+## Draws 10k moving sprites per frame through HatchDrawBuffer and prints timings once a second.
+## Copy this folder into a project and run draw_sprites_10k.tscn.
+
+const SPRITE_COUNT := 10000
+const SPRITE_SIZE := 16
+
+var buffer: HatchDrawBuffer
+var sheet: ImageTexture
+var positions := PackedVector2Array()
+var velocities := PackedVector2Array()
+
+var record_usec := 0
+var frames := 0
+var elapsed := 0.0
+
+
+func _ready() -> void:
+	# One 64x16 sheet holding four differently coloured frames, like a small sprite sheet.
+	var image := Image.create(SPRITE_SIZE * 4, SPRITE_SIZE, false, Image.FORMAT_RGBA8)
+	var colors := [Color.RED, Color.GREEN, Color.BLUE, Color.YELLOW]
+	for i in 4:
+		image.fill_rect(Rect2i(i * SPRITE_SIZE, 0, SPRITE_SIZE, SPRITE_SIZE), colors[i])
+	sheet = ImageTexture.create_from_image(image)
+
+	buffer = HatchDrawBuffer.new()
+	add_child(buffer)
+	buffer.make_active()
+
+	var area := get_viewport_rect().size
+	positions.resize(SPRITE_COUNT)
+	velocities.resize(SPRITE_COUNT)
+	for i in SPRITE_COUNT:
+		positions[i] = Vector2(randf() * area.x, randf() * area.y)
+		velocities[i] = Vector2.from_angle(randf() * TAU) * randf_range(20.0, 120.0)
+
+
+func _process(delta: float) -> void:
+	var area := get_viewport_rect().size
+	var start := Time.get_ticks_usec()
+
+	for i in SPRITE_COUNT:
+		var p := positions[i] + velocities[i] * delta
+		p.x = fposmod(p.x, area.x)
+		p.y = fposmod(p.y, area.y)
+		positions[i] = p
+		buffer.draw_sprite(sheet, Rect2((i % 4) * SPRITE_SIZE, 0, SPRITE_SIZE, SPRITE_SIZE), Rect2(p, Vector2(SPRITE_SIZE, SPRITE_SIZE)))
+
+	record_usec += Time.get_ticks_usec() - start
+	frames += 1
+	elapsed += delta
+
+	if elapsed >= 1.0:
+		print("%d sprites | %.1f fps | record %.2f ms/frame | %d batches | %d draw calls" % [
+			SPRITE_COUNT,
+			frames / elapsed,
+			record_usec / 1000.0 / frames,
+			buffer.get_batch_count(),
+			Performance.get_monitor(Performance.RENDER_TOTAL_DRAW_CALLS_IN_FRAME),
+		])
+		record_usec = 0
+		frames = 0
+		elapsed = 0.0
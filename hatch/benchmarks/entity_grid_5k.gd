@@ -0,0 +1,93 @@
+extends Node2D
+
+## Moves 5k entities through HSLEntityGrid, runs a neighbour query and a collision pass for
+## each of them, and prints timings once a second next to a naive all-pairs scan.
+## Copy this folder into a project and run entity_grid_5k.tscn.
+
+const ENTITY_COUNT := 5000
+const ENTITY_SIZE := 8.0
+const QUERY_RADIUS := 48.0
+const WORLD_SIZE := Vector2(4096, 4096)
+# The naive scan is quadratic, so only time it on a slice of the entities and scale it up.
+const NAIVE_SAMPLE := 250
+
+var grid: HSLEntityGrid
+var ids := PackedInt32Array()
+var positions := PackedVector2Array()
+var velocities := PackedVector2Array()
+
+var move_usec := 0
+var query_usec := 0
+var collide_usec := 0
+var naive_usec := 0
+var found := 0
+var pairs := 0
+var frames := 0
+var elapsed := 0.0
+
+
+func _ready() -> void:
+	grid = HSLEntityGrid.new()
+	grid.cell_size = QUERY_RADIUS * 2.0
+	grid.make_active()
+
+	ids.resize(ENTITY_COUNT)
+	positions.resize(ENTITY_COUNT)
+	velocities.resize(ENTITY_COUNT)
+	for i in ENTITY_COUNT:
+		positions[i] = Vector2(randf() * WORLD_SIZE.x, randf() * WORLD_SIZE.y)
+		velocities[i] = Vector2.from_angle(randf() * TAU) * randf_range(20.0, 120.0)
+		ids[i] = grid.add_entity(Rect2(positions[i], Vector2(ENTITY_SIZE, ENTITY_SIZE)))
+
+
+func _process(delta: float) -> void:
+	var start := Time.get_ticks_usec()
+	for i in ENTITY_COUNT:
+		var p := positions[i] + velocities[i] * delta
+		p.x = fposmod(p.x, WORLD_SIZE.x)
+		p.y = fposmod(p.y, WORLD_SIZE.y)
+		positions[i] = p
+	grid.move_entities(ids, positions)
+	move_usec += Time.get_ticks_usec() - start
+
+	start = Time.get_ticks_usec()
+	for i in ENTITY_COUNT:
+		found += grid.query_radius(positions[i], QUERY_RADIUS).size()
+	query_usec += Time.get_ticks_usec() - start
+
+	start = Time.get_ticks_usec()
+	pairs += grid.get_collision_pairs().size() / 2
+	collide_usec += Time.get_ticks_usec() - start
+
+	start = Time.get_ticks_usec()
+	var radius_squared := QUERY_RADIUS * QUERY_RADIUS
+	for i in NAIVE_SAMPLE:
+		var center := positions[i]
+		for j in ENTITY_COUNT:
+			if center.distance_squared_to(positions[j]) <= radius_squared:
+				pass
+	naive_usec += Time.get_ticks_usec() - start
+
+	frames += 1
+	elapsed += delta
+
+	if elapsed >= 1.0:
+		print("%d entities | %.1f fps | move %.2f ms | query %.2f ms (%.1f hits each) | collide %.2f ms (%d pairs) | naive query est. %.2f ms | %d cells" % [
+			ENTITY_COUNT,
+			frames / elapsed,
+			move_usec / 1000.0 / frames,
+			query_usec / 1000.0 / frames,
+			float(found) / frames / ENTITY_COUNT,
+			collide_usec / 1000.0 / frames,
+			pairs / frames,
+			naive_usec / 1000.0 / frames * (ENTITY_COUNT / float(NAIVE_SAMPLE)),
+			grid.get_cell_count(),
+		])
+		move_usec = 0
+		query_usec = 0
+		collide_usec = 0
+		naive_usec = 0
+		found = 0
+		pairs = 0
+		frames = 0
+		elapsed = 0.0
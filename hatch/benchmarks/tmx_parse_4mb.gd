@@ -0,0 +1,106 @@
+extends Node
+
+## Writes a TMX scene of a few megabytes to user:// and parses it repeatedly, once with
+## HatchTileStreamer.parse_scene (HatchXMLReader underneath) and once by walking it with
+## Godot's XMLParser, then prints the average time and peak memory of each. Both read the
+## file every time and build nothing. Loading the scene into a HatchTileStreamer, layer
+## building included, is timed on its own after that.
+## Copy this folder into a project and run tmx_parse_4mb.tscn.
+
+const MAP_SIZE := 384
+const LAYER_COUNT := 8
+const TILESET_TILES := 1024
+const ITERATIONS := 10
+const SCENE_PATH := "user://tmx_parse_bench.tmx"
+
+
+func _ready() -> void:
+	_write_scene()
+	var size := FileAccess.get_file_as_bytes(SCENE_PATH).size()
+	print("Scene is %.2f MB, %d layers of %dx%d tiles" % [size / 1048576.0, LAYER_COUNT, MAP_SIZE, MAP_SIZE])
+
+	var peak_before := OS.get_static_memory_peak_usage()
+	var start := Time.get_ticks_usec()
+	var hatch_tiles := 0
+	for i in ITERATIONS:
+		hatch_tiles = HatchTileStreamer.parse_scene(SCENE_PATH)
+	var hatch_usec := Time.get_ticks_usec() - start
+	var hatch_peak := OS.get_static_memory_peak_usage() - peak_before
+
+	peak_before = OS.get_static_memory_peak_usage()
+	start = Time.get_ticks_usec()
+	var godot_tiles := 0
+	for i in ITERATIONS:
+		godot_tiles = _walk_with_xml_parser(FileAccess.get_file_as_bytes(SCENE_PATH))
+	var godot_usec := Time.get_ticks_usec() - start
+	var godot_peak := OS.get_static_memory_peak_usage() - peak_before
+
+	print("HatchXMLReader: %.2f ms per parse, peak +%.2f MB, %d tiles" % [
+		hatch_usec / 1000.0 / ITERATIONS,
+		hatch_peak / 1048576.0,
+		hatch_tiles,
+	])
+	print("XMLParser:      %.2f ms per parse, peak +%.2f MB, %d tiles" % [
+		godot_usec / 1000.0 / ITERATIONS,
+		godot_peak / 1048576.0,
+		godot_tiles,
+	])
+
+	var streamer := HatchTileStreamer.new()
+	# a preset tile set skips loading the (missing) tileset image
+	streamer.tile_set = TileSet.new()
+	add_child(streamer)
+
+	start = Time.get_ticks_usec()
+	for i in ITERATIONS:
+		streamer.load_scene(SCENE_PATH)
+	var load_usec := Time.get_ticks_usec() - start
+	streamer.queue_free()
+
+	print("load_scene:     %.2f ms per load, %.2f ms of it building layers" % [
+		load_usec / 1000.0 / ITERATIONS,
+		(load_usec - hatch_usec) / 1000.0 / ITERATIONS,
+	])
+
+
+# Reads what HatchTMXReader reads: every attribute the map uses and the CSV tile data.
+func _walk_with_xml_parser(bytes: PackedByteArray) -> int:
+	var parser := XMLParser.new()
+	parser.open_buffer(bytes)
+	var tiles := 0
+	while parser.read() == OK:
+		match parser.get_node_type():
+			XMLParser.NODE_ELEMENT:
+				for i in parser.get_attribute_count():
+					parser.get_attribute_value(i)
+			XMLParser.NODE_TEXT:
+				var text := parser.get_node_data().strip_edges()
+				if not text.is_empty():
+					tiles += text.split_floats(",").size()
+	return tiles
+
+
+func _write_scene() -> void:
+	var file := FileAccess.open(SCENE_PATH, FileAccess.WRITE)
+	file.store_line('<?xml version="1.0" encoding="UTF-8"?>')
+	file.store_line('<map version="1.10" orientation="orthogonal" width="%d" height="%d" tilewidth="16" tileheight="16" infinite="0">' % [MAP_SIZE, MAP_SIZE])
+	file.store_line(' <tileset firstgid="1" name="bench" tilewidth="16" tileheight="16" tilecount="%d" columns="32">' % TILESET_TILES)
+	file.store_line('  <image source="bench.png" width="512" height="512"/>')
+	file.store_line(' </tileset>')
+
+	var rng := RandomNumberGenerator.new()
+	rng.seed = 1
+	for layer in LAYER_COUNT:
+		file.store_line(' <layer id="%d" name="Layer %d" width="%d" height="%d">' % [layer + 1, layer, MAP_SIZE, MAP_SIZE])
+		file.store_line('  <data encoding="csv">')
+		var row := PackedStringArray()
+		row.resize(MAP_SIZE)
+		for y in MAP_SIZE:
+			for x in MAP_SIZE:
+				row[x] = str(rng.randi_range(0, TILESET_TILES))
+			file.store_line(",".join(row) + ("," if y < MAP_SIZE - 1 else ""))
+		file.store_line('  </data>')
+		file.store_line(' </layer>')
+
+	file.store_line('</map>')
+	file.close()
@@ -1,4 +1,5 @@
 def can_build(env, platform):
+    env.module_add_dependencies("hatch", ["ogg", "vorbis"])
     return True
 
 def configure(env):
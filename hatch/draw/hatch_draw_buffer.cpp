@@ -0,0 +1,600 @@
+#include "hatch_draw_buffer.h"
+
+#include "scene/resources/atlas_texture.h"
+#include "servers/rendering_server.h"
+
+HatchDrawBuffer *HatchDrawBuffer::active = nullptr;
+
+static const char *blend_render_modes[HatchDrawBuffer::BLEND_MAX] = {
+	"blend_mix",
+	"blend_add",
+	"blend_sub",
+	"blend_mul",
+	"blend_premul_alpha",
+};
+
+//Swaps whatever blend the shader's render_mode asks for with p_blend, adding a render_mode if it has none
+static String _shader_code_with_blend(const String &p_code, int p_blend){
+	int render_mode = p_code.find("render_mode");
+	if (render_mode != -1){
+		int end = p_code.find(";", render_mode);
+		ERR_FAIL_COND_V(end == -1, p_code);
+
+		int modes_from = render_mode + strlen("render_mode");
+		Vector<String> modes = p_code.substr(modes_from, end - modes_from).split(",", false);
+
+		String rebuilt;
+		for (const String &mode : modes){
+			String name = mode.strip_edges();
+			if (name.is_empty() or name.begins_with("blend_")){
+				continue;
+			}
+			rebuilt += name + ", ";
+		}
+		rebuilt += blend_render_modes[p_blend];
+
+		return p_code.substr(0, render_mode) + "render_mode " + rebuilt + p_code.substr(end);
+	}
+
+	int shader_type = p_code.find("shader_type");
+	int end = shader_type == -1 ? -1 : p_code.find(";", shader_type);
+	ERR_FAIL_COND_V(end == -1, p_code);
+
+	return p_code.substr(0, end + 1) + "\nrender_mode " + blend_render_modes[p_blend] + ";" + p_code.substr(end + 1);
+}
+
+void HatchDrawBuffer::make_active(){
+	active = this;
+}
+
+void HatchDrawBuffer::set_layer(int layer){
+	ERR_FAIL_INDEX(layer, HATCH_DRAW_MAX_LAYERS);
+	current_layer = layer;
+}
+
+int HatchDrawBuffer::get_layer() const {
+	return current_layer;
+}
+
+void HatchDrawBuffer::set_blend_mode(BlendMode mode){
+	ERR_FAIL_INDEX(mode, BLEND_MAX);
+	current_blend = mode;
+}
+
+HatchDrawBuffer::BlendMode HatchDrawBuffer::get_blend_mode() const {
+	return (BlendMode)current_blend;
+}
+
+void HatchDrawBuffer::set_shader(int shader_id){
+	ERR_FAIL_COND(shader_id < 0 or shader_id > shaders.size());
+	current_shader = shader_id;
+}
+
+int HatchDrawBuffer::get_shader() const {
+	return current_shader;
+}
+
+void HatchDrawBuffer::set_blend_color(Color color){
+	current_color = color;
+}
+
+Color HatchDrawBuffer::get_blend_color() const {
+	return current_color;
+}
+
+void HatchDrawBuffer::set_sort_within_layer(bool enabled){
+	sort_within_layer = enabled;
+}
+
+bool HatchDrawBuffer::is_sorting_within_layer() const {
+	return sort_within_layer;
+}
+
+int HatchDrawBuffer::register_shader(Ref<Material> material){
+	ERR_FAIL_COND_V(material.is_null(), 0);
+	ERR_FAIL_COND_V_MSG(shaders.size() >= HATCH_DRAW_MAX_SHADERS, 0, "Too many shaders registered with HatchDrawBuffer.");
+
+	shaders.push_back(material);
+	return shaders.size();
+}
+
+int HatchDrawBuffer::register_sprite(Ref<SpriteFrames> frames){
+	ERR_FAIL_COND_V(frames.is_null(), 0);
+	ERR_FAIL_COND_V_MSG(sprites.size() >= HATCH_DRAW_MAX_SPRITES, 0, "Too many sprites registered with HatchDrawBuffer.");
+
+	SpriteEntry entry;
+	entry.frames = frames;
+
+	//the atlas builder keeps the pivots per animation in file order; SpriteFrames alone sorts by name
+	Dictionary pivots = frames->get_meta(SNAME("hatch_pivots"), Dictionary());
+	if (not pivots.is_empty()){
+		for (const Variant &name : pivots.keys()){
+			entry.animations.push_back(name);
+			entry.pivots.push_back(pivots[name]);
+		}
+	} else {
+		for (const String &name : frames->get_animation_names()){
+			entry.animations.push_back(name);
+			entry.pivots.push_back(Array());
+		}
+	}
+
+	sprites.push_back(entry);
+	return sprites.size();
+}
+
+uint16_t HatchDrawBuffer::_get_texture_slot(const Ref<Texture2D> &p_texture){
+	if (p_texture.is_null()){
+		return 0;
+	}
+
+	RID rid = p_texture->get_rid();
+
+	const uint16_t *slot = frame_texture_slots.getptr(rid);
+	if (slot != nullptr){
+		return *slot;
+	}
+
+	ERR_FAIL_COND_V_MSG(frame_textures.size() > HATCH_DRAW_MAX_TEXTURES, 0, "Too many distinct textures drawn in one frame.");
+
+	uint16_t new_slot = frame_textures.size();
+	frame_textures.push_back(rid);
+	frame_texture_slots.insert(rid, new_slot);
+
+	return new_slot;
+}
+
+HatchDrawBuffer::DrawCommand *HatchDrawBuffer::_push_command(uint16_t p_texture){
+	ERR_FAIL_COND_V_MSG(commands.size() >= HATCH_DRAW_MAX_COMMANDS, nullptr, "Too many draw commands recorded in one frame.");
+
+	commands.push_back(DrawCommand());
+	DrawCommand *command = &commands[commands.size() - 1];
+
+	command->color = current_color.to_rgba32();
+	command->texture = p_texture;
+	command->blend = current_blend;
+	command->shader = current_shader;
+	command->layer = current_layer;
+
+	return command;
+}
+
+void HatchDrawBuffer::draw_sprite(Ref<Texture2D> texture, Rect2 source, Rect2 destination, bool flip_x, bool flip_y){
+	Transform2D xform;
+	xform.columns[0] = Vector2(destination.size.x, 0);
+	xform.columns[1] = Vector2(0, destination.size.y);
+	xform.columns[2] = destination.position;
+
+	//unit quad scaled by the transform, so the rect case shares the transformed path
+	if (not texture.is_null() and source.size != Vector2()){
+		xform.columns[0] /= source.size.x;
+		xform.columns[1] /= source.size.y;
+	} else if (not texture.is_null()){
+		xform.columns[0] /= MAX(texture->get_width(), 1);
+		xform.columns[1] /= MAX(texture->get_height(), 1);
+	}
+
+	draw_sprite_transformed(texture, source, xform, flip_x, flip_y);
+}
+
+void HatchDrawBuffer::draw_sprite_transformed(Ref<Texture2D> texture, Rect2 source, Transform2D xform, bool flip_x, bool flip_y){
+	//draw atlas regions straight from their page, so frames sharing a page still merge into one run
+	Ref<AtlasTexture> atlas_texture = texture;
+	if (atlas_texture.is_valid() and atlas_texture->get_atlas().is_valid()){
+		Rect2 region = atlas_texture->get_region();
+		if (source.size == Vector2()){
+			source = region;
+		} else {
+			source.position += region.position;
+		}
+		texture = atlas_texture->get_atlas();
+	}
+
+	DrawCommand *command = _push_command(_get_texture_slot(texture));
+	if (command == nullptr){
+		return;
+	}
+
+	Size2 texture_size = texture.is_null() ? Size2(1, 1) : texture->get_size();
+	if (source.size == Vector2()){
+		source = Rect2(Point2(), texture_size);
+	}
+
+	const Point2 corners[4] = {
+		xform.xform(Point2(0, 0)),
+		xform.xform(Point2(source.size.x, 0)),
+		xform.xform(Point2(source.size.x, source.size.y)),
+		xform.xform(Point2(0, source.size.y)),
+	};
+
+	for (int i = 0; i < 4; i++){
+		command->x[i] = corners[i].x;
+		command->y[i] = corners[i].y;
+	}
+
+	command->u0 = source.position.x / texture_size.x;
+	command->v0 = source.position.y / texture_size.y;
+	command->u1 = (source.position.x + source.size.x) / texture_size.x;
+	command->v1 = (source.position.y + source.size.y) / texture_size.y;
+
+	if (flip_x){
+		SWAP(command->u0, command->u1);
+	}
+	if (flip_y){
+		SWAP(command->v0, command->v1);
+	}
+}
+
+void HatchDrawBuffer::draw_sprite_frame(int sprite_id, int animation, int frame, Vector2 position, bool flip_x, bool flip_y){
+	ERR_FAIL_COND(sprite_id < 1 or sprite_id > sprites.size());
+
+	const SpriteEntry &sprite = sprites[sprite_id - 1];
+	ERR_FAIL_INDEX(animation, (int)sprite.animations.size());
+
+	const StringName &name = sprite.animations[animation];
+	ERR_FAIL_INDEX(frame, sprite.frames->get_frame_count(name));
+
+	Ref<Texture2D> texture = sprite.frames->get_frame_texture(name, frame);
+	if (texture.is_null()){
+		return;
+	}
+
+	//same placement as Hatch: the pivot offsets the frame, and flipping mirrors it about the position
+	Size2 size = texture->get_size();
+	const Array &pivots = sprite.pivots[animation];
+	Vector2 pivot = frame < pivots.size() ? Vector2(pivots[frame]) : Vector2();
+
+	Point2 origin = position + pivot;
+	if (flip_x){
+		origin.x = position.x - pivot.x - size.x;
+	}
+	if (flip_y){
+		origin.y = position.y - pivot.y - size.y;
+	}
+
+	draw_sprite(texture, Rect2(), Rect2(origin, size), flip_x, flip_y);
+}
+
+void HatchDrawBuffer::draw_rectangle(Rect2 rect){
+	DrawCommand *command = _push_command(0);
+	if (command == nullptr){
+		return;
+	}
+
+	Point2 end = rect.get_end();
+
+	command->x[0] = rect.position.x;
+	command->y[0] = rect.position.y;
+	command->x[1] = end.x;
+	command->y[1] = rect.position.y;
+	command->x[2] = end.x;
+	command->y[2] = end.y;
+	command->x[3] = rect.position.x;
+	command->y[3] = end.y;
+
+	command->u0 = command->v0 = command->u1 = command->v1 = 0.0f;
+}
+
+void HatchDrawBuffer::draw_line_quad(Vector2 from, Vector2 to, float width){
+	Vector2 direction = to - from;
+	if (direction.is_zero_approx()){
+		return;
+	}
+
+	DrawCommand *command = _push_command(0);
+	if (command == nullptr){
+		return;
+	}
+
+	Vector2 normal = direction.normalized().orthogonal() * (width * 0.5f);
+	const Vector2 corners[4] = { from + normal, to + normal, to - normal, from - normal };
+
+	for (int i = 0; i < 4; i++){
+		command->x[i] = corners[i].x;
+		command->y[i] = corners[i].y;
+	}
+
+	command->u0 = command->v0 = command->u1 = command->v1 = 0.0f;
+}
+
+void HatchDrawBuffer::clear(){
+	commands.clear();
+	frame_textures.resize(1);
+	frame_texture_slots.clear();
+}
+
+Ref<Material> HatchDrawBuffer::_get_material(uint8_t p_shader, uint8_t p_blend){
+	if (p_shader == 0){
+		return blend_materials[p_blend];
+	}
+
+	const Ref<Material> &material = shaders[p_shader - 1];
+	if (p_blend == BLEND_MIX){
+		return material;
+	}
+
+	uint32_t key = ((uint32_t)p_shader << 8) | p_blend;
+	BlendVariant *variant = blend_variants.getptr(key);
+
+	if (variant == nullptr){
+		BlendVariant new_variant;
+
+		Ref<ShaderMaterial> shader_material = material;
+		Ref<CanvasItemMaterial> canvas_material = material;
+
+		if (shader_material.is_valid() and shader_material->get_shader().is_valid()){
+			Ref<Shader> shader = shader_material->get_shader();
+
+			Ref<Shader> blended_shader;
+			blended_shader.instantiate();
+			blended_shader->set_code(_shader_code_with_blend(shader->get_code(), p_blend));
+
+			Ref<ShaderMaterial> blended_material;
+			blended_material.instantiate();
+			blended_material->set_shader(blended_shader);
+
+			List<PropertyInfo> uniforms;
+			shader->get_shader_uniform_list(&uniforms);
+			for (const PropertyInfo &uniform : uniforms){
+				new_variant.parameters.push_back(uniform.name);
+			}
+
+			new_variant.material = blended_material;
+		} else if (canvas_material.is_valid()){
+			Ref<CanvasItemMaterial> blended_material = canvas_material->duplicate();
+			blended_material->set_blend_mode((CanvasItemMaterial::BlendMode)p_blend);
+			new_variant.material = blended_material;
+		} else {
+			WARN_PRINT_ONCE("HatchDrawBuffer can't apply a blend mode to this material; drawing it as registered.");
+			new_variant.material = material;
+		}
+
+		variant = &blend_variants.insert(key, new_variant)->value;
+	}
+
+	//scripts keep setting parameters on the material they registered, so mirror them every frame
+	if (not variant->parameters.is_empty()){
+		Ref<ShaderMaterial> source = material;
+		Ref<ShaderMaterial> target = variant->material;
+
+		for (const StringName &parameter : variant->parameters){
+			target->set_shader_parameter(parameter, source->get_shader_parameter(parameter));
+		}
+	}
+
+	return variant->material;
+}
+
+RID HatchDrawBuffer::_get_batch_item(uint32_t p_index){
+	RenderingServer *rs = RenderingServer::get_singleton();
+
+	while (batch_items.size() <= p_index){
+		RID item = rs->canvas_item_create();
+		rs->canvas_item_set_parent(item, get_canvas_item());
+		batch_items.push_back(item);
+	}
+
+	return batch_items[p_index];
+}
+
+void HatchDrawBuffer::_submit_batch(uint32_t p_batch, uint32_t p_from, uint32_t p_to){
+	RenderingServer *rs = RenderingServer::get_singleton();
+
+	const DrawCommand &first = commands[sort_keys[p_from] & 0xFFFFFF];
+	uint32_t quad_count = p_to - p_from;
+
+	RID item = _get_batch_item(p_batch);
+	rs->canvas_item_clear(item);
+	rs->canvas_item_set_draw_index(item, p_batch);
+
+	rs->canvas_item_set_material(item, _get_material(first.shader, first.blend)->get_rid());
+
+	Vector<Point2> points;
+	Vector<Point2> uvs;
+	Vector<Color> colors;
+	Vector<int> indices;
+
+	points.resize(quad_count * 4);
+	uvs.resize(quad_count * 4);
+	colors.resize(quad_count * 4);
+	indices.resize(quad_count * 6);
+
+	Point2 *points_ptr = points.ptrw();
+	Point2 *uvs_ptr = uvs.ptrw();
+	Color *colors_ptr = colors.ptrw();
+	int *indices_ptr = indices.ptrw();
+
+	for (uint32_t i = 0; i < quad_count; i++){
+		const DrawCommand &command = commands[sort_keys[p_from + i] & 0xFFFFFF];
+		Color color = Color::hex(command.color);
+		int base = i * 4;
+
+		for (int c = 0; c < 4; c++){
+			points_ptr[base + c] = Point2(command.x[c], command.y[c]);
+			colors_ptr[base + c] = color;
+		}
+
+		uvs_ptr[base + 0] = Point2(command.u0, command.v0);
+		uvs_ptr[base + 1] = Point2(command.u1, command.v0);
+		uvs_ptr[base + 2] = Point2(command.u1, command.v1);
+		uvs_ptr[base + 3] = Point2(command.u0, command.v1);
+
+		indices_ptr[i * 6 + 0] = base;
+		indices_ptr[i * 6 + 1] = base + 1;
+		indices_ptr[i * 6 + 2] = base + 2;
+		indices_ptr[i * 6 + 3] = base;
+		indices_ptr[i * 6 + 4] = base + 2;
+		indices_ptr[i * 6 + 5] = base + 3;
+	}
+
+	rs->canvas_item_add_triangle_array(item, indices, points, colors, uvs, Vector<int>(), Vector<float>(), frame_textures[first.texture]);
+}
+
+void HatchDrawBuffer::_flush(){
+	RenderingServer *rs = RenderingServer::get_singleton();
+
+	commands_last_frame = commands.size();
+
+	//layer | shader | blend | texture | command index, so one integer sort groups by state
+	sort_keys.resize(commands.size());
+	for (uint32_t i = 0; i < commands.size(); i++){
+		const DrawCommand &command = commands[i];
+		uint64_t key = ((uint64_t)command.layer << 56) | i;
+
+		if (sort_within_layer){
+			key |= ((uint64_t)command.shader << 48) | ((uint64_t)command.blend << 40) | ((uint64_t)command.texture << 24);
+		}
+
+		sort_keys[i] = key;
+	}
+
+	sort_keys.sort();
+
+	uint32_t batch_count = 0;
+	uint32_t run_start = 0;
+
+	for (uint32_t i = 1; i <= sort_keys.size(); i++){
+		if (i < sort_keys.size()){
+			const DrawCommand &previous = commands[sort_keys[i - 1] & 0xFFFFFF];
+			const DrawCommand &current = commands[sort_keys[i] & 0xFFFFFF];
+
+			if (previous.texture == current.texture and previous.blend == current.blend and previous.shader == current.shader){
+				continue;
+			}
+		}
+
+		_submit_batch(batch_count++, run_start, i);
+		run_start = i;
+	}
+
+	//anything left over from a busier frame draws nothing this frame
+	for (uint32_t i = batch_count; i < batch_items.size(); i++){
+		rs->canvas_item_clear(batch_items[i]);
+	}
+
+	batches_last_frame = batch_count;
+
+	clear();
+}
+
+int HatchDrawBuffer::get_command_count() const {
+	return commands.size();
+}
+
+int HatchDrawBuffer::get_batch_count() const {
+	return batches_last_frame;
+}
+
+void HatchDrawBuffer::_notification(int p_what){
+	switch (p_what) {
+		case NOTIFICATION_ENTER_TREE: {
+			RenderingServer::get_singleton()->connect(SNAME("frame_pre_draw"), callable_mp(this, &HatchDrawBuffer::_flush));
+		} break;
+
+		case NOTIFICATION_EXIT_TREE: {
+			RenderingServer::get_singleton()->disconnect(SNAME("frame_pre_draw"), callable_mp(this, &HatchDrawBuffer::_flush));
+		} break;
+	}
+}
+
+void HatchDrawBuffer::_bind_methods(){
+	ClassDB::bind_method(D_METHOD("make_active"), &HatchDrawBuffer::make_active);
+
+	ClassDB::bind_method(D_METHOD("set_layer", "layer"), &HatchDrawBuffer::set_layer);
+	ClassDB::bind_method(D_METHOD("get_layer"), &HatchDrawBuffer::get_layer);
+	ClassDB::bind_method(D_METHOD("set_blend_mode", "mode"), &HatchDrawBuffer::set_blend_mode);
+	ClassDB::bind_method(D_METHOD("get_blend_mode"), &HatchDrawBuffer::get_blend_mode);
+	ClassDB::bind_method(D_METHOD("set_shader", "shader_id"), &HatchDrawBuffer::set_shader);
+	ClassDB::bind_method(D_METHOD("get_shader"), &HatchDrawBuffer::get_shader);
+	ClassDB::bind_method(D_METHOD("set_blend_color", "color"), &HatchDrawBuffer::set_blend_color);
+	ClassDB::bind_method(D_METHOD("get_blend_color"), &HatchDrawBuffer::get_blend_color);
+	ClassDB::bind_method(D_METHOD("set_sort_within_layer", "enabled"), &HatchDrawBuffer::set_sort_within_layer);
+	ClassDB::bind_method(D_METHOD("is_sorting_within_layer"), &HatchDrawBuffer::is_sorting_within_layer);
+
+	ClassDB::bind_method(D_METHOD("register_shader", "material"), &HatchDrawBuffer::register_shader);
+	ClassDB::bind_method(D_METHOD("register_sprite", "frames"), &HatchDrawBuffer::register_sprite);
+
+	ClassDB::bind_method(D_METHOD("draw_sprite", "texture", "source", "destination", "flip_x", "flip_y"), &HatchDrawBuffer::draw_sprite, DEFVAL(false), DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("draw_sprite_transformed", "texture", "source", "xform", "flip_x", "flip_y"), &HatchDrawBuffer::draw_sprite_transformed, DEFVAL(false), DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("draw_sprite_frame", "sprite_id", "animation", "frame", "position", "flip_x", "flip_y"), &HatchDrawBuffer::draw_sprite_frame, DEFVAL(false), DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("draw_rectangle", "rect"), &HatchDrawBuffer::draw_rectangle);
+	ClassDB::bind_method(D_METHOD("draw_line_quad", "from", "to", "width"), &HatchDrawBuffer::draw_line_quad, DEFVAL(1.0));
+	ClassDB::bind_method(D_METHOD("clear"), &HatchDrawBuffer::clear);
+
+	ClassDB::bind_method(D_METHOD("get_command_count"), &HatchDrawBuffer::get_command_count);
+	ClassDB::bind_method(D_METHOD("get_batch_count"), &HatchDrawBuffer::get_batch_count);
+
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "sort_within_layer"), "set_sort_within_layer", "is_sorting_within_layer");
+
+	BIND_ENUM_CONSTANT(BLEND_MIX);
+	BIND_ENUM_CONSTANT(BLEND_ADD);
+	BIND_ENUM_CONSTANT(BLEND_SUB);
+	BIND_ENUM_CONSTANT(BLEND_MUL);
+	BIND_ENUM_CONSTANT(BLEND_PREMULT_ALPHA);
+}
+
+HatchDrawBuffer::HatchDrawBuffer(){
+	frame_textures.push_back(RID());
+
+	for (int i = 0; i < BLEND_MAX; i++){
+		blend_materials[i].instantiate();
+		blend_materials[i]->set_blend_mode((CanvasItemMaterial::BlendMode)i);
+	}
+}
+
+HatchDrawBuffer::~HatchDrawBuffer(){
+	if (active == this){
+		active = nullptr;
+	}
+
+	for (const RID &item : batch_items){
+		RenderingServer::get_singleton()->free(item);
+	}
+}
+
+/* HSL natives, drawing into whichever buffer is active */
+
+static void hsl_draw_set_blend_color(float p_r, float p_g, float p_b, float p_a) {
+	if (HatchDrawBuffer::get_active() != nullptr) {
+		HatchDrawBuffer::get_active()->set_blend_color(Color(p_r, p_g, p_b, p_a));
+	}
+}
+
+static void hsl_draw_set_blend_mode(int32_t p_mode) {
+	if (HatchDrawBuffer::get_active() != nullptr) {
+		HatchDrawBuffer::get_active()->set_blend_mode((HatchDrawBuffer::BlendMode)CLAMP(p_mode, 0, HatchDrawBuffer::BLEND_MAX - 1));
+	}
+}
+
+static void hsl_draw_set_layer(int32_t p_layer) {
+	if (HatchDrawBuffer::get_active() != nullptr) {
+		HatchDrawBuffer::get_active()->set_layer(CLAMP(p_layer, 0, HATCH_DRAW_MAX_LAYERS - 1));
+	}
+}
+
+static void hsl_draw_sprite(int32_t p_sprite, int32_t p_animation, int32_t p_frame, float p_x, float p_y, bool p_flip_x, bool p_flip_y) {
+	if (HatchDrawBuffer::get_active() != nullptr) {
+		HatchDrawBuffer::get_active()->draw_sprite_frame(p_sprite, p_animation, p_frame, Vector2(p_x, p_y), p_flip_x, p_flip_y);
+	}
+}
+
+static void hsl_draw_rectangle(float p_x, float p_y, float p_w, float p_h) {
+	if (HatchDrawBuffer::get_active() != nullptr) {
+		HatchDrawBuffer::get_active()->draw_rectangle(Rect2(p_x, p_y, p_w, p_h));
+	}
+}
+
+static void hsl_draw_line(float p_x1, float p_y1, float p_x2, float p_y2) {
+	if (HatchDrawBuffer::get_active() != nullptr) {
+		HatchDrawBuffer::get_active()->draw_line_quad(Vector2(p_x1, p_y1), Vector2(p_x2, p_y2));
+	}
+}
+
+void hatch_register_draw_natives(HSLNativeRegistry *p_registry){
+	HSL_BIND_NATIVE(p_registry, "Draw", "SetBlendColor", &hsl_draw_set_blend_color);
+	HSL_BIND_NATIVE(p_registry, "Draw", "SetBlendMode", &hsl_draw_set_blend_mode);
+	HSL_BIND_NATIVE(p_registry, "Draw", "SetLayer", &hsl_draw_set_layer);
+	HSL_BIND_NATIVE(p_registry, "Draw", "Sprite", &hsl_draw_sprite);
+	HSL_BIND_NATIVE(p_registry, "Draw", "Rectangle", &hsl_draw_rectangle);
+	HSL_BIND_NATIVE(p_registry, "Draw", "Line", &hsl_draw_line);
+}
@@ -0,0 +1,140 @@
+#ifndef HATCH_DRAW_BUFFER_H
+#define HATCH_DRAW_BUFFER_H
+
+#include "../hsl/hsl_native.h"
+
+#include "scene/2d/node_2d.h"
+#include "scene/resources/material.h"
+#include "scene/resources/sprite_frames.h"
+#include "scene/resources/texture.h"
+
+//Layers are the one thing sorting never reorders across, like Hatch draw layers
+#define HATCH_DRAW_MAX_LAYERS 256
+#define HATCH_DRAW_MAX_SHADERS 255
+#define HATCH_DRAW_MAX_SPRITES 65535
+#define HATCH_DRAW_MAX_TEXTURES 65535
+#define HATCH_DRAW_MAX_COMMANDS (1 << 24)
+
+/*
+ Immediate-mode draw calls from HSL are recorded here as POD commands for the frame. Right
+ before the frame is drawn, they are sorted by layer and render state (shader, blend mode,
+ texture), runs with the same state are merged, and each run goes to the RenderingServer as
+ a single triangle array. Thousands of sprites sharing a sheet become one draw call.
+ */
+class HatchDrawBuffer : public Node2D {
+	GDCLASS(HatchDrawBuffer, Node2D);
+
+public:
+	enum BlendMode {
+		BLEND_MIX,
+		BLEND_ADD,
+		BLEND_SUB,
+		BLEND_MUL,
+		BLEND_PREMULT_ALPHA,
+		BLEND_MAX
+	};
+
+private:
+	struct DrawCommand {
+		float x[4];
+		float y[4];
+		float u0, v0, u1, v1;
+		uint32_t color;
+		uint16_t texture;
+		uint8_t blend;
+		uint8_t shader;
+		uint8_t layer;
+	};
+
+	//a registered shader drawn with a blend mode other than mix gets its own copy with that
+	//blend in its render_mode; its parameters are copied over from the original on use
+	struct BlendVariant {
+		Ref<Material> material;
+		LocalVector<StringName> parameters;
+	};
+
+	//animations in file order, so scripts can index them like Hatch does
+	struct SpriteEntry {
+		Ref<SpriteFrames> frames;
+		LocalVector<StringName> animations;
+		LocalVector<Array> pivots;
+	};
+
+	static HatchDrawBuffer *active;
+
+	LocalVector<DrawCommand> commands;
+	LocalVector<uint64_t> sort_keys;
+
+	//slot 0 is "no texture"
+	LocalVector<RID> frame_textures;
+	HashMap<RID, uint16_t> frame_texture_slots;
+
+	Vector<Ref<Material>> shaders; //index + 1 is the shader id
+	Ref<CanvasItemMaterial> blend_materials[BLEND_MAX];
+	HashMap<uint32_t, BlendVariant> blend_variants; //shader id << 8 | blend mode
+
+	Vector<SpriteEntry> sprites; //index + 1 is the sprite id
+
+	LocalVector<RID> batch_items;
+	uint32_t batches_last_frame = 0;
+	uint32_t commands_last_frame = 0;
+
+	uint8_t current_layer = 0;
+	uint8_t current_blend = BLEND_MIX;
+	uint8_t current_shader = 0;
+	Color current_color = Color(1, 1, 1, 1);
+
+	bool sort_within_layer = true;
+
+	uint16_t _get_texture_slot(const Ref<Texture2D> &p_texture);
+	DrawCommand *_push_command(uint16_t p_texture);
+
+	Ref<Material> _get_material(uint8_t p_shader, uint8_t p_blend);
+
+	RID _get_batch_item(uint32_t p_index);
+	void _submit_batch(uint32_t p_batch, uint32_t p_from, uint32_t p_to);
+	void _flush();
+
+protected:
+	static void _bind_methods();
+	void _notification(int p_what);
+
+public:
+	static HatchDrawBuffer *get_active() { return active; }
+	void make_active();
+
+	void set_layer(int layer);
+	int get_layer() const;
+	void set_blend_mode(BlendMode mode);
+	BlendMode get_blend_mode() const;
+	void set_shader(int shader_id);
+	int get_shader() const;
+	void set_blend_color(Color color);
+	Color get_blend_color() const;
+
+	void set_sort_within_layer(bool enabled);
+	bool is_sorting_within_layer() const;
+
+	int register_shader(Ref<Material> material);
+	int register_sprite(Ref<SpriteFrames> frames);
+
+	void draw_sprite(Ref<Texture2D> texture, Rect2 source, Rect2 destination, bool flip_x = false, bool flip_y = false);
+	void draw_sprite_transformed(Ref<Texture2D> texture, Rect2 source, Transform2D xform, bool flip_x = false, bool flip_y = false);
+	void draw_sprite_frame(int sprite_id, int animation, int frame, Vector2 position, bool flip_x = false, bool flip_y = false);
+	void draw_rectangle(Rect2 rect);
+	void draw_line_quad(Vector2 from, Vector2 to, float width = 1.0);
+
+	void clear();
+
+	int get_command_count() const;
+	int get_batch_count() const;
+
+	HatchDrawBuffer();
+	~HatchDrawBuffer();
+};
+
+VARIANT_ENUM_CAST(HatchDrawBuffer::BlendMode);
+
+void hatch_register_draw_natives(HSLNativeRegistry *p_registry);
+
+#endif
@@ -0,0 +1,506 @@
+#include "hatch_archive_manifest.h"
+#include "../hatch_performance.h"
+
+#include "core/config/project_settings.h"
+#include "core/io/marshalls.h"
+#include "core/os/os.h"
+#include "core/templates/hash_map.h"
+
+#ifdef UNIX_ENABLED
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//_mm_crc32_u64 only exists on 64-bit x86; everything else takes the slicing-by-8 path
+#if defined(__SSE4_2__) && (defined(__x86_64__) || defined(_M_X64))
+#define HATCH_CRC32C_SSE42
+#include <nmmintrin.h>
+#endif
+
+//Slicing-by-8 tables for the reflected Castagnoli polynomial
+struct HatchCRC32CTable {
+	uint32_t entries[8][256];
+
+	constexpr HatchCRC32CTable() : entries() {
+		for (uint32_t i = 0; i < 256; i++){
+			uint32_t crc = i;
+			for (int j = 0; j < 8; j++){
+				crc = (crc >> 1) ^ (0x82F63B78 & (0U - (crc & 1)));
+			}
+			entries[0][i] = crc;
+		}
+
+		for (uint32_t i = 0; i < 256; i++){
+			for (int t = 1; t < 8; t++){
+				entries[t][i] = (entries[t - 1][i] >> 8) ^ entries[0][entries[t - 1][i] & 0xFF];
+			}
+		}
+	}
+};
+
+static constexpr HatchCRC32CTable crc32c_table;
+
+uint32_t hatch_crc32c(const void *p_data, size_t p_size, uint32_t p_crc){
+	const uint8_t *data = (const uint8_t *)p_data;
+	uint32_t crc = ~p_crc;
+
+#if defined(HATCH_CRC32C_SSE42)
+	uint64_t crc64 = crc;
+	while (p_size >= 8){
+		uint64_t word;
+		memcpy(&word, data, 8);
+		crc64 = _mm_crc32_u64(crc64, word);
+		data += 8;
+		p_size -= 8;
+	}
+	crc = (uint32_t)crc64;
+#elif !defined(BIG_ENDIAN_ENABLED)
+	const uint32_t(*t)[256] = crc32c_table.entries;
+	while (p_size >= 8){
+		uint64_t word;
+		memcpy(&word, data, 8);
+		word ^= crc;
+
+		crc = t[7][word & 0xFF] ^ t[6][(word >> 8) & 0xFF] ^ t[5][(word >> 16) & 0xFF] ^ t[4][(word >> 24) & 0xFF] ^
+				t[3][(word >> 32) & 0xFF] ^ t[2][(word >> 40) & 0xFF] ^ t[1][(word >> 48) & 0xFF] ^ t[0][word >> 56];
+
+		data += 8;
+		p_size -= 8;
+	}
+#endif
+
+	while (p_size > 0){
+		crc = crc32c_table.entries[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+		data++;
+		p_size--;
+	}
+
+	return ~crc;
+}
+
+//Read-only map of a whole file; stays empty where that isn't possible and callers read instead
+struct HatchMappedFile {
+	const uint8_t *data = nullptr;
+	uint64_t size = 0;
+
+	bool open(const String &p_path){
+#ifdef UNIX_ENABLED
+		//archives inside a pck or on a virtual filesystem don't exist at the global path and aren't mapped
+		CharString path = ProjectSettings::get_singleton()->globalize_path(p_path).utf8();
+
+		int fd = ::open(path.get_data(), O_RDONLY);
+		if (fd < 0){
+			return false;
+		}
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 or info.st_size <= 0){
+			::close(fd);
+			return false;
+		}
+
+		void *memory = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+
+		if (memory == MAP_FAILED){
+			return false;
+		}
+
+		madvise(memory, info.st_size, MADV_SEQUENTIAL);
+
+		data = (const uint8_t *)memory;
+		size = info.st_size;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	~HatchMappedFile(){
+#ifdef UNIX_ENABLED
+		if (data != nullptr){
+			munmap((void *)data, size);
+		}
+#endif
+	}
+};
+
+String HatchArchiveManifest::get_sidecar_path(String archive_path){
+	return archive_path + HATCH_MANIFEST_EXTENSION;
+}
+
+void HatchArchiveManifest::_hash_run(uint32_t p_index, HashBatch *p_batch){
+	const HashRun &run = p_batch->runs[p_index];
+
+	Ref<FileAccess> file;
+	LocalVector<uint8_t> buffer;
+
+	if (p_batch->mapped == nullptr){
+		//every run gets its own handle, so reads on different threads never share a seek position
+		file = FileAccess::open(p_batch->archive_path, FileAccess::ModeFlags::READ);
+		if (file.is_null()){
+			return;
+		}
+		buffer.resize(HATCH_MANIFEST_READ_CHUNK);
+	}
+
+	for (uint32_t i = run.begin; i < run.end; i++){
+		HashJob &job = p_batch->jobs[i];
+
+		uint32_t crc = 0;
+		uint64_t done = 0;
+
+		if (p_batch->mapped != nullptr){
+			if (job.offset > p_batch->mapped_size or job.size > p_batch->mapped_size - job.offset){
+				done = UINT64_MAX;
+			}
+
+			const uint8_t *payload = p_batch->mapped + job.offset;
+			while (done < job.size and not p_batch->stop.is_set()){
+				uint64_t count = MIN(job.size - done, (uint64_t)HATCH_MANIFEST_READ_CHUNK);
+				crc = hatch_crc32c(payload + done, count, crc);
+				done += count;
+			}
+		} else {
+			file->seek(job.offset);
+
+			while (done < job.size and not p_batch->stop.is_set()){
+				uint64_t count = MIN(job.size - done, (uint64_t)HATCH_MANIFEST_READ_CHUNK);
+				if (file->get_buffer(buffer.ptr(), count) != count){
+					break;
+				}
+				crc = hatch_crc32c(buffer.ptr(), count, crc);
+				done += count;
+			}
+
+			HatchPerformance::add(HatchPerformance::ARCHIVE_BYTES_READ, done);
+		}
+
+		if (p_batch->stop.is_set()){
+			return;
+		}
+
+		job.checksum = crc;
+		job.hashed = true;
+		job.read_failed = done != job.size;
+		//an entry that couldn't be read in full wasn't hashed, so it doesn't count toward the throughput
+		if (not job.read_failed){
+			p_batch->bytes_hashed.add(job.size);
+		}
+
+		if (p_batch->verifying and p_batch->stop_on_failure and (job.read_failed or job.checksum != job.expected)){
+			p_batch->stop.set();
+			return;
+		}
+	}
+}
+
+void HatchArchiveManifest::_run_batch(HashBatch &p_batch){
+	struct OffsetOrder {
+		bool operator()(const HashJob &p_a, const HashJob &p_b) const {
+			return p_a.offset < p_b.offset;
+		}
+	};
+
+	//Offset order makes every run a forward sweep over one stretch of the archive
+	p_batch.jobs.sort_custom<OffsetOrder>();
+
+	uint64_t total = 0;
+	for (const HashJob &job : p_batch.jobs){
+		total += job.size;
+	}
+
+	//a few runs per thread so a slow stretch doesn't leave the others idle at the end
+	uint64_t run_bytes = MAX(total / MAX(OS::get_singleton()->get_processor_count() * 4, 1), (uint64_t)HATCH_MANIFEST_MIN_RUN_BYTES);
+
+	HashRun run = { 0, 0 };
+	uint64_t bytes = 0;
+	for (uint32_t i = 0; i < p_batch.jobs.size(); i++){
+		bytes += p_batch.jobs[i].size;
+		run.end = i + 1;
+
+		if (bytes >= run_bytes){
+			p_batch.runs.push_back(run);
+			run.begin = run.end;
+			bytes = 0;
+		}
+	}
+	if (run.end > run.begin){
+		p_batch.runs.push_back(run);
+	}
+
+	if (p_batch.runs.is_empty()){
+		return;
+	}
+
+	HatchMappedFile mapped;
+	if (mapped.open(p_batch.archive_path)){
+		p_batch.mapped = mapped.data;
+		p_batch.mapped_size = mapped.size;
+	}
+
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(this, &HatchArchiveManifest::_hash_run, &p_batch, p_batch.runs.size(), -1, false, "Hatch archive manifest");
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+
+	p_batch.mapped = nullptr;
+}
+
+Error HatchArchiveManifest::generate(Ref<HatchArchiveReader> archive){
+	ERR_FAIL_COND_V(archive.is_null(), ERR_INVALID_PARAMETER);
+	ERR_FAIL_COND_V_MSG(archive->get_path().is_empty(), ERR_UNCONFIGURED, "No Hatch archive is loaded.");
+
+	const LocalVector<ResourceRegistryItem> &registry = archive->get_registry();
+
+	HashBatch batch;
+	batch.archive_path = archive->get_path();
+	batch.jobs.resize(registry.size());
+
+	for (uint32_t i = 0; i < registry.size(); i++){
+		HashJob &job = batch.jobs[i];
+		job.entry = i;
+		job.offset = registry[i].offset;
+		job.size = registry[i].compressed_size;
+		job.expected = 0;
+		job.checksum = 0;
+		job.hashed = false;
+		job.read_failed = false;
+	}
+
+	_run_batch(batch);
+
+	LocalVector<Entry> made;
+	made.resize(registry.size());
+
+	for (const HashJob &job : batch.jobs){
+		const ResourceRegistryItem &item = registry[job.entry];
+		ERR_FAIL_COND_V_MSG(not job.hashed or job.read_failed, ERR_FILE_CORRUPT, vformat("Could not read Hatch archive entry %08x to checksum it.", item.crc32));
+
+		Entry &entry = made[job.entry];
+		entry.crc32 = item.crc32;
+		entry.data_flag = item.data_flag;
+		entry.offset = item.offset;
+		entry.size = item.size;
+		entry.compressed_size = item.compressed_size;
+		entry.checksum = job.checksum;
+	}
+
+	Ref<FileAccess> file = FileAccess::open(batch.archive_path, FileAccess::ModeFlags::READ);
+	archive_length = file.is_valid() ? file->get_length() : 0;
+	entries = made;
+
+	return OK;
+}
+
+Dictionary HatchArchiveManifest::verify(Ref<HatchArchiveReader> archive, bool stop_on_failure, Ref<HatchArchiveManifest> verified){
+	Dictionary result;
+	ERR_FAIL_COND_V(archive.is_null(), result);
+	ERR_FAIL_COND_V_MSG(archive->get_path().is_empty(), result, "No Hatch archive is loaded.");
+
+	uint64_t start_usec = OS::get_singleton()->get_ticks_usec();
+
+	HashMap<uint32_t, uint32_t> by_name;
+	for (uint32_t i = 0; i < entries.size(); i++){
+		//a collided name only has its first entry reachable, same as the archive index
+		if (not by_name.has(entries[i].crc32)){
+			by_name.insert(entries[i].crc32, i);
+		}
+	}
+
+	//entries an earlier, already verified manifest vouches for, by name hash
+	HashMap<uint32_t, const Entry *> trusted;
+	if (verified.is_valid()){
+		for (const Entry &entry : verified->entries){
+			if (not trusted.has(entry.crc32)){
+				trusted.insert(entry.crc32, &entry);
+			}
+		}
+	}
+
+	PackedInt64Array failed;
+	PackedInt64Array unlisted;
+	LocalVector<bool> seen;
+	seen.resize(entries.size());
+	for (uint32_t i = 0; i < entries.size(); i++){
+		seen[i] = false;
+	}
+
+	HashBatch batch;
+	batch.archive_path = archive->get_path();
+	batch.verifying = true;
+	batch.stop_on_failure = stop_on_failure;
+
+	uint32_t skipped = 0;
+
+	for (const ResourceRegistryItem &item : archive->get_registry()){
+		const uint32_t *index = by_name.getptr(item.crc32);
+		if (index == nullptr){
+			unlisted.push_back(item.crc32);
+			continue;
+		}
+
+		const Entry &entry = entries[*index];
+		if (seen[*index]){
+			continue;
+		}
+		seen[*index] = true;
+
+		//the TOC itself no longer matches what the manifest was made from
+		if (not entry.same_record(item)){
+			failed.push_back(item.crc32);
+			continue;
+		}
+
+		const Entry **previous = trusted.getptr(item.crc32);
+		if (previous != nullptr and (*previous)->same_record(item) and (*previous)->checksum == entry.checksum){
+			skipped++;
+			continue;
+		}
+
+		HashJob job;
+		job.entry = *index;
+		job.offset = item.offset;
+		job.size = item.compressed_size;
+		job.expected = entry.checksum;
+		job.checksum = 0;
+		job.hashed = false;
+		job.read_failed = false;
+		batch.jobs.push_back(job);
+	}
+
+	PackedInt64Array missing;
+	for (uint32_t i = 0; i < entries.size(); i++){
+		if (not seen[i] and by_name[entries[i].crc32] == i){
+			missing.push_back(entries[i].crc32);
+		}
+	}
+
+	//an archive that grew or shrank was rebuilt or truncated, even if every listed entry still reads
+	Ref<FileAccess> file = FileAccess::open(batch.archive_path, FileAccess::ModeFlags::READ);
+	uint64_t length = file.is_valid() ? file->get_length() : 0;
+	file.unref();
+	bool length_ok = archive_length == 0 or length == archive_length;
+
+	bool stopped = false;
+	uint32_t checked = 0;
+
+	if (stop_on_failure and not (failed.is_empty() and missing.is_empty() and unlisted.is_empty() and length_ok)){
+		stopped = not batch.jobs.is_empty();
+	} else {
+		_run_batch(batch);
+		stopped = batch.stop.is_set();
+
+		for (const HashJob &job : batch.jobs){
+			if (not job.hashed){
+				//never reached before the stop; without one, the archive couldn't be read at all
+				if (not stopped){
+					failed.push_back(entries[job.entry].crc32);
+				}
+				continue;
+			}
+
+			checked++;
+			if (job.read_failed or job.checksum != job.expected){
+				failed.push_back(entries[job.entry].crc32);
+			}
+		}
+	}
+
+	double seconds = (OS::get_singleton()->get_ticks_usec() - start_usec) / 1000000.0;
+	uint64_t bytes_hashed = batch.bytes_hashed.get();
+
+	result["ok"] = failed.is_empty() and missing.is_empty() and unlisted.is_empty() and length_ok and not stopped;
+	result["checked"] = checked;
+	result["skipped"] = skipped;
+	result["failed"] = failed;
+	result["missing"] = missing;
+	result["unlisted"] = unlisted;
+	result["length_ok"] = length_ok;
+	result["stopped"] = stopped;
+	result["bytes_hashed"] = bytes_hashed;
+	result["seconds"] = seconds;
+	result["mb_per_second"] = seconds > 0.0 ? (bytes_hashed / (1024.0 * 1024.0)) / seconds : 0.0;
+
+	return result;
+}
+
+Error HatchArchiveManifest::save(String path) const {
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::ModeFlags::WRITE);
+	ERR_FAIL_COND_V_MSG(file.is_null(), ERR_FILE_CANT_WRITE, "Could not write Hatch archive manifest to \"" + path + "\".");
+
+	file->store_buffer((const uint8_t *)HATCH_MANIFEST_MAGIC, 4);
+	file->store_32(HATCH_MANIFEST_VERSION);
+	file->store_32(entries.size());
+	file->store_64(archive_length);
+
+	for (const Entry &entry : entries){
+		file->store_32(entry.crc32);
+		file->store_64(entry.offset);
+		file->store_64(entry.size);
+		file->store_32(entry.data_flag);
+		file->store_64(entry.compressed_size);
+		file->store_32(entry.checksum);
+	}
+
+	return OK;
+}
+
+Error HatchArchiveManifest::load(String path){
+	Error err = OK;
+	PackedByteArray data = FileAccess::get_file_as_bytes(path, &err);
+	if (err != OK){
+		return err;
+	}
+
+	ERR_FAIL_COND_V_MSG(data.size() < HATCH_MANIFEST_HEADER_SIZE or memcmp(data.ptr(), HATCH_MANIFEST_MAGIC, 4) != 0, ERR_FILE_UNRECOGNIZED, "\"" + path + "\" is not a Hatch archive manifest.");
+	ERR_FAIL_COND_V_MSG(decode_uint32(data.ptr() + 4) != HATCH_MANIFEST_VERSION, ERR_FILE_UNRECOGNIZED, "Unsupported Hatch archive manifest version in \"" + path + "\".");
+
+	uint32_t count = decode_uint32(data.ptr() + 8);
+	ERR_FAIL_COND_V_MSG((uint64_t)count * HATCH_MANIFEST_RECORD_SIZE != (uint64_t)data.size() - HATCH_MANIFEST_HEADER_SIZE, ERR_FILE_CORRUPT, "Hatch archive manifest \"" + path + "\" is truncated.");
+
+	archive_length = decode_uint64(data.ptr() + 12);
+	entries.resize(count);
+
+	const uint8_t *record = data.ptr() + HATCH_MANIFEST_HEADER_SIZE;
+	for (uint32_t i = 0; i < count; i++){
+		Entry &entry = entries[i];
+		entry.crc32 = decode_uint32(record);
+		entry.offset = decode_uint64(record + 4);
+		entry.size = decode_uint64(record + 12);
+		entry.data_flag = decode_uint32(record + 20);
+		entry.compressed_size = decode_uint64(record + 24);
+		entry.checksum = decode_uint32(record + 32);
+
+		record += HATCH_MANIFEST_RECORD_SIZE;
+	}
+
+	return OK;
+}
+
+int HatchArchiveManifest::get_entry_count() const {
+	return entries.size();
+}
+
+int64_t HatchArchiveManifest::get_checksum(uint32_t hash) const {
+	for (const Entry &entry : entries){
+		if (entry.crc32 == hash){
+			return entry.checksum;
+		}
+	}
+
+	return -1;
+}
+
+void HatchArchiveManifest::_bind_methods(){
+	ClassDB::bind_static_method("HatchArchiveManifest", D_METHOD("get_sidecar_path", "archive_path"), &HatchArchiveManifest::get_sidecar_path);
+
+	ClassDB::bind_method(D_METHOD("generate", "archive"), &HatchArchiveManifest::generate);
+	ClassDB::bind_method(D_METHOD("verify", "archive", "stop_on_failure", "verified"), &HatchArchiveManifest::verify, DEFVAL(false), DEFVAL(Ref<HatchArchiveManifest>()));
+
+	ClassDB::bind_method(D_METHOD("save", "path"), &HatchArchiveManifest::save);
+	ClassDB::bind_method(D_METHOD("load", "path"), &HatchArchiveManifest::load);
+
+	ClassDB::bind_method(D_METHOD("get_entry_count"), &HatchArchiveManifest::get_entry_count);
+	ClassDB::bind_method(D_METHOD("get_checksum", "hash"), &HatchArchiveManifest::get_checksum);
+}
@@ -0,0 +1,106 @@
+#ifndef HATCH_ARCHIVE_MANIFEST_H
+#define HATCH_ARCHIVE_MANIFEST_H
+
+#include "hatch_archive_reader.h"
+
+#include "core/templates/safe_refcount.h"
+
+#define HATCH_MANIFEST_MAGIC "HMAN"
+#define HATCH_MANIFEST_VERSION 1
+#define HATCH_MANIFEST_EXTENSION ".manifest"
+
+//magic + version + entry count + archive length
+#define HATCH_MANIFEST_HEADER_SIZE 20
+//the TOC record it was made from (name crc, offset, size, flag, compressed size) + payload crc32c
+#define HATCH_MANIFEST_RECORD_SIZE 36
+
+//Workers are handed runs of neighbouring entries at least this large, so each reads sequentially
+#define HATCH_MANIFEST_MIN_RUN_BYTES (8 * 1024 * 1024)
+//Read size when the archive can't be memory mapped
+#define HATCH_MANIFEST_READ_CHUNK (1024 * 1024)
+
+//CRC32C (Castagnoli), hardware accelerated where the build targets SSE4.2 on x86-64
+uint32_t hatch_crc32c(const void *p_data, size_t p_size, uint32_t p_crc = 0);
+
+/*
+ Payload checksums for a .hatch archive, kept in a sidecar file next to it (Data.hatch and
+ Data.hatch.manifest), since the TOC only has name hashes. Checksums cover the payload bytes
+ as stored, so verifying never inflates or decrypts anything.
+
+ Generating and verifying hash entries in offset order, split into runs across the worker
+ pool, reading through a memory map where the platform has one. Verification can stop at the
+ first bad entry, and can be limited to entries that changed since a manifest that was
+ already verified, such as the one from before a patch was applied.
+ */
+class HatchArchiveManifest : public RefCounted {
+	GDCLASS(HatchArchiveManifest, RefCounted);
+
+	struct Entry {
+		uint32_t crc32;
+		uint32_t data_flag;
+		uint64_t offset;
+		uint64_t size;
+		uint64_t compressed_size;
+		uint32_t checksum;
+
+		bool same_record(const ResourceRegistryItem &p_item) const {
+			return crc32 == p_item.crc32 and data_flag == p_item.data_flag and offset == p_item.offset and size == p_item.size and compressed_size == p_item.compressed_size;
+		}
+	};
+
+	struct HashJob {
+		uint32_t entry; //index into the entries being hashed or checked
+		uint64_t offset;
+		uint64_t size;
+		uint32_t expected;
+		uint32_t checksum;
+		bool hashed; //reached before any stop
+		bool read_failed;
+	};
+
+	struct HashRun {
+		uint32_t begin;
+		uint32_t end;
+	};
+
+	struct HashBatch {
+		String archive_path;
+		const uint8_t *mapped = nullptr;
+		uint64_t mapped_size = 0;
+
+		LocalVector<HashJob> jobs; //offset order
+		LocalVector<HashRun> runs;
+
+		bool verifying = false;
+		bool stop_on_failure = false;
+		SafeFlag stop;
+		SafeNumeric<uint64_t> bytes_hashed;
+	};
+
+	LocalVector<Entry> entries; //TOC order
+	uint64_t archive_length = 0;
+
+	void _hash_run(uint32_t p_index, HashBatch *p_batch);
+	void _run_batch(HashBatch &p_batch);
+
+protected:
+	static void _bind_methods();
+
+public:
+	static String get_sidecar_path(String archive_path);
+
+	Error generate(Ref<HatchArchiveReader> archive);
+	//Keys: ok, checked, skipped, failed, missing, unlisted, length_ok, stopped, bytes_hashed, seconds, mb_per_second
+	Dictionary verify(Ref<HatchArchiveReader> archive, bool stop_on_failure = false, Ref<HatchArchiveManifest> verified = Ref<HatchArchiveManifest>());
+
+	Error save(String path) const;
+	Error load(String path);
+
+	int get_entry_count() const;
+	//The payload checksum for a name hash, or -1
+	int64_t get_checksum(uint32_t hash) const;
+	//By TOC index, for a manifest generated from the archive at hand
+	uint32_t get_checksum_at(uint32_t p_index) const { return p_index < entries.size() ? entries[p_index].checksum : 0; }
+};
+
+#endif
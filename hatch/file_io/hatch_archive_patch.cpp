@@ -0,0 +1,572 @@
+#include "hatch_archive_patch.h"
+#include "hatch_archive_manifest.h"
+
+#include "core/config/project_settings.h"
+#include "core/io/dir_access.h"
+#include "core/io/marshalls.h"
+#include "core/os/os.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/hash_set.h"
+
+//Candidates checked per position, so runs of identical blocks (padding, silence) stay linear
+#define HATCH_PATCH_MAX_CANDIDATES 64
+
+static void _put_varint(LocalVector<uint8_t> &r_out, uint64_t p_value){
+	while (p_value >= 0x80){
+		r_out.push_back((p_value & 0x7F) | 0x80);
+		p_value >>= 7;
+	}
+	r_out.push_back(p_value);
+}
+
+static uint64_t _get_varint(const Ref<FileAccess> &p_file){
+	uint64_t value = 0;
+	for (int shift = 0; shift < 64; shift += 7){
+		uint8_t byte = p_file->get_8();
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if (not (byte & 0x80) or p_file->eof_reached()){
+			break;
+		}
+	}
+	return value;
+}
+
+//Copies p_size bytes from wherever p_from is to p_to, returning how many made it across
+static uint64_t _stream(const Ref<FileAccess> &p_from, uint64_t p_size, const Ref<FileAccess> &p_to, LocalVector<uint8_t> &r_buffer, uint32_t *r_crc){
+	uint64_t done = 0;
+
+	while (done < p_size){
+		uint64_t count = MIN(p_size - done, (uint64_t)r_buffer.size());
+		uint64_t read = p_from->get_buffer(r_buffer.ptr(), count);
+
+		p_to->store_buffer(r_buffer.ptr(), read);
+		if (r_crc != nullptr){
+			*r_crc = hatch_crc32c(r_buffer.ptr(), read, *r_crc);
+		}
+
+		done += read;
+		if (read != count){
+			break;
+		}
+	}
+
+	return done;
+}
+
+Error HatchArchivePatch::_read_header_and_toc(const String &p_path, PackedByteArray &r_bytes){
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::ModeFlags::READ);
+	ERR_FAIL_COND_V_MSG(file.is_null(), ERR_FILE_CANT_OPEN, "Could not open Hatch archive at " + p_path);
+
+	HatchArchiveHeader header;
+	ERR_FAIL_COND_V_MSG(not HatchArchiveReader::read_header(file, header), ERR_FILE_UNRECOGNIZED, "File is not a Hatch archive: " + p_path);
+
+	uint64_t size = file->get_position() + (uint64_t)header.file_count * HATCH_TOC_RECORD_SIZE;
+	ERR_FAIL_COND_V(size > file->get_length(), ERR_FILE_CORRUPT);
+
+	file->seek(0);
+	r_bytes = file->get_buffer(size);
+	return OK;
+}
+
+void HatchArchivePatch::_build_delta(const PackedByteArray &p_old, const PackedByteArray &p_new, uint32_t p_block_size, LocalVector<uint8_t> &r_ops){
+	const uint8_t *old_data = p_old.ptr();
+	const uint8_t *new_data = p_new.ptr();
+	uint64_t old_size = p_old.size();
+	uint64_t new_size = p_new.size();
+	uint32_t block_count = old_size / p_block_size;
+
+	//weak rolling checksum of every whole old block, chained for blocks that share one
+	HashMap<uint32_t, uint32_t> first_block;
+	LocalVector<uint32_t> next_block;
+	next_block.resize(block_count);
+
+	for (uint32_t block = block_count; block > 0; block--){
+		const uint8_t *bytes = old_data + (uint64_t)(block - 1) * p_block_size;
+		uint32_t a = 0;
+		uint32_t b = 0;
+		for (uint32_t i = 0; i < p_block_size; i++){
+			a += bytes[i];
+			b += (p_block_size - i) * bytes[i];
+		}
+		uint32_t weak = (a & 0xFFFF) | (b << 16);
+
+		uint32_t *head = first_block.getptr(weak);
+		next_block[block - 1] = head ? *head : UINT32_MAX;
+		first_block[weak] = block - 1;
+	}
+
+	uint64_t literal_start = 0;
+	uint64_t copy_start = 0;
+	uint64_t copy_count = 0;
+
+	auto flush_literal = [&](uint64_t p_end) {
+		if (p_end > literal_start){
+			r_ops.push_back(OP_LITERAL);
+			_put_varint(r_ops, p_end - literal_start);
+
+			uint32_t offset = r_ops.size();
+			r_ops.resize(offset + (p_end - literal_start));
+			memcpy(r_ops.ptr() + offset, new_data + literal_start, p_end - literal_start);
+		}
+	};
+
+	auto flush_copy = [&]() {
+		if (copy_count > 0){
+			r_ops.push_back(OP_COPY);
+			_put_varint(r_ops, copy_start);
+			_put_varint(r_ops, copy_count);
+			copy_count = 0;
+		}
+	};
+
+	uint64_t pos = 0;
+	uint32_t a = 0;
+	uint32_t b = 0;
+	bool rolled = false;
+
+	while (block_count > 0 and pos + p_block_size <= new_size){
+		if (not rolled){
+			a = 0;
+			b = 0;
+			for (uint32_t i = 0; i < p_block_size; i++){
+				a += new_data[pos + i];
+				b += (p_block_size - i) * new_data[pos + i];
+			}
+			rolled = true;
+		}
+
+		uint32_t match = UINT32_MAX;
+		const uint32_t *candidate = first_block.getptr((a & 0xFFFF) | (b << 16));
+
+		//the old payload is right here, so candidates are confirmed byte for byte instead of by a strong hash
+		uint32_t checked = 0;
+		for (uint32_t block = candidate ? *candidate : UINT32_MAX; block != UINT32_MAX and checked < HATCH_PATCH_MAX_CANDIDATES; block = next_block[block], checked++){
+			if (memcmp(old_data + (uint64_t)block * p_block_size, new_data + pos, p_block_size) == 0){
+				match = block;
+				//prefer the block that continues the current copy
+				if (copy_count > 0 and block == copy_start + copy_count){
+					break;
+				}
+			}
+		}
+
+		if (match != UINT32_MAX){
+			if (pos > literal_start){
+				flush_copy();
+				flush_literal(pos);
+			}
+
+			if (copy_count > 0 and match != copy_start + copy_count){
+				flush_copy();
+			}
+			if (copy_count == 0){
+				copy_start = match;
+			}
+			copy_count++;
+
+			pos += p_block_size;
+			literal_start = pos;
+			rolled = false;
+			continue;
+		}
+
+		if (pos + p_block_size >= new_size){
+			break;
+		}
+
+		uint8_t out = new_data[pos];
+		uint8_t in = new_data[pos + p_block_size];
+		a = a - out + in;
+		b = b - p_block_size * out + a;
+		pos++;
+	}
+
+	if (new_size > literal_start){
+		flush_copy();
+		flush_literal(new_size);
+	}
+	flush_copy();
+}
+
+Dictionary HatchArchivePatch::create(Ref<HatchArchiveReader> old_archive, Ref<HatchArchiveReader> new_archive, String patch_path){
+	Dictionary result;
+	result["ok"] = false;
+
+	ERR_FAIL_COND_V(old_archive.is_null() or new_archive.is_null(), result);
+	ERR_FAIL_COND_V_MSG(old_archive->get_path().is_empty() or new_archive->get_path().is_empty(), result, "Both Hatch archives have to be loaded.");
+
+	//checksums for both sides first, hashed in parallel, so unchanged entries are never read again
+	Ref<HatchArchiveManifest> old_manifest;
+	old_manifest.instantiate();
+	Ref<HatchArchiveManifest> new_manifest;
+	new_manifest.instantiate();
+	ERR_FAIL_COND_V(old_manifest->generate(old_archive) != OK, result);
+	ERR_FAIL_COND_V(new_manifest->generate(new_archive) != OK, result);
+
+	PackedByteArray old_toc;
+	ERR_FAIL_COND_V(_read_header_and_toc(old_archive->get_path(), old_toc) != OK, result);
+
+	Ref<FileAccess> old_file = FileAccess::open(old_archive->get_path(), FileAccess::ModeFlags::READ);
+	Ref<FileAccess> new_file = FileAccess::open(new_archive->get_path(), FileAccess::ModeFlags::READ);
+	ERR_FAIL_COND_V(old_file.is_null() or new_file.is_null(), result);
+
+	HatchArchiveHeader new_header;
+	ERR_FAIL_COND_V(not HatchArchiveReader::read_header(new_file, new_header), result);
+
+	Ref<FileAccess> out = FileAccess::open(patch_path, FileAccess::ModeFlags::WRITE);
+	ERR_FAIL_COND_V_MSG(out.is_null(), result, "Could not write Hatch archive patch to \"" + patch_path + "\".");
+
+	const LocalVector<ResourceRegistryItem> &old_items = old_archive->get_registry();
+	const LocalVector<ResourceRegistryItem> &new_items = new_archive->get_registry();
+
+	out->store_buffer((const uint8_t *)HATCH_PATCH_MAGIC, 4);
+	out->store_32(HATCH_PATCH_VERSION);
+	out->store_32(block_size);
+	out->store_64(old_file->get_length());
+	out->store_32(hatch_crc32c(old_toc.ptr(), old_toc.size()));
+	out->store_64(new_file->get_length());
+	out->store_8(new_header.major);
+	out->store_8(new_header.minor);
+	out->store_8(new_header.patch);
+	out->store_8(0);
+	out->store_32(new_items.size());
+
+	for (const ResourceRegistryItem &item : new_items){
+		out->store_32(item.crc32);
+		out->store_64(item.offset);
+		out->store_64(item.size);
+		out->store_32(item.data_flag);
+		out->store_64(item.compressed_size);
+	}
+
+	HashMap<uint32_t, uint32_t> old_by_name;
+	for (uint32_t i = 0; i < old_items.size(); i++){
+		if (not old_by_name.has(old_items[i].crc32)){
+			old_by_name.insert(old_items[i].crc32, i);
+		}
+	}
+
+	HashSet<uint32_t> new_names;
+	for (const ResourceRegistryItem &item : new_items){
+		new_names.insert(item.crc32);
+	}
+
+	LocalVector<uint32_t> removed;
+	for (const KeyValue<uint32_t, uint32_t> &E : old_by_name){
+		if (not new_names.has(E.key)){
+			removed.push_back(E.key);
+		}
+	}
+
+	out->store_32(removed.size());
+	for (uint32_t hash : removed){
+		out->store_32(hash);
+	}
+
+	struct OffsetIndex {
+		uint64_t offset;
+		uint32_t index;
+
+		bool operator<(const OffsetIndex &p_other) const {
+			return offset < p_other.offset;
+		}
+	};
+
+	//bodies go in the order the applier writes payloads
+	LocalVector<OffsetIndex> order;
+	order.resize(new_items.size());
+	for (uint32_t i = 0; i < new_items.size(); i++){
+		order[i] = { new_items[i].offset, i };
+	}
+	order.sort();
+
+	LocalVector<uint8_t> buffer;
+	buffer.resize(HATCH_PATCH_COPY_CHUNK);
+	LocalVector<uint8_t> ops;
+
+	uint32_t unchanged = 0;
+	uint32_t added = 0;
+	uint32_t modified = 0;
+
+	for (const OffsetIndex &entry : order){
+		const ResourceRegistryItem &item = new_items[entry.index];
+		uint32_t checksum = new_manifest->get_checksum_at(entry.index);
+
+		out->store_32(entry.index);
+
+		const uint32_t *old_index = old_by_name.getptr(item.crc32);
+
+		if (old_index != nullptr and old_manifest->get_checksum_at(*old_index) == checksum and old_items[*old_index].compressed_size == item.compressed_size){
+			out->store_8(ENTRY_UNCHANGED);
+			out->store_32(checksum);
+			out->store_32(*old_index);
+			unchanged++;
+			continue;
+		}
+
+		if (old_index == nullptr){
+			out->store_8(ENTRY_LITERAL);
+			out->store_32(checksum);
+			new_file->seek(item.offset);
+			_stream(new_file, item.compressed_size, out, buffer, nullptr);
+			added++;
+			continue;
+		}
+
+		const ResourceRegistryItem &old_item = old_items[*old_index];
+
+		old_file->seek(old_item.offset);
+		PackedByteArray old_payload = old_file->get_buffer(old_item.compressed_size);
+		new_file->seek(item.offset);
+		PackedByteArray new_payload = new_file->get_buffer(item.compressed_size);
+
+		ops.clear();
+		_build_delta(old_payload, new_payload, block_size, ops);
+
+		//a delta of a recompressed entry can come out larger than the entry itself
+		if (ops.size() < new_payload.size()){
+			out->store_8(ENTRY_DELTA);
+			out->store_32(checksum);
+			out->store_32(*old_index);
+			out->store_64(ops.size());
+			out->store_buffer(ops.ptr(), ops.size());
+		} else {
+			out->store_8(ENTRY_LITERAL);
+			out->store_32(checksum);
+			out->store_buffer(new_payload.ptr(), new_payload.size());
+		}
+
+		modified++;
+	}
+
+	result["ok"] = true;
+	result["unchanged"] = unchanged;
+	result["added"] = added;
+	result["modified"] = modified;
+	result["removed"] = removed.size();
+	result["patch_bytes"] = out->get_position();
+
+	return result;
+}
+
+Dictionary HatchArchivePatch::apply(String old_archive_path, String patch_path, String out_path){
+	Dictionary result;
+	result["ok"] = false;
+
+	uint64_t start_usec = OS::get_singleton()->get_ticks_usec();
+
+	//the old archive and the patch are streamed from while the output is written
+	String out_absolute = ProjectSettings::get_singleton()->globalize_path(out_path).simplify_path();
+	ERR_FAIL_COND_V_MSG(out_absolute == ProjectSettings::get_singleton()->globalize_path(old_archive_path).simplify_path(), result, "A Hatch archive can't be patched in place; write the patched archive to a new file.");
+	ERR_FAIL_COND_V_MSG(out_absolute == ProjectSettings::get_singleton()->globalize_path(patch_path).simplify_path(), result, "The patched Hatch archive can't overwrite the patch.");
+
+	Ref<HatchArchiveReader> old_archive;
+	old_archive.instantiate();
+	old_archive->load(old_archive_path);
+	ERR_FAIL_COND_V_MSG(old_archive->get_path().is_empty(), result, "Could not load the Hatch archive to patch.");
+
+	Ref<FileAccess> patch = FileAccess::open(patch_path, FileAccess::ModeFlags::READ);
+	ERR_FAIL_COND_V_MSG(patch.is_null(), result, "Could not open Hatch archive patch \"" + patch_path + "\".");
+
+	uint8_t magic[4];
+	patch->get_buffer(magic, 4);
+	ERR_FAIL_COND_V_MSG(memcmp(magic, HATCH_PATCH_MAGIC, 4) != 0, result, "\"" + patch_path + "\" is not a Hatch archive patch.");
+	ERR_FAIL_COND_V_MSG(patch->get_32() != HATCH_PATCH_VERSION, result, "Unsupported Hatch archive patch version.");
+
+	uint32_t patch_block_size = patch->get_32();
+	uint64_t old_length = patch->get_64();
+	uint32_t old_toc_checksum = patch->get_32();
+	uint64_t new_length = patch->get_64();
+
+	Ref<FileAccess> old_file = FileAccess::open(old_archive_path, FileAccess::ModeFlags::READ);
+	ERR_FAIL_COND_V(old_file.is_null(), result);
+
+	PackedByteArray old_toc;
+	ERR_FAIL_COND_V(_read_header_and_toc(old_archive_path, old_toc) != OK, result);
+	ERR_FAIL_COND_V_MSG(old_file->get_length() != old_length or hatch_crc32c(old_toc.ptr(), old_toc.size()) != old_toc_checksum, result, "This patch was made for a different version of the Hatch archive.");
+
+	HatchArchiveHeader header;
+	header.major = patch->get_8();
+	header.minor = patch->get_8();
+	header.patch = patch->get_8();
+	patch->get_8();
+	header.file_count = patch->get_32();
+
+	ERR_FAIL_COND_V_MSG(header.major < HATCH_ARCHIVE_WIDE_TOC_MAJOR and header.file_count > UINT16_MAX, result, "Hatch archive patch has too many entries for its archive version.");
+
+	PackedByteArray toc = patch->get_buffer((uint64_t)header.file_count * HATCH_TOC_RECORD_SIZE);
+	ERR_FAIL_COND_V_MSG((uint64_t)toc.size() != (uint64_t)header.file_count * HATCH_TOC_RECORD_SIZE, result, "Hatch archive patch is truncated.");
+
+	LocalVector<ResourceRegistryItem> new_items;
+	new_items.resize(header.file_count);
+	for (uint32_t i = 0; i < header.file_count; i++){
+		const uint8_t *record = toc.ptr() + (uint64_t)i * HATCH_TOC_RECORD_SIZE;
+		ResourceRegistryItem &item = new_items[i];
+		item.crc32 = decode_uint32(record);
+		item.offset = decode_uint64(record + 4);
+		item.size = decode_uint64(record + 12);
+		item.data_flag = decode_uint32(record + 20);
+		item.compressed_size = decode_uint64(record + 24);
+	}
+
+	uint32_t removed = patch->get_32();
+	patch->seek(patch->get_position() + (uint64_t)removed * 4);
+
+	Ref<FileAccess> out = FileAccess::open(out_path, FileAccess::ModeFlags::WRITE);
+	ERR_FAIL_COND_V_MSG(out.is_null(), result, "Could not write the patched Hatch archive to \"" + out_path + "\".");
+
+	out->store_buffer((const uint8_t *)"HATCH", 5);
+	out->store_8(header.major);
+	out->store_8(header.minor);
+	out->store_8(header.patch);
+	if (header.major >= HATCH_ARCHIVE_WIDE_TOC_MAJOR){
+		out->store_32(header.file_count);
+	} else {
+		out->store_16(header.file_count);
+	}
+	out->store_buffer(toc.ptr(), toc.size());
+
+	const LocalVector<ResourceRegistryItem> &old_items = old_archive->get_registry();
+
+	LocalVector<uint8_t> buffer;
+	buffer.resize(HATCH_PATCH_COPY_CHUNK);
+
+	PackedInt64Array failed;
+	bool corrupt = false;
+
+	for (uint32_t n = 0; n < header.file_count and not corrupt; n++){
+		uint32_t index = patch->get_32();
+		EntryKind kind = (EntryKind)patch->get_8();
+		uint32_t expected = patch->get_32();
+
+		if (patch->eof_reached() or index >= new_items.size()){
+			corrupt = true;
+			break;
+		}
+
+		const ResourceRegistryItem &item = new_items[index];
+
+		//payloads are written in offset order; any gap between them is zero filled
+		uint64_t position = out->get_position();
+		if (position > item.offset){
+			corrupt = true;
+			break;
+		}
+		while (position < item.offset){
+			uint64_t count = MIN(item.offset - position, (uint64_t)buffer.size());
+			memset(buffer.ptr(), 0, count);
+			out->store_buffer(buffer.ptr(), count);
+			position += count;
+		}
+
+		uint32_t crc = 0;
+		uint64_t written = 0;
+
+		switch (kind){
+			case ENTRY_UNCHANGED: {
+				uint32_t old_index = patch->get_32();
+				if (old_index >= old_items.size()){
+					corrupt = true;
+					break;
+				}
+
+				old_file->seek(old_items[old_index].offset);
+				written = _stream(old_file, MIN(item.compressed_size, old_items[old_index].compressed_size), out, buffer, &crc);
+			} break;
+			case ENTRY_LITERAL: {
+				written = _stream(patch, item.compressed_size, out, buffer, &crc);
+			} break;
+			case ENTRY_DELTA: {
+				uint32_t old_index = patch->get_32();
+				uint64_t ops_end = patch->get_64();
+				if (old_index >= old_items.size()){
+					corrupt = true;
+					break;
+				}
+				ops_end += patch->get_position();
+
+				const ResourceRegistryItem &old_item = old_items[old_index];
+
+				while (patch->get_position() < ops_end and not patch->eof_reached()){
+					uint8_t op = patch->get_8();
+
+					if (op == OP_COPY){
+						uint64_t from = _get_varint(patch) * patch_block_size;
+						uint64_t count = _get_varint(patch) * patch_block_size;
+						if (from > old_item.compressed_size or count > old_item.compressed_size - from){
+							corrupt = true;
+							break;
+						}
+
+						old_file->seek(old_item.offset + from);
+						written += _stream(old_file, count, out, buffer, &crc);
+					} else if (op == OP_LITERAL){
+						written += _stream(patch, _get_varint(patch), out, buffer, &crc);
+					} else {
+						corrupt = true;
+						break;
+					}
+				}
+			} break;
+			default:
+				corrupt = true;
+				break;
+		}
+
+		if (not corrupt and (written != item.compressed_size or crc != expected)){
+			failed.push_back(item.crc32);
+		}
+	}
+
+	//the output was opened for writing, so it is only as long as what went into it; pad out
+	//whatever followed the last payload and make sure nothing ran past the new archive's end
+	if (not corrupt){
+		uint64_t position = out->get_position();
+		if (position > new_length){
+			corrupt = true;
+		}
+		while (position < new_length){
+			uint64_t count = MIN(new_length - position, (uint64_t)buffer.size());
+			memset(buffer.ptr(), 0, count);
+			out->store_buffer(buffer.ptr(), count);
+			position += count;
+		}
+	}
+
+	uint64_t bytes_written = out->get_position();
+	out.unref();
+
+	if (corrupt or not failed.is_empty()){
+		DirAccess::remove_absolute(out_path);
+		ERR_FAIL_COND_V_MSG(corrupt, result, "Hatch archive patch is corrupt.");
+
+		result["failed"] = failed;
+		ERR_FAIL_V_MSG(result, vformat("%d entries didn't match their checksum after patching.", failed.size()));
+	}
+
+	result["ok"] = true;
+	result["entries"] = header.file_count;
+	result["bytes_written"] = bytes_written;
+	result["seconds"] = (OS::get_singleton()->get_ticks_usec() - start_usec) / 1000000.0;
+
+	return result;
+}
+
+void HatchArchivePatch::set_block_size(int size){
+	ERR_FAIL_COND_MSG(size < 64, "Patch blocks have to be at least 64 bytes.");
+	block_size = size;
+}
+
+int HatchArchivePatch::get_block_size() const {
+	return block_size;
+}
+
+void HatchArchivePatch::_bind_methods(){
+	ClassDB::bind_method(D_METHOD("set_block_size", "size"), &HatchArchivePatch::set_block_size);
+	ClassDB::bind_method(D_METHOD("get_block_size"), &HatchArchivePatch::get_block_size);
+
+	ClassDB::bind_method(D_METHOD("create", "old_archive", "new_archive", "patch_path"), &HatchArchivePatch::create);
+	ClassDB::bind_method(D_METHOD("apply", "old_archive_path", "patch_path", "out_path"), &HatchArchivePatch::apply);
+
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "block_size", PROPERTY_HINT_RANGE, "64,65536,1"), "set_block_size", "get_block_size");
+}
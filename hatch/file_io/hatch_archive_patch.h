@@ -0,0 +1,61 @@
+#ifndef HATCH_ARCHIVE_PATCH_H
+#define HATCH_ARCHIVE_PATCH_H
+
+#include "hatch_archive_reader.h"
+
+#define HATCH_PATCH_MAGIC "HPAT"
+#define HATCH_PATCH_VERSION 2
+
+//Smaller blocks find more matches in shifted data but make the block index larger
+#define HATCH_PATCH_DEFAULT_BLOCK_SIZE 2048
+//Copies between files are done through a buffer this size, so applying never holds an entry
+#define HATCH_PATCH_COPY_CHUNK (256 * 1024)
+
+/*
+ Update patches between two versions of a .hatch archive. Entries are matched by name hash
+ and compared by payload checksum: unchanged entries are copied from the old archive, new
+ ones are stored whole, and changed ones become a block delta against their old payload
+ (copies of old blocks found with a rolling checksum, plus literal bytes), or are stored
+ whole when that is smaller.
+
+ Applying streams the new archive out in offset order from the old archive and the patch,
+ holding no more than a copy buffer, and checks every payload against the CRC32C recorded
+ when the patch was made, and the output's length against the new archive's. The output is
+ deleted if anything doesn't match. It has to be a new file: the old archive is read while
+ the output is written.
+ */
+class HatchArchivePatch : public RefCounted {
+	GDCLASS(HatchArchivePatch, RefCounted);
+
+public:
+	enum EntryKind : uint8_t {
+		ENTRY_UNCHANGED,
+		ENTRY_LITERAL,
+		ENTRY_DELTA,
+	};
+
+	enum DeltaOp : uint8_t {
+		OP_COPY, //start block, block count
+		OP_LITERAL, //length, bytes
+	};
+
+private:
+	int block_size = HATCH_PATCH_DEFAULT_BLOCK_SIZE;
+
+	static Error _read_header_and_toc(const String &p_path, PackedByteArray &r_bytes);
+	static void _build_delta(const PackedByteArray &p_old, const PackedByteArray &p_new, uint32_t p_block_size, LocalVector<uint8_t> &r_ops);
+
+protected:
+	static void _bind_methods();
+
+public:
+	void set_block_size(int size);
+	int get_block_size() const;
+
+	//Keys: ok, unchanged, added, modified, removed, patch_bytes
+	Dictionary create(Ref<HatchArchiveReader> old_archive, Ref<HatchArchiveReader> new_archive, String patch_path);
+	//Keys: ok, entries, bytes_written, seconds
+	Dictionary apply(String old_archive_path, String patch_path, String out_path);
+};
+
+#endif
@@ -2,38 +2,130 @@
 #define HATCH_ARCHIVE_READER_H
 
 #include "core/io/file_access.h"
+#include "core/os/mutex.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/templates/local_vector.h"
 
 #define HATCH_CRC_MAGIC_VALUE 0xFFFFFFFFU
 
+//Archives with a major version at or above this store a 32-bit file count instead of a 16-bit one
+#define HATCH_ARCHIVE_WIDE_TOC_MAJOR 2
+
+#define HATCH_DATA_FLAG_ENCRYPTED 2
+
+//Resource paths starting with this are resolved against the mounted archive
+#define HATCH_FILE_PREFIX "hatch://"
+
+//How much raw payload extraction keeps in flight per batch while the previous batch is being decoded
+#define HATCH_EXTRACT_BATCH_BYTES (32 * 1024 * 1024)
+#define HATCH_EXTRACT_BATCH_ENTRIES 512
+
+//crc32 + offset + size + data flag + compressed size
+#define HATCH_TOC_RECORD_SIZE 32
+
+typedef struct HatchArchiveHeader {
+	uint8_t major;
+	uint8_t minor;
+	uint8_t patch;
+	uint32_t file_count;
+} HatchArchiveHeader;
+
+//The archive cipher only depends on the byte position, so streams can run it a chunk at a time
+struct HatchDecryptState {
+	uint8_t keyA[16];
+	uint8_t keyB[16];
+	int swapNibbles;
+	int indexKeyA;
+	int indexKeyB;
+	int xorValue;
+
+	void _advance();
+
+	void init(uint32_t p_hash, uint64_t p_size);
+	void apply(uint8_t *p_data, uint64_t p_count);
+	void skip(uint64_t p_count);
+};
 
 typedef struct ResourceRegistryItem {
-	PackedByteArray table;
+	uint32_t crc32;
+	uint32_t data_flag;
 	uint64_t offset;
 	uint64_t size;
-	uint32_t data_flag;
 	uint64_t compressed_size;
 } ResourceRegistryItem;
 
 class HatchArchiveReader : public RefCounted {
 	GDCLASS(HatchArchiveReader, RefCounted);
 
-	HashMap<uint32_t, ResourceRegistryItem> resource_registry;
-	PackedInt32Array crc_array;
+	//Sorted by crc so lookups are a binary search over a flat array, which keeps
+	//both the lookup cost and the per-entry memory flat no matter the file count.
+	struct IndexKey {
+		uint32_t crc32;
+		uint32_t item;
+
+		bool operator<(const IndexKey &p_other) const {
+			return crc32 == p_other.crc32 ? item < p_other.item : crc32 < p_other.crc32;
+		}
+	};
+
+	LocalVector<ResourceRegistryItem> resource_registry; //TOC order
+	LocalVector<IndexKey> resource_index;
+	LocalVector<uint32_t> hash_collisions;
+
+	struct ExtractJob {
+		const ResourceRegistryItem *item;
+		PackedByteArray raw;
+		String out_path;
+		uint64_t bytes_written;
+		bool failed;
+	};
+
+	struct ExtractBatch {
+		LocalVector<ExtractJob> jobs;
+		uint64_t bytes_read;
+	};
 
-	uint16_t file_count;
+	HatchArchiveHeader header = {};
 
+	static Ref<HatchArchiveReader> mounted;
+
+	String archive_path;
 	Ref<FileAccess> file;
+	Mutex file_mutex; //loaders on other threads share the handle
+
+	void _build_index();
+
+	void _extract_job(uint32_t p_index, ExtractBatch *p_batch);
+	Dictionary _extract_items(LocalVector<const ResourceRegistryItem *> &p_items, const String &p_out_dir, const Dictionary &p_path_map);
+
+	template <typename F>
+	Dictionary _export_toc(F p_filter) const;
 
 protected:
 	static void _bind_methods();
 
 public:
-    uint16_t get_file_count();
+	uint32_t get_file_count();
+	String get_version();
 
 	static uint32_t p_crc_32_encrypt_data(PackedByteArray data, int size, uint32_t crc); //script API friendly
 	static uint32_t crc_32_encrypt_data(const void* data, size_t size, uint32_t crc = HATCH_CRC_MAGIC_VALUE);
  	static uint32_t crc32_string(String string);
 
+	static void decrypt_data(uint8_t *p_data, uint64_t p_size, uint32_t p_hash);
+	static bool decode_entry(const ResourceRegistryItem &p_item, const PackedByteArray &p_raw, PackedByteArray &r_out);
+
+	static bool read_header(const Ref<FileAccess> &p_file, HatchArchiveHeader &r_header);
+
+	static Ref<HatchArchiveReader> get_mounted();
+	static void unmount();
+	void mount();
+
+	static String strip_prefix(const String &p_path);
+
+	//Reads "hatch://" paths from the mounted archive and anything else from the filesystem
+	static Error load_path(const String &p_path, PackedByteArray &r_bytes);
+
 	void open(String file_path);
 	//void create_archive(String base_path, String out_path);
 
@@ -42,11 +134,26 @@ public:
 	PackedByteArray load_resource(String filename);
 	PackedByteArray load_resource_hash(uint32_t hash);
 
+	Dictionary extract_all(String out_dir, Dictionary path_map = Dictionary());
+	Dictionary extract_subset(PackedInt64Array hashes, String out_dir, Dictionary path_map = Dictionary());
+
 	bool has_resource(String filename);
 	bool has_resource_hash(uint32_t hash);
 
 	Dictionary get_file_information(int index);
 	Dictionary get_file_information_hash(uint32_t hash);
+
+	String get_path();
+
+	Dictionary get_toc();
+	Dictionary get_toc_with_flag(uint32_t data_flag);
+	Dictionary get_toc_in_size_range(uint64_t min_size, uint64_t max_size);
+
+	const ResourceRegistryItem *find_item(uint32_t hash) const;
+	//TOC order, including entries whose name collided
+	const LocalVector<ResourceRegistryItem> &get_registry() const { return resource_registry; }
+
+	PackedInt64Array get_hash_collisions();
 };
 
 #endif
@@ -0,0 +1,405 @@
+#include "hatch_archive_types.h"
+#include "hatch_archive_manifest.h"
+#include "../hatch_formats.h"
+#include "../hatch_performance.h"
+
+#include "core/io/marshalls.h"
+#include "core/os/os.h"
+
+#include <zlib.h>
+
+static const char *type_names[HatchArchiveTypeIndex::TYPE_MAX] = {
+	"unknown",
+	"empty",
+	"bytecode",
+	"class_map",
+	"sprite",
+	"png",
+	"gif",
+	"jpeg",
+	"ogg",
+	"wav",
+	"xml",
+};
+
+String HatchArchiveTypeIndex::get_sidecar_path(String archive_path){
+	return archive_path + HATCH_TYPES_EXTENSION;
+}
+
+String HatchArchiveTypeIndex::get_type_name(ContentType type){
+	ERR_FAIL_INDEX_V(type, TYPE_MAX, String());
+	return type_names[type];
+}
+
+HatchArchiveTypeIndex::ContentType HatchArchiveTypeIndex::sniff(const uint8_t *p_data, uint64_t p_size){
+	if (p_size == 0){
+		return TYPE_EMPTY;
+	}
+
+	if (p_size >= 4){
+		//HTVM as HSLBytecodeReader names it, HVTM as its load check spells it
+		if (memcmp(p_data, "HTVM", 4) == 0 or memcmp(p_data, "HVTM", 4) == 0){
+			return TYPE_BYTECODE;
+		}
+		if (memcmp(p_data, HSL_CLASS_MAP_MAGIC, 4) == 0){
+			return TYPE_CLASS_MAP;
+		}
+		if (memcmp(p_data, HATCH_SPRITE_MAGIC, 4) == 0){
+			return TYPE_SPRITE;
+		}
+		if (memcmp(p_data, "OggS", 4) == 0){
+			return TYPE_OGG;
+		}
+	}
+
+	if (p_size >= 8 and memcmp(p_data, "\x89PNG\r\n\x1A\n", 8) == 0){
+		return TYPE_PNG;
+	}
+	if (p_size >= 6 and (memcmp(p_data, "GIF87a", 6) == 0 or memcmp(p_data, "GIF89a", 6) == 0)){
+		return TYPE_GIF;
+	}
+	if (p_size >= 3 and p_data[0] == 0xFF and p_data[1] == 0xD8 and p_data[2] == 0xFF){
+		return TYPE_JPEG;
+	}
+	if (p_size >= 12 and memcmp(p_data, "RIFF", 4) == 0 and memcmp(p_data + 8, "WAVE", 4) == 0){
+		return TYPE_WAV;
+	}
+
+	//markup may open with a BOM and whitespace before the first tag
+	uint64_t i = 0;
+	if (p_size >= 3 and p_data[0] == 0xEF and p_data[1] == 0xBB and p_data[2] == 0xBF){
+		i = 3;
+	}
+	while (i < p_size and (p_data[i] == ' ' or p_data[i] == '\t' or p_data[i] == '\r' or p_data[i] == '\n')){
+		i++;
+	}
+	if (i + 1 < p_size and p_data[i] == '<' and (p_data[i + 1] == '?' or p_data[i + 1] == '!' or is_ascii_alphabet_char(p_data[i + 1]))){
+		return TYPE_XML;
+	}
+
+	return TYPE_UNKNOWN;
+}
+
+void HatchArchiveTypeIndex::_sniff_run(uint32_t p_index, SniffBatch *p_batch){
+	const SniffRun &run = p_batch->runs[p_index];
+
+	//every run gets its own handle, so reads on different threads never share a seek position
+	Ref<FileAccess> file = FileAccess::open(p_batch->archive_path, FileAccess::ModeFlags::READ);
+	if (file.is_null()){
+		for (uint32_t i = run.begin; i < run.end; i++){
+			p_batch->jobs[i].read_failed = true;
+		}
+		return;
+	}
+
+	z_stream inflater = {};
+	bool inflater_ready = inflateInit(&inflater) == Z_OK;
+
+	uint8_t raw[HATCH_TYPES_SNIFF_READ];
+	uint8_t prefix[HATCH_TYPES_SNIFF_BYTES];
+	uint64_t bytes_read = 0;
+
+	for (uint32_t i = run.begin; i < run.end; i++){
+		SniffJob &job = p_batch->jobs[i];
+		const ResourceRegistryItem &item = *job.item;
+
+		uint64_t wanted = MIN(item.size, (uint64_t)HATCH_TYPES_SNIFF_BYTES);
+		if (wanted == 0){
+			job.type = TYPE_EMPTY;
+			continue;
+		}
+
+		bool compressed = item.size != item.compressed_size;
+		uint64_t read_size = MIN(item.compressed_size, compressed ? (uint64_t)HATCH_TYPES_SNIFF_READ : wanted);
+
+		file->seek(item.offset);
+		uint64_t got = file->get_buffer(raw, read_size);
+		bytes_read += got;
+		if (got != read_size){
+			job.read_failed = true;
+			continue;
+		}
+
+		uint64_t decoded = 0;
+		if (compressed){
+			if (not inflater_ready){
+				job.read_failed = true;
+				continue;
+			}
+
+			//only as much output room as the prefix, so inflating stops there
+			inflateReset(&inflater);
+			inflater.next_in = raw;
+			inflater.avail_in = got;
+			inflater.next_out = prefix;
+			inflater.avail_out = wanted;
+
+			int status = inflate(&inflater, Z_SYNC_FLUSH);
+			decoded = wanted - inflater.avail_out;
+			if (status != Z_OK and status != Z_STREAM_END and status != Z_BUF_ERROR){
+				job.read_failed = true;
+				continue;
+			}
+		} else {
+			memcpy(prefix, raw, got);
+			decoded = got;
+		}
+
+		//the cipher runs over the decoded bytes from the start, so the prefix decrypts on its own
+		if (item.data_flag == HATCH_DATA_FLAG_ENCRYPTED){
+			HatchDecryptState cipher;
+			cipher.init(item.crc32, item.size);
+			cipher.apply(prefix, decoded);
+		}
+
+		job.type = sniff(prefix, decoded);
+	}
+
+	if (inflater_ready){
+		inflateEnd(&inflater);
+	}
+
+	HatchPerformance::add(HatchPerformance::ARCHIVE_BYTES_READ, bytes_read);
+}
+
+uint32_t HatchArchiveTypeIndex::_get_toc_checksum(const LocalVector<ResourceRegistryItem> &p_registry){
+	uint8_t record[HATCH_TOC_RECORD_SIZE];
+	uint32_t checksum = 0;
+
+	for (const ResourceRegistryItem &item : p_registry){
+		encode_uint32(item.crc32, record);
+		encode_uint64(item.offset, record + 4);
+		encode_uint64(item.size, record + 12);
+		encode_uint32(item.data_flag, record + 20);
+		encode_uint64(item.compressed_size, record + 24);
+		checksum = hatch_crc32c(record, HATCH_TOC_RECORD_SIZE, checksum);
+	}
+
+	return checksum;
+}
+
+bool HatchArchiveTypeIndex::_matches(const Ref<HatchArchiveReader> &p_archive) const {
+	//a rebuilt archive can keep its names and length, but not where everything sits
+	const LocalVector<ResourceRegistryItem> &registry = p_archive->get_registry();
+	if (registry.size() != entries.size() or _get_toc_checksum(registry) != toc_checksum){
+		return false;
+	}
+
+	Ref<FileAccess> file = FileAccess::open(p_archive->get_path(), FileAccess::ModeFlags::READ);
+	return file.is_valid() and file->get_length() == archive_length;
+}
+
+Error HatchArchiveTypeIndex::build(Ref<HatchArchiveReader> archive){
+	ERR_FAIL_COND_V(archive.is_null(), ERR_INVALID_PARAMETER);
+	ERR_FAIL_COND_V_MSG(archive->get_path().is_empty(), ERR_UNCONFIGURED, "No Hatch archive is loaded.");
+
+	const LocalVector<ResourceRegistryItem> &registry = archive->get_registry();
+
+	SniffBatch batch;
+	batch.archive_path = archive->get_path();
+	batch.jobs.resize(registry.size());
+
+	for (uint32_t i = 0; i < registry.size(); i++){
+		SniffJob &job = batch.jobs[i];
+		job.item = &registry[i];
+		job.type = TYPE_UNKNOWN;
+		job.read_failed = false;
+	}
+
+	struct OffsetOrder {
+		bool operator()(const SniffJob &p_a, const SniffJob &p_b) const {
+			return p_a.item->offset < p_b.item->offset;
+		}
+	};
+
+	//Offset order makes every run a forward sweep over one stretch of the archive
+	batch.jobs.sort_custom<OffsetOrder>();
+
+	uint32_t run_entries = MAX(batch.jobs.size() / MAX(OS::get_singleton()->get_processor_count() * 4, 1), (uint32_t)HATCH_TYPES_MIN_RUN_ENTRIES);
+	for (uint32_t begin = 0; begin < batch.jobs.size(); begin += run_entries){
+		batch.runs.push_back({ begin, MIN(begin + run_entries, batch.jobs.size()) });
+	}
+
+	if (not batch.runs.is_empty()){
+		WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(this, &HatchArchiveTypeIndex::_sniff_run, &batch, batch.runs.size(), -1, false, "Hatch archive types");
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+	}
+
+	LocalVector<Entry> made;
+	made.resize(registry.size());
+
+	for (const SniffJob &job : batch.jobs){
+		ERR_FAIL_COND_V_MSG(job.read_failed, ERR_FILE_CORRUPT, vformat("Could not read Hatch archive entry %08x to find its type.", job.item->crc32));
+
+		Entry &entry = made[job.item - registry.ptr()];
+		entry.crc32 = job.item->crc32;
+		entry.type = job.type;
+	}
+
+	Ref<FileAccess> file = FileAccess::open(batch.archive_path, FileAccess::ModeFlags::READ);
+	archive_length = file.is_valid() ? file->get_length() : 0;
+	toc_checksum = _get_toc_checksum(registry);
+	entries = made;
+	_index_types();
+
+	return OK;
+}
+
+Error HatchArchiveTypeIndex::open(Ref<HatchArchiveReader> archive){
+	ERR_FAIL_COND_V(archive.is_null(), ERR_INVALID_PARAMETER);
+
+	String sidecar = get_sidecar_path(archive->get_path());
+	if (FileAccess::exists(sidecar) and load(sidecar) == OK and _matches(archive)){
+		return OK;
+	}
+
+	Error err = build(archive);
+	if (err != OK){
+		return err;
+	}
+
+	//a read-only install just rebuilds next time
+	if (save(sidecar) != OK){
+		WARN_PRINT("Could not save the Hatch archive type index next to \"" + archive->get_path() + "\".");
+	}
+	return OK;
+}
+
+Error HatchArchiveTypeIndex::save(String path) const {
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::ModeFlags::WRITE);
+	ERR_FAIL_COND_V_MSG(file.is_null(), ERR_FILE_CANT_WRITE, "Could not write Hatch archive type index to \"" + path + "\".");
+
+	file->store_buffer((const uint8_t *)HATCH_TYPES_MAGIC, 4);
+	file->store_32(HATCH_TYPES_VERSION);
+	file->store_32(entries.size());
+	file->store_64(archive_length);
+	file->store_32(toc_checksum);
+
+	for (const Entry &entry : entries){
+		file->store_32(entry.crc32);
+		file->store_8(entry.type);
+		file->store_8(0);
+		file->store_16(0);
+	}
+
+	return OK;
+}
+
+Error HatchArchiveTypeIndex::load(String path){
+	Error err = OK;
+	PackedByteArray data = FileAccess::get_file_as_bytes(path, &err);
+	if (err != OK){
+		return err;
+	}
+
+	ERR_FAIL_COND_V_MSG(data.size() < HATCH_TYPES_HEADER_SIZE or memcmp(data.ptr(), HATCH_TYPES_MAGIC, 4) != 0, ERR_FILE_UNRECOGNIZED, "\"" + path + "\" is not a Hatch archive type index.");
+	ERR_FAIL_COND_V_MSG(decode_uint32(data.ptr() + 4) != HATCH_TYPES_VERSION, ERR_FILE_UNRECOGNIZED, "Unsupported Hatch archive type index version in \"" + path + "\".");
+
+	uint32_t count = decode_uint32(data.ptr() + 8);
+	ERR_FAIL_COND_V_MSG((uint64_t)count * HATCH_TYPES_RECORD_SIZE != (uint64_t)data.size() - HATCH_TYPES_HEADER_SIZE, ERR_FILE_CORRUPT, "Hatch archive type index \"" + path + "\" is truncated.");
+
+	archive_length = decode_uint64(data.ptr() + 12);
+	toc_checksum = decode_uint32(data.ptr() + 20);
+	entries.resize(count);
+
+	const uint8_t *record = data.ptr() + HATCH_TYPES_HEADER_SIZE;
+	for (uint32_t i = 0; i < count; i++){
+		entries[i].crc32 = decode_uint32(record);
+		entries[i].type = record[4] < TYPE_MAX ? record[4] : TYPE_UNKNOWN;
+
+		record += HATCH_TYPES_RECORD_SIZE;
+	}
+
+	_index_types();
+	return OK;
+}
+
+int HatchArchiveTypeIndex::get_entry_count() const {
+	return entries.size();
+}
+
+HatchArchiveTypeIndex::ContentType HatchArchiveTypeIndex::get_type(uint32_t hash) const {
+	const uint8_t *type = types_by_hash.getptr(hash);
+	return type != nullptr ? (ContentType)*type : TYPE_UNKNOWN;
+}
+
+void HatchArchiveTypeIndex::_index_types(){
+	types_by_hash.clear();
+	types_by_hash.reserve(entries.size());
+
+	//a collided name only has its first entry reachable, same as the archive index
+	for (const Entry &entry : entries){
+		if (not types_by_hash.has(entry.crc32)){
+			types_by_hash.insert(entry.crc32, entry.type);
+		}
+	}
+}
+
+PackedInt64Array HatchArchiveTypeIndex::get_hashes_of_type(ContentType type) const {
+	PackedInt64Array out;
+	for (const Entry &entry : entries){
+		if (entry.type == type){
+			out.push_back(entry.crc32);
+		}
+	}
+
+	return out;
+}
+
+Dictionary HatchArchiveTypeIndex::get_type_counts() const {
+	uint32_t counts[TYPE_MAX] = {};
+	for (const Entry &entry : entries){
+		counts[entry.type]++;
+	}
+
+	Dictionary out;
+	for (int i = 0; i < TYPE_MAX; i++){
+		if (counts[i] > 0){
+			out[type_names[i]] = counts[i];
+		}
+	}
+
+	return out;
+}
+
+Dictionary HatchArchiveTypeIndex::preload_type(Ref<HatchArchiveReader> archive, ContentType type) const {
+	Dictionary out;
+	ERR_FAIL_COND_V(archive.is_null(), out);
+
+	for (const Entry &entry : entries){
+		if (entry.type == type and not out.has(entry.crc32)){
+			out[entry.crc32] = archive->load_resource_hash(entry.crc32);
+		}
+	}
+
+	return out;
+}
+
+void HatchArchiveTypeIndex::_bind_methods(){
+	ClassDB::bind_static_method("HatchArchiveTypeIndex", D_METHOD("get_sidecar_path", "archive_path"), &HatchArchiveTypeIndex::get_sidecar_path);
+	ClassDB::bind_static_method("HatchArchiveTypeIndex", D_METHOD("get_type_name", "type"), &HatchArchiveTypeIndex::get_type_name);
+
+	ClassDB::bind_method(D_METHOD("build", "archive"), &HatchArchiveTypeIndex::build);
+	ClassDB::bind_method(D_METHOD("open", "archive"), &HatchArchiveTypeIndex::open);
+
+	ClassDB::bind_method(D_METHOD("save", "path"), &HatchArchiveTypeIndex::save);
+	ClassDB::bind_method(D_METHOD("load", "path"), &HatchArchiveTypeIndex::load);
+
+	ClassDB::bind_method(D_METHOD("get_entry_count"), &HatchArchiveTypeIndex::get_entry_count);
+	ClassDB::bind_method(D_METHOD("get_type", "hash"), &HatchArchiveTypeIndex::get_type);
+	ClassDB::bind_method(D_METHOD("get_hashes_of_type", "type"), &HatchArchiveTypeIndex::get_hashes_of_type);
+	ClassDB::bind_method(D_METHOD("get_type_counts"), &HatchArchiveTypeIndex::get_type_counts);
+	ClassDB::bind_method(D_METHOD("preload_type", "archive", "type"), &HatchArchiveTypeIndex::preload_type);
+
+	BIND_ENUM_CONSTANT(TYPE_UNKNOWN);
+	BIND_ENUM_CONSTANT(TYPE_EMPTY);
+	BIND_ENUM_CONSTANT(TYPE_BYTECODE);
+	BIND_ENUM_CONSTANT(TYPE_CLASS_MAP);
+	BIND_ENUM_CONSTANT(TYPE_SPRITE);
+	BIND_ENUM_CONSTANT(TYPE_PNG);
+	BIND_ENUM_CONSTANT(TYPE_GIF);
+	BIND_ENUM_CONSTANT(TYPE_JPEG);
+	BIND_ENUM_CONSTANT(TYPE_OGG);
+	BIND_ENUM_CONSTANT(TYPE_WAV);
+	BIND_ENUM_CONSTANT(TYPE_XML);
+}
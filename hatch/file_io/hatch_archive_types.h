@@ -0,0 +1,111 @@
+#ifndef HATCH_ARCHIVE_TYPES_H
+#define HATCH_ARCHIVE_TYPES_H
+
+#include "hatch_archive_reader.h"
+
+#include "core/templates/hash_map.h"
+
+#define HATCH_TYPES_MAGIC "HTYP"
+#define HATCH_TYPES_VERSION 1
+#define HATCH_TYPES_EXTENSION ".types"
+
+//magic + version + entry count + archive length + crc32c of the TOC it was built from
+#define HATCH_TYPES_HEADER_SIZE 24
+//name crc + content type + padding
+#define HATCH_TYPES_RECORD_SIZE 8
+
+//Decoded bytes looked at per entry; every format recognised has its magic well inside this
+#define HATCH_TYPES_SNIFF_BYTES 64
+//Compressed bytes read per entry to inflate that much
+#define HATCH_TYPES_SNIFF_READ 4096
+//Entries per worker run, so a run amortizes opening its own file handle
+#define HATCH_TYPES_MIN_RUN_ENTRIES 256
+
+/*
+ Content types for every entry of a .hatch archive, kept in a sidecar file next to it
+ (Data.hatch and Data.hatch.types), since the TOC only has name hashes. Building it reads just
+ the first bytes of each entry, inflating and decrypting only that prefix, and recognises the
+ format by its magic, across the worker pool. After that, "every sprite" or "all the audio"
+ is a lookup rather than loading the whole archive to look at it.
+ */
+class HatchArchiveTypeIndex : public RefCounted {
+	GDCLASS(HatchArchiveTypeIndex, RefCounted);
+
+public:
+	enum ContentType {
+		TYPE_UNKNOWN,
+		TYPE_EMPTY,
+		TYPE_BYTECODE, //HSL bytecode (HTVM)
+		TYPE_CLASS_MAP, //Objects.hcm (HMAP)
+		TYPE_SPRITE, //sprite animation .bin (SPR)
+		TYPE_PNG,
+		TYPE_GIF,
+		TYPE_JPEG,
+		TYPE_OGG,
+		TYPE_WAV,
+		TYPE_XML, //scenes, tilesets and configs
+		TYPE_MAX
+	};
+
+private:
+	struct Entry {
+		uint32_t crc32;
+		uint8_t type;
+	};
+
+	struct SniffJob {
+		const ResourceRegistryItem *item;
+		uint8_t type;
+		bool read_failed;
+	};
+
+	struct SniffRun {
+		uint32_t begin;
+		uint32_t end;
+	};
+
+	struct SniffBatch {
+		String archive_path;
+		LocalVector<SniffJob> jobs; //offset order
+		LocalVector<SniffRun> runs;
+	};
+
+	LocalVector<Entry> entries; //TOC order
+	HashMap<uint32_t, uint8_t> types_by_hash; //for get_type, rebuilt with entries
+	uint64_t archive_length = 0;
+	uint32_t toc_checksum = 0;
+
+	static uint32_t _get_toc_checksum(const LocalVector<ResourceRegistryItem> &p_registry);
+
+	void _sniff_run(uint32_t p_index, SniffBatch *p_batch);
+	void _index_types();
+	bool _matches(const Ref<HatchArchiveReader> &p_archive) const;
+
+protected:
+	static void _bind_methods();
+
+public:
+	static String get_sidecar_path(String archive_path);
+	static ContentType sniff(const uint8_t *p_data, uint64_t p_size);
+
+	Error build(Ref<HatchArchiveReader> archive);
+	//Loads the sidecar if it still matches the archive, otherwise builds the index and saves it
+	Error open(Ref<HatchArchiveReader> archive);
+
+	Error save(String path) const;
+	Error load(String path);
+
+	int get_entry_count() const;
+	ContentType get_type(uint32_t hash) const;
+	PackedInt64Array get_hashes_of_type(ContentType type) const;
+	//Keyed by type name
+	Dictionary get_type_counts() const;
+	//Every entry of a type, as hash -> decoded bytes
+	Dictionary preload_type(Ref<HatchArchiveReader> archive, ContentType type) const;
+
+	static String get_type_name(ContentType type);
+};
+
+VARIANT_ENUM_CAST(HatchArchiveTypeIndex::ContentType);
+
+#endif
@@ -0,0 +1,181 @@
+#include "hatch_entry_stream.h"
+#include "../hatch_performance.h"
+
+Error HatchEntryStream::open(const String &p_archive_path, const ResourceRegistryItem &p_item){
+	close();
+
+	file = FileAccess::open(p_archive_path, FileAccess::ModeFlags::READ);
+	ERR_FAIL_COND_V_MSG(file.is_null(), ERR_FILE_CANT_OPEN, "Could not open Hatch archive at " + p_archive_path);
+
+	item = p_item;
+	compressed = item.size != item.compressed_size;
+	encrypted = item.data_flag == HATCH_DATA_FLAG_ENCRYPTED;
+
+	if (compressed){
+		inflater.zalloc = Z_NULL;
+		inflater.zfree = Z_NULL;
+		inflater.opaque = Z_NULL;
+		inflater.avail_in = 0;
+		inflater.next_in = Z_NULL;
+
+		if (inflateInit(&inflater) != Z_OK){
+			close();
+			ERR_FAIL_V_MSG(ERR_CANT_CREATE, "Could not start inflating Hatch archive entry.");
+		}
+		inflater_ready = true;
+	}
+
+	_restart();
+	return OK;
+}
+
+Error HatchEntryStream::open_resource(const Ref<HatchArchiveReader> &p_archive, const String &p_filename){
+	ERR_FAIL_COND_V(p_archive.is_null(), ERR_INVALID_PARAMETER);
+
+	const ResourceRegistryItem *found = p_archive->find_item(HatchArchiveReader::crc32_string(p_filename));
+	ERR_FAIL_NULL_V_MSG(found, ERR_FILE_NOT_FOUND, "\"" + p_filename + "\" is not in the Hatch archive.");
+
+	return open(p_archive->get_path(), *found);
+}
+
+Error HatchEntryStream::open_file(const String &p_path){
+	Ref<FileAccess> plain = FileAccess::open(p_path, FileAccess::ModeFlags::READ);
+	ERR_FAIL_COND_V_MSG(plain.is_null(), ERR_FILE_CANT_OPEN, "Could not open " + p_path);
+
+	//a plain file is just a stored, unencrypted entry that spans the whole file
+	ResourceRegistryItem whole = {};
+	whole.size = plain->get_length();
+	whole.compressed_size = whole.size;
+
+	return open(p_path, whole);
+}
+
+Error HatchEntryStream::open_path(const String &p_path){
+	if (p_path.begins_with(HATCH_FILE_PREFIX)){
+		Ref<HatchArchiveReader> archive = HatchArchiveReader::get_mounted();
+		ERR_FAIL_COND_V_MSG(archive.is_null(), ERR_UNCONFIGURED, "No Hatch archive is mounted for \"" + p_path + "\".");
+
+		return open_resource(archive, HatchArchiveReader::strip_prefix(p_path));
+	}
+
+	return open_file(p_path);
+}
+
+void HatchEntryStream::close(){
+	if (inflater_ready){
+		inflateEnd(&inflater);
+		inflater_ready = false;
+	}
+
+	file.unref();
+	item = {};
+	position = 0;
+	raw_position = 0;
+}
+
+void HatchEntryStream::_restart(){
+	position = 0;
+	raw_position = 0;
+
+	if (inflater_ready){
+		inflateReset(&inflater);
+		inflater.avail_in = 0;
+		inflater.next_in = Z_NULL;
+	}
+
+	if (encrypted){
+		cipher.init(item.crc32, item.size);
+	}
+
+	file->seek(item.offset);
+}
+
+uint64_t HatchEntryStream::_inflate(uint8_t *p_dst, uint64_t p_bytes){
+	inflater.next_out = p_dst;
+	inflater.avail_out = p_bytes;
+
+	while (inflater.avail_out > 0){
+		if (inflater.avail_in == 0){
+			uint64_t refill = MIN((uint64_t)HATCH_ENTRY_STREAM_CHUNK, item.compressed_size - raw_position);
+			if (refill == 0){
+				break;
+			}
+
+			uint64_t got = file->get_buffer(in_buffer, refill);
+			if (got == 0){
+				break;
+			}
+
+			raw_position += got;
+			inflater.next_in = in_buffer;
+			inflater.avail_in = got;
+
+			HatchPerformance::add(HatchPerformance::ARCHIVE_BYTES_READ, got);
+		}
+
+		int status = inflate(&inflater, Z_NO_FLUSH);
+		if (status == Z_STREAM_END){
+			break;
+		}
+		ERR_FAIL_COND_V_MSG(status != Z_OK and status != Z_BUF_ERROR, p_bytes - inflater.avail_out, "Hatch archive entry has corrupt compressed data.");
+	}
+
+	return p_bytes - inflater.avail_out;
+}
+
+uint64_t HatchEntryStream::read(uint8_t *p_dst, uint64_t p_bytes){
+	ERR_FAIL_COND_V(file.is_null(), 0);
+
+	p_bytes = MIN(p_bytes, item.size - position);
+	if (p_bytes == 0){
+		return 0;
+	}
+
+	uint64_t got;
+	if (compressed){
+		got = _inflate(p_dst, p_bytes);
+	} else {
+		got = file->get_buffer(p_dst, p_bytes);
+		HatchPerformance::add(HatchPerformance::ARCHIVE_BYTES_READ, got);
+	}
+
+	if (encrypted){
+		cipher.apply(p_dst, got);
+	}
+
+	position += got;
+	return got;
+}
+
+void HatchEntryStream::seek(uint64_t p_position){
+	ERR_FAIL_COND(file.is_null());
+
+	p_position = MIN(p_position, item.size);
+
+	if (not compressed){
+		//stored entries can jump straight there, only the cipher has to be walked forward
+		if (encrypted){
+			cipher.init(item.crc32, item.size);
+			cipher.skip(p_position);
+		}
+
+		file->seek(item.offset + p_position);
+		position = p_position;
+		return;
+	}
+
+	if (p_position < position){
+		_restart();
+	}
+
+	uint8_t scratch[4096];
+	while (position < p_position){
+		if (read(scratch, MIN((uint64_t)sizeof(scratch), p_position - position)) == 0){
+			break;
+		}
+	}
+}
+
+HatchEntryStream::~HatchEntryStream(){
+	close();
+}
@@ -0,0 +1,57 @@
+#ifndef HATCH_ENTRY_STREAM_H
+#define HATCH_ENTRY_STREAM_H
+
+#include "hatch_archive_reader.h"
+
+#include <zlib.h>
+
+//How much compressed data is read from the archive per refill
+#define HATCH_ENTRY_STREAM_CHUNK (16 * 1024)
+
+/*
+ Sequential reader over one archive entry that never holds the whole entry in memory. Stored
+ entries are read in place; compressed ones are inflated as they are read, and encrypted ones
+ are decrypted chunk by chunk with a running HatchDecryptState. Seeking forward skips ahead,
+ seeking backward in a compressed entry restarts the inflater. It owns its own file handle,
+ so it can be used off the main thread while the archive keeps loading other resources.
+ */
+class HatchEntryStream {
+	Ref<FileAccess> file;
+	ResourceRegistryItem item = {};
+
+	bool compressed = false;
+	bool encrypted = false;
+
+	z_stream inflater = {};
+	bool inflater_ready = false;
+	uint8_t in_buffer[HATCH_ENTRY_STREAM_CHUNK];
+	uint64_t raw_position = 0;
+
+	HatchDecryptState cipher;
+	uint64_t position = 0;
+
+	void _restart();
+	uint64_t _inflate(uint8_t *p_dst, uint64_t p_bytes);
+
+public:
+	Error open(const String &p_archive_path, const ResourceRegistryItem &p_item);
+	Error open_resource(const Ref<HatchArchiveReader> &p_archive, const String &p_filename);
+	Error open_file(const String &p_path);
+
+	//Opens "hatch://" paths from the mounted archive, anything else as a plain file
+	Error open_path(const String &p_path);
+
+	void close();
+	bool is_open() const { return file.is_valid(); }
+
+	uint64_t read(uint8_t *p_dst, uint64_t p_bytes);
+	void seek(uint64_t p_position);
+
+	uint64_t get_position() const { return position; }
+	uint64_t get_length() const { return item.size; }
+	bool eof_reached() const { return position >= item.size; }
+
+	~HatchEntryStream();
+};
+
+#endif
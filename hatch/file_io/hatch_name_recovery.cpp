@@ -0,0 +1,205 @@
+#include "hatch_name_recovery.h"
+
+void HatchNameRecovery::set_archive(const Ref<HatchArchiveReader> &p_archive){
+	archive = p_archive;
+	recovered.clear();
+}
+
+Ref<HatchArchiveReader> HatchNameRecovery::get_archive() const {
+	return archive;
+}
+
+void HatchNameRecovery::_hash_candidate(uint32_t p_index, CandidateBatch *p_batch){
+	//Same bytes crc32_string hashes, without the intermediate PackedByteArray
+	CharString path = p_batch->paths[p_index].ascii();
+	uint32_t hash = HatchArchiveReader::crc_32_encrypt_data(path.get_data(), path.length());
+
+	p_batch->hashes[p_index] = hash;
+	//the archive index is read-only here, so lookups are safe from any worker
+	p_batch->matched[p_index] = archive->find_item(hash) != nullptr;
+}
+
+int HatchNameRecovery::_match_batch(const String *p_paths, uint32_t p_count){
+	CandidateBatch batch;
+	batch.paths = p_paths;
+	batch.hashes.resize(p_count);
+	batch.matched.resize(p_count);
+
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(this, &HatchNameRecovery::_hash_candidate, &batch, p_count, -1, false, "Hatch name recovery");
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+
+	int new_matches = 0;
+
+	for (uint32_t i = 0; i < p_count; i++){
+		if (not batch.matched[i] or recovered.has(batch.hashes[i])){
+			continue;
+		}
+
+		recovered.insert(batch.hashes[i], p_paths[i]);
+		new_matches++;
+	}
+
+	return new_matches;
+}
+
+int HatchNameRecovery::add_candidates(PackedStringArray paths){
+	ERR_FAIL_COND_V_MSG(archive.is_null(), 0, "No Hatch archive set for name recovery.");
+
+	const String *raw_paths = paths.ptr();
+	int new_matches = 0;
+
+	for (int64_t start = 0; start < paths.size(); start += HATCH_NAME_RECOVERY_BATCH){
+		uint32_t count = MIN((int64_t)HATCH_NAME_RECOVERY_BATCH, paths.size() - start);
+		new_matches += _match_batch(raw_paths + start, count);
+	}
+
+	return new_matches;
+}
+
+int HatchNameRecovery::add_candidates_from_file(String wordlist_path){
+	ERR_FAIL_COND_V_MSG(archive.is_null(), 0, "No Hatch archive set for name recovery.");
+
+	Ref<FileAccess> wordlist = FileAccess::open(wordlist_path, FileAccess::ModeFlags::READ);
+	ERR_FAIL_COND_V_MSG(wordlist.is_null(), 0, "Could not open wordlist at " + wordlist_path);
+
+	//Stream the list so huge wordlists never sit in memory all at once
+	LocalVector<String> batch;
+	batch.reserve(HATCH_NAME_RECOVERY_BATCH);
+	int new_matches = 0;
+
+	while (not wordlist->eof_reached()){
+		String line = wordlist->get_line().strip_edges();
+
+		if (not line.is_empty() and not line.begins_with("#")){
+			batch.push_back(line);
+		}
+
+		if (batch.size() == HATCH_NAME_RECOVERY_BATCH){
+			new_matches += _match_batch(batch.ptr(), batch.size());
+			batch.clear();
+		}
+	}
+
+	if (not batch.is_empty()){
+		new_matches += _match_batch(batch.ptr(), batch.size());
+	}
+
+	return new_matches;
+}
+
+int HatchNameRecovery::add_candidates_from_bytecode(Ref<HSLBytecodeReader> bytecode){
+	ERR_FAIL_COND_V(bytecode.is_null(), 0);
+
+	PackedStringArray candidates = bytecode->get_string_constants();
+
+	if (bytecode->has_source_path()){
+		candidates.push_back(bytecode->get_source_path());
+	}
+
+	return add_candidates(candidates);
+}
+
+String HatchNameRecovery::get_path_for_hash(uint32_t hash){
+	const String *path = recovered.getptr(hash);
+
+	if (path == nullptr){
+		return String();
+	}
+
+	return *path;
+}
+
+Dictionary HatchNameRecovery::get_recovered_paths(){
+	Dictionary out;
+
+	for (const KeyValue<uint32_t, String> &E : recovered){
+		out[E.key] = E.value;
+	}
+
+	return out;
+}
+
+int HatchNameRecovery::get_recovered_count(){
+	return recovered.size();
+}
+
+void HatchNameRecovery::clear(){
+	recovered.clear();
+}
+
+String HatchNameRecovery::get_dictionary_path(){
+	ERR_FAIL_COND_V(archive.is_null(), String());
+
+	return archive->get_path() + HATCH_NAMES_EXTENSION;
+}
+
+Error HatchNameRecovery::save_dictionary(String path){
+	if (path.is_empty()){
+		path = get_dictionary_path();
+	}
+	ERR_FAIL_COND_V(path.is_empty(), ERR_FILE_BAD_PATH);
+
+	Ref<FileAccess> out_file = FileAccess::open(path, FileAccess::ModeFlags::WRITE);
+	ERR_FAIL_COND_V_MSG(out_file.is_null(), ERR_FILE_CANT_WRITE, "Could not write Hatch name dictionary to " + path);
+
+	//one "XXXXXXXX<tab>path" line per entry, so the file is also usable as a plain wordlist
+	for (const KeyValue<uint32_t, String> &E : recovered){
+		out_file->store_line(String::num_uint64(E.key, 16, true).lpad(8, "0") + "\t" + E.value);
+	}
+
+	return OK;
+}
+
+int HatchNameRecovery::load_dictionary(String path){
+	if (path.is_empty()){
+		path = get_dictionary_path();
+	}
+
+	if (path.is_empty() or not FileAccess::exists(path)){
+		return 0;
+	}
+
+	Ref<FileAccess> in_file = FileAccess::open(path, FileAccess::ModeFlags::READ);
+	ERR_FAIL_COND_V(in_file.is_null(), 0);
+
+	int loaded = 0;
+
+	while (not in_file->eof_reached()){
+		String line = in_file->get_line();
+		int tab = line.find("\t");
+
+		if (tab != 8){
+			continue;
+		}
+
+		uint32_t hash = line.substr(0, 8).hex_to_int();
+
+		//skip names for entries that are no longer in the archive
+		if (archive.is_valid() and archive->find_item(hash) == nullptr){
+			continue;
+		}
+
+		recovered.insert(hash, line.substr(9));
+		loaded++;
+	}
+
+	return loaded;
+}
+
+void HatchNameRecovery::_bind_methods(){
+	ClassDB::bind_method(D_METHOD("set_archive", "archive"), &HatchNameRecovery::set_archive);
+	ClassDB::bind_method(D_METHOD("get_archive"), &HatchNameRecovery::get_archive);
+
+	ClassDB::bind_method(D_METHOD("add_candidates", "paths"), &HatchNameRecovery::add_candidates);
+	ClassDB::bind_method(D_METHOD("add_candidates_from_file", "wordlist_path"), &HatchNameRecovery::add_candidates_from_file);
+	ClassDB::bind_method(D_METHOD("add_candidates_from_bytecode", "bytecode"), &HatchNameRecovery::add_candidates_from_bytecode);
+
+	ClassDB::bind_method(D_METHOD("get_path_for_hash", "name_hash"), &HatchNameRecovery::get_path_for_hash);
+	ClassDB::bind_method(D_METHOD("get_recovered_paths"), &HatchNameRecovery::get_recovered_paths);
+	ClassDB::bind_method(D_METHOD("get_recovered_count"), &HatchNameRecovery::get_recovered_count);
+	ClassDB::bind_method(D_METHOD("clear"), &HatchNameRecovery::clear);
+
+	ClassDB::bind_method(D_METHOD("get_dictionary_path"), &HatchNameRecovery::get_dictionary_path);
+	ClassDB::bind_method(D_METHOD("save_dictionary", "path"), &HatchNameRecovery::save_dictionary, DEFVAL(String()));
+	ClassDB::bind_method(D_METHOD("load_dictionary", "path"), &HatchNameRecovery::load_dictionary, DEFVAL(String()));
+}
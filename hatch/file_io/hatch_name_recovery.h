@@ -0,0 +1,54 @@
+#ifndef HATCH_NAME_RECOVERY_H
+#define HATCH_NAME_RECOVERY_H
+
+#include "hatch_archive_reader.h"
+#include "../hsl/hsl_bytecode_reader.h"
+
+//Extension of the sidecar file written next to the archive
+#define HATCH_NAMES_EXTENSION ".names"
+
+//How many candidates are hashed per worker pool dispatch
+#define HATCH_NAME_RECOVERY_BATCH 65536
+
+/*
+ Archives only store the CRC32 of each file path, so this hashes lists of guessed paths
+ and keeps the ones that hit an entry. Recovered names are saved next to the archive, so
+ later opens can label entries without guessing again.
+ */
+class HatchNameRecovery : public RefCounted {
+	GDCLASS(HatchNameRecovery, RefCounted);
+
+	struct CandidateBatch {
+		const String *paths;
+		LocalVector<uint32_t> hashes;
+		LocalVector<uint8_t> matched;
+	};
+
+	Ref<HatchArchiveReader> archive;
+	HashMap<uint32_t, String> recovered;
+
+	void _hash_candidate(uint32_t p_index, CandidateBatch *p_batch);
+	int _match_batch(const String *p_paths, uint32_t p_count);
+
+protected:
+	static void _bind_methods();
+
+public:
+	void set_archive(const Ref<HatchArchiveReader> &p_archive);
+	Ref<HatchArchiveReader> get_archive() const;
+
+	int add_candidates(PackedStringArray paths);
+	int add_candidates_from_file(String wordlist_path);
+	int add_candidates_from_bytecode(Ref<HSLBytecodeReader> bytecode);
+
+	String get_path_for_hash(uint32_t hash);
+	Dictionary get_recovered_paths();
+	int get_recovered_count();
+	void clear();
+
+	String get_dictionary_path();
+	Error save_dictionary(String path = String());
+	int load_dictionary(String path = String());
+};
+
+#endif
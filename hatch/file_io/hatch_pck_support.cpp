@@ -210,20 +210,13 @@ bool PackSourceHatch::try_open_pack(const String &p_path, bool p_replace_files,
 
 	file->seek(p_offset);
 
-	uint8_t hatch_magic[5];
-	file->get_buffer(hatch_magic, 5);
+	HatchArchiveHeader header;
 
-	if (memcmp(hatch_magic, "HATCH", 5)) {
+	if (not HatchArchiveReader::read_header(file, header)) {
 		return false;
 	}
 
-	file->get_8(); //major version
-	file->get_8(); //minor version
-	file->get_8(); //patch version?
-
-	uint16_t file_count = file->get_16();
-
-	for (int cur_file = 0; cur_file < file_count; cur_file++){
+	for (uint32_t cur_file = 0; cur_file < header.file_count; cur_file++){
 
 		uint32_t crc_32 = file->get_32();
 		uint64_t file_offset = file->get_64();
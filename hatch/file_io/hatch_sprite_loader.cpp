@@ -0,0 +1,105 @@
+#include "hatch_sprite_loader.h"
+#include "hatch_archive_reader.h"
+#include "../image/hatch_gif_decoder.h"
+#include "../image/hatch_sprite_atlas.h"
+
+#include "core/config/project_settings.h"
+
+Ref<Resource> ResourceFormatLoaderHatchSprite::load(const String &p_path, const String &p_original_path, Error *r_error, bool p_use_sub_threads, float *r_progress, CacheMode p_cache_mode){
+	if (r_error){
+		*r_error = ERR_FILE_CANT_OPEN;
+	}
+
+	String extension = p_path.get_extension().to_lower();
+
+	if (extension == "bin"){
+		Ref<HatchSpriteAtlasBuilder> builder;
+		builder.instantiate();
+		builder->set_indexed(indexed);
+		builder->add_sprite(p_path);
+
+		Error err = builder->build();
+		if (r_error){
+			*r_error = err;
+		}
+		ERR_FAIL_COND_V(err != OK, Ref<Resource>());
+
+		Ref<SpriteFrames> frames = builder->get_sprite_frames(p_path);
+		if (indexed and frames.is_valid()){
+			//the material is null when the sprite's sheet had too many colors to index
+			frames->set_meta(SNAME("hatch_palette"), builder->get_palette());
+			frames->set_meta(SNAME("hatch_palette_material"), builder->get_sprite_material(p_path));
+		}
+		return frames;
+	}
+
+	PackedByteArray bytes;
+	Error err = HatchArchiveReader::load_path(p_path, bytes);
+	ERR_FAIL_COND_V_MSG(err != OK, Ref<Resource>(), "Could not read \"" + p_path + "\".");
+
+	Ref<Image> image;
+	Ref<HatchPalette> palette;
+	Ref<ShaderMaterial> material;
+
+	if (indexed){
+		LocalVector<uint32_t> colors;
+		image = HatchGIFDecoder::decode_sheet_indexed(bytes, colors);
+
+		if (image.is_valid()){
+			palette.instantiate();
+			material = palette->get_material(palette->add_row(colors.ptr(), colors.size()));
+		}
+	}
+
+	if (image.is_null()){
+		image = HatchGIFDecoder::decode_sheet(bytes);
+	}
+
+	if (r_error){
+		*r_error = image.is_valid() ? OK : ERR_FILE_CORRUPT;
+	}
+	ERR_FAIL_COND_V_MSG(image.is_null(), Ref<Resource>(), "Could not decode image \"" + p_path + "\".");
+
+	Ref<ImageTexture> texture = ImageTexture::create_from_image(image);
+	if (material.is_valid()){
+		texture->set_meta(SNAME("hatch_palette"), palette);
+		texture->set_meta(SNAME("hatch_palette_material"), material);
+	}
+	return texture;
+}
+
+void ResourceFormatLoaderHatchSprite::get_recognized_extensions(List<String> *p_extensions) const {
+	p_extensions->push_back("bin");
+	p_extensions->push_back("gif");
+}
+
+bool ResourceFormatLoaderHatchSprite::recognize_path(const String &p_path, const String &p_for_type) const {
+	String extension = p_path.get_extension().to_lower();
+
+	//.bin is far too generic to claim outside of the archive
+	if (p_path.begins_with(HATCH_FILE_PREFIX)){
+		return extension == "bin" or extension == "gif" or extension == "png";
+	}
+
+	return extension == "gif";
+}
+
+bool ResourceFormatLoaderHatchSprite::handles_type(const String &p_type) const {
+	return ClassDB::is_parent_class("SpriteFrames", p_type) or ClassDB::is_parent_class("ImageTexture", p_type);
+}
+
+String ResourceFormatLoaderHatchSprite::get_resource_type(const String &p_path) const {
+	String extension = p_path.get_extension().to_lower();
+
+	if (extension == "bin"){
+		return p_path.begins_with(HATCH_FILE_PREFIX) ? "SpriteFrames" : "";
+	}
+	if (extension == "gif" or (extension == "png" and p_path.begins_with(HATCH_FILE_PREFIX))){
+		return "ImageTexture";
+	}
+	return "";
+}
+
+ResourceFormatLoaderHatchSprite::ResourceFormatLoaderHatchSprite(){
+	indexed = GLOBAL_DEF("hatch/sprites/indexed", false);
+}
@@ -0,0 +1,31 @@
+#ifndef HATCH_SPRITE_LOADER_H
+#define HATCH_SPRITE_LOADER_H
+
+#include "core/io/resource_loader.h"
+
+/*
+ Loads Hatch sprite animations (.bin) as SpriteFrames and Hatch sheet images (GIF, or PNG
+ inside the mounted archive) as textures. Paths starting with "hatch://" are read from the
+ mounted HatchArchiveReader. A single sprite still goes through HatchSpriteAtlasBuilder, so
+ it gets a packed, disk-cached atlas; use the builder directly to share pages across sprites.
+
+ With hatch/sprites/indexed set, sprites and sheets load as 8-bit index textures instead of
+ RGBA. The resource then carries its HatchPalette and the ShaderMaterial that draws it as the
+ "hatch_palette" and "hatch_palette_material" metas.
+ */
+class ResourceFormatLoaderHatchSprite : public ResourceFormatLoader {
+	GDCLASS(ResourceFormatLoaderHatchSprite, ResourceFormatLoader);
+
+	bool indexed = false;
+
+public:
+	virtual Ref<Resource> load(const String &p_path, const String &p_original_path = "", Error *r_error = nullptr, bool p_use_sub_threads = false, float *r_progress = nullptr, CacheMode p_cache_mode = CACHE_MODE_REUSE) override;
+	virtual void get_recognized_extensions(List<String> *p_extensions) const override;
+	virtual bool recognize_path(const String &p_path, const String &p_for_type = String()) const override;
+	virtual bool handles_type(const String &p_type) const override;
+	virtual String get_resource_type(const String &p_path) const override;
+
+	ResourceFormatLoaderHatchSprite();
+};
+
+#endif
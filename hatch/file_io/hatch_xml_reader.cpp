@@ -0,0 +1,473 @@
+#include "hatch_xml_reader.h"
+
+#include "core/templates/hashfuncs.h"
+
+static _FORCE_INLINE_ bool _is_space(char c){
+	return c == ' ' or c == '\t' or c == '\n' or c == '\r';
+}
+
+static _FORCE_INLINE_ bool _is_name_end(char c){
+	return _is_space(c) or c == '/' or c == '>' or c == '=';
+}
+
+bool HatchXMLSpan::operator==(const char *p_str) const {
+	for (uint32_t i = 0; i < length; i++){
+		if (p_str[i] != ptr[i]){
+			return false;
+		}
+	}
+
+	return p_str[length] == 0;
+}
+
+int64_t HatchXMLSpan::to_int() const {
+	uint32_t i = 0;
+	while (i < length and _is_space(ptr[i])){
+		i++;
+	}
+
+	bool negative = false;
+	if (i < length and (ptr[i] == '-' or ptr[i] == '+')){
+		negative = ptr[i] == '-';
+		i++;
+	}
+
+	int64_t value = 0;
+	for (; i < length and ptr[i] >= '0' and ptr[i] <= '9'; i++){
+		value = value * 10 + (ptr[i] - '0');
+	}
+
+	return negative ? -value : value;
+}
+
+double HatchXMLSpan::to_float() const {
+	//numbers in attributes are short, anything longer isn't a number we'd use
+	char buffer[64];
+	uint32_t count = MIN(length, (uint32_t)sizeof(buffer) - 1);
+	memcpy(buffer, ptr, count);
+	buffer[count] = 0;
+
+	return String::to_float(buffer);
+}
+
+static void _append_utf8(LocalVector<char> &r_out, uint32_t p_code){
+	if (p_code < 0x80){
+		r_out.push_back(p_code);
+	} else if (p_code < 0x800){
+		r_out.push_back(0xC0 | (p_code >> 6));
+		r_out.push_back(0x80 | (p_code & 0x3F));
+	} else if (p_code < 0x10000){
+		r_out.push_back(0xE0 | (p_code >> 12));
+		r_out.push_back(0x80 | ((p_code >> 6) & 0x3F));
+		r_out.push_back(0x80 | (p_code & 0x3F));
+	} else {
+		r_out.push_back(0xF0 | (p_code >> 18));
+		r_out.push_back(0x80 | ((p_code >> 12) & 0x3F));
+		r_out.push_back(0x80 | ((p_code >> 6) & 0x3F));
+		r_out.push_back(0x80 | (p_code & 0x3F));
+	}
+}
+
+String HatchXMLSpan::to_string() const {
+	if (length == 0){
+		return String();
+	}
+	if (memchr(ptr, '&', length) == nullptr){
+		return String::utf8(ptr, length);
+	}
+
+	LocalVector<char> decoded;
+	decoded.reserve(length);
+
+	for (uint32_t i = 0; i < length; i++){
+		if (ptr[i] != '&'){
+			decoded.push_back(ptr[i]);
+			continue;
+		}
+
+		const char *semicolon = (const char *)memchr(ptr + i, ';', length - i);
+		if (semicolon == nullptr){
+			decoded.push_back('&');
+			continue;
+		}
+
+		HatchXMLSpan entity;
+		entity.ptr = ptr + i + 1;
+		entity.length = semicolon - entity.ptr;
+
+		if (entity == "amp"){
+			decoded.push_back('&');
+		} else if (entity == "lt"){
+			decoded.push_back('<');
+		} else if (entity == "gt"){
+			decoded.push_back('>');
+		} else if (entity == "quot"){
+			decoded.push_back('"');
+		} else if (entity == "apos"){
+			decoded.push_back('\'');
+		} else if (entity.length > 1 and entity.ptr[0] == '#'){
+			uint32_t code = 0;
+			bool hex = entity.ptr[1] == 'x' or entity.ptr[1] == 'X';
+
+			for (uint32_t j = hex ? 2 : 1; j < entity.length; j++){
+				char c = entity.ptr[j];
+				if (c >= '0' and c <= '9'){
+					code = code * (hex ? 16 : 10) + (c - '0');
+				} else if (hex and c >= 'a' and c <= 'f'){
+					code = code * 16 + (c - 'a' + 10);
+				} else if (hex and c >= 'A' and c <= 'F'){
+					code = code * 16 + (c - 'A' + 10);
+				}
+			}
+
+			_append_utf8(decoded, MIN(code, 0x10FFFFU));
+		} else {
+			//unknown entities are kept as written, the same as XMLParser does
+			decoded.push_back('&');
+			continue;
+		}
+
+		i = semicolon - ptr;
+	}
+
+	return String::utf8(decoded.ptr(), decoded.size());
+}
+
+HatchXMLNames::HatchXMLNames(){
+	offsets.push_back(0);
+	offsets.push_back(0);
+	hashes.push_back(0);
+
+	slots.resize(64);
+	memset(slots.ptr(), 0, slots.size() * sizeof(Slot));
+}
+
+void HatchXMLNames::_insert_slot(uint32_t p_hash, uint32_t p_id){
+	uint32_t mask = slots.size() - 1;
+	uint32_t index = p_hash & mask;
+
+	while (slots[index].id != 0){
+		index = (index + 1) & mask;
+	}
+
+	slots[index].hash = p_hash;
+	slots[index].id = p_id;
+}
+
+uint32_t HatchXMLNames::intern(const char *p_name, uint32_t p_length){
+	uint32_t hash = hash_djb2_buffer((const uint8_t *)p_name, p_length);
+	uint32_t mask = slots.size() - 1;
+
+	for (uint32_t index = hash & mask; slots[index].id != 0; index = (index + 1) & mask){
+		const Slot &slot = slots[index];
+		if (slot.hash != hash){
+			continue;
+		}
+
+		uint32_t start = offsets[slot.id];
+		if (offsets[slot.id + 1] - start == p_length and memcmp(storage.ptr() + start, p_name, p_length) == 0){
+			return slot.id;
+		}
+	}
+
+	uint32_t id = size();
+
+	uint32_t start = storage.size();
+	storage.resize(start + p_length);
+	memcpy(storage.ptr() + start, p_name, p_length);
+	offsets.push_back(storage.size());
+	hashes.push_back(hash);
+
+	//keep the table at most half full so probes stay short
+	if ((id + 1) * 2 > slots.size()){
+		slots.resize(slots.size() * 2);
+		memset(slots.ptr(), 0, slots.size() * sizeof(Slot));
+
+		for (uint32_t i = 1; i < id; i++){
+			_insert_slot(hashes[i], i);
+		}
+	}
+
+	_insert_slot(hash, id);
+	return id;
+}
+
+HatchXMLSpan HatchXMLNames::get_name(uint32_t p_id) const {
+	HatchXMLSpan span;
+	ERR_FAIL_UNSIGNED_INDEX_V(p_id, size(), span);
+
+	span.ptr = storage.ptr() + offsets[p_id];
+	span.length = offsets[p_id + 1] - offsets[p_id];
+	return span;
+}
+
+HatchXMLReader::HatchXMLReader(const uint8_t *p_data, uint32_t p_size, HatchXMLNames &p_names) :
+		data((const char *)p_data), end((const char *)p_data + p_size), pos((const char *)p_data), names(p_names){
+	//UTF-8 byte order mark
+	if (p_size >= 3 and p_data[0] == 0xEF and p_data[1] == 0xBB and p_data[2] == 0xBF){
+		pos += 3;
+	}
+}
+
+HatchXMLReader::Event HatchXMLReader::_fail(const String &p_message){
+	error = vformat("%s (line %d)", p_message, get_line());
+	failed = true;
+	pos = end;
+	return EVENT_ERROR;
+}
+
+const char *HatchXMLReader::_find(const char *p_from, const char *p_needle, uint32_t p_length) const {
+	while (end - p_from >= (int64_t)p_length){
+		const char *candidate = (const char *)memchr(p_from, p_needle[0], end - p_from - p_length + 1);
+		if (candidate == nullptr){
+			return nullptr;
+		}
+		if (memcmp(candidate, p_needle, p_length) == 0){
+			return candidate;
+		}
+		p_from = candidate + 1;
+	}
+
+	return nullptr;
+}
+
+HatchXMLReader::Event HatchXMLReader::_read_start(){
+	pos++;
+
+	const char *name_start = pos;
+	while (pos < end and not _is_name_end(*pos)){
+		pos++;
+	}
+	if (pos == name_start or pos >= end){
+		return _fail("Invalid element name");
+	}
+
+	name = names.intern(name_start, pos - name_start);
+	attribute_count = 0;
+
+	while (true){
+		while (pos < end and _is_space(*pos)){
+			pos++;
+		}
+		if (pos >= end){
+			return _fail("Unterminated element");
+		}
+
+		if (*pos == '>'){
+			pos++;
+			break;
+		}
+		if (*pos == '/'){
+			if (pos + 1 >= end or pos[1] != '>'){
+				return _fail("Invalid element");
+			}
+			pos += 2;
+			pending_end = true;
+			break;
+		}
+
+		const char *attribute_start = pos;
+		while (pos < end and not _is_name_end(*pos)){
+			pos++;
+		}
+		if (pos == attribute_start){
+			return _fail("Invalid attribute name");
+		}
+		uint32_t attribute_name = names.intern(attribute_start, pos - attribute_start);
+
+		while (pos < end and _is_space(*pos)){
+			pos++;
+		}
+		if (pos >= end or *pos != '='){
+			return _fail("Attribute without a value");
+		}
+		pos++;
+		while (pos < end and _is_space(*pos)){
+			pos++;
+		}
+		if (pos >= end or (*pos != '"' and *pos != '\'')){
+			return _fail("Unquoted attribute value");
+		}
+
+		char quote = *pos++;
+		const char *value_end = (const char *)memchr(pos, quote, end - pos);
+		if (value_end == nullptr){
+			return _fail("Unterminated attribute value");
+		}
+		if (attribute_count >= HATCH_XML_MAX_ATTRIBUTES){
+			return _fail("Too many attributes");
+		}
+
+		Attribute &attribute = attributes[attribute_count++];
+		attribute.name = attribute_name;
+		attribute.value.ptr = pos;
+		attribute.value.length = value_end - pos;
+
+		pos = value_end + 1;
+	}
+
+	open_elements.push_back(name);
+	return EVENT_START;
+}
+
+HatchXMLReader::Event HatchXMLReader::_read_end(){
+	pos += 2;
+
+	const char *name_start = pos;
+	while (pos < end and not _is_name_end(*pos)){
+		pos++;
+	}
+	uint32_t end_name = names.intern(name_start, pos - name_start);
+
+	while (pos < end and _is_space(*pos)){
+		pos++;
+	}
+	if (pos >= end or *pos != '>'){
+		return _fail("Unterminated closing tag");
+	}
+	pos++;
+
+	if (open_elements.is_empty() or open_elements[open_elements.size() - 1] != end_name){
+		return _fail("Mismatched closing tag");
+	}
+
+	open_elements.resize(open_elements.size() - 1);
+	name = end_name;
+	attribute_count = 0;
+	return EVENT_END;
+}
+
+HatchXMLReader::Event HatchXMLReader::next(){
+	if (failed){
+		return EVENT_ERROR;
+	}
+
+	if (pending_end){
+		pending_end = false;
+		open_elements.resize(open_elements.size() - 1);
+		attribute_count = 0;
+		return EVENT_END;
+	}
+
+	while (pos < end){
+		if (*pos != '<'){
+			const char *text_start = pos;
+			bool blank = true;
+
+			while (pos < end and *pos != '<'){
+				blank = blank and _is_space(*pos);
+				pos++;
+			}
+
+			if (blank){
+				continue;
+			}
+
+			text.ptr = text_start;
+			text.length = pos - text_start;
+			cdata = false;
+			return EVENT_TEXT;
+		}
+
+		if (pos + 1 >= end){
+			return _fail("Unexpected end of XML");
+		}
+
+		switch (pos[1]){
+			case '/':
+				return _read_end();
+			case '?': {
+				const char *close = _find(pos + 2, "?>", 2);
+				if (close == nullptr){
+					return _fail("Unterminated processing instruction");
+				}
+				pos = close + 2;
+			} break;
+			case '!': {
+				if (end - pos >= 4 and memcmp(pos, "<!--", 4) == 0){
+					const char *close = _find(pos + 4, "-->", 3);
+					if (close == nullptr){
+						return _fail("Unterminated comment");
+					}
+					pos = close + 3;
+				} else if (end - pos >= 9 and memcmp(pos, "<![CDATA[", 9) == 0){
+					const char *close = _find(pos + 9, "]]>", 3);
+					if (close == nullptr){
+						return _fail("Unterminated CDATA");
+					}
+
+					text.ptr = pos + 9;
+					text.length = close - text.ptr;
+					cdata = true;
+					pos = close + 3;
+					return EVENT_TEXT;
+				} else {
+					//doctype, possibly with an internal subset in brackets
+					int brackets = 0;
+					pos += 2;
+					while (pos < end and (*pos != '>' or brackets > 0)){
+						brackets += *pos == '[' ? 1 : (*pos == ']' ? -1 : 0);
+						pos++;
+					}
+					if (pos >= end){
+						return _fail("Unterminated declaration");
+					}
+					pos++;
+				}
+			} break;
+			default:
+				return _read_start();
+		}
+	}
+
+	if (not open_elements.is_empty()){
+		return _fail("Unexpected end of XML inside an element");
+	}
+
+	return EVENT_EOF;
+}
+
+Error HatchXMLReader::skip_element(){
+	ERR_FAIL_COND_V(open_elements.is_empty(), ERR_INVALID_PARAMETER);
+
+	uint32_t depth = open_elements.size() - 1;
+
+	while (true){
+		Event event = next();
+		if (event == EVENT_ERROR or event == EVENT_EOF){
+			return ERR_FILE_CORRUPT;
+		}
+		if (event == EVENT_END and open_elements.size() == depth){
+			return OK;
+		}
+	}
+}
+
+bool HatchXMLReader::has_attribute(uint32_t p_name) const {
+	for (uint32_t i = 0; i < attribute_count; i++){
+		if (attributes[i].name == p_name){
+			return true;
+		}
+	}
+
+	return false;
+}
+
+HatchXMLSpan HatchXMLReader::get_attribute(uint32_t p_name) const {
+	for (uint32_t i = 0; i < attribute_count; i++){
+		if (attributes[i].name == p_name){
+			return attributes[i].value;
+		}
+	}
+
+	return HatchXMLSpan();
+}
+
+int HatchXMLReader::get_line() const {
+	int line = 1;
+	for (const char *c = data; c < pos; c++){
+		line += *c == '\n';
+	}
+
+	return line;
+}
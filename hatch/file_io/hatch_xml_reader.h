@@ -0,0 +1,127 @@
+#ifndef HATCH_XML_READER_H
+#define HATCH_XML_READER_H
+
+#include "core/string/ustring.h"
+#include "core/templates/local_vector.h"
+
+//More attributes than this on one element is treated as corrupt data
+#define HATCH_XML_MAX_ATTRIBUTES 32
+
+//A view into the document bytes, only valid while the buffer is
+struct HatchXMLSpan {
+	const char *ptr = nullptr;
+	uint32_t length = 0;
+
+	bool is_empty() const { return length == 0; }
+	bool operator==(const char *p_str) const;
+	bool operator!=(const char *p_str) const { return not (*this == p_str); }
+
+	int64_t to_int() const;
+	double to_float() const;
+
+	//Decodes entities and UTF-8; the only part of the reader that allocates
+	String to_string() const;
+};
+
+/*
+ Interns element and attribute names to small integer ids. Handlers intern the names they
+ care about once, up front, and then compare ids instead of strings. Id 0 is never handed
+ out, so it can stand for "no name".
+ */
+class HatchXMLNames {
+	struct Slot {
+		uint32_t hash;
+		uint32_t id;
+	};
+
+	LocalVector<char> storage;
+	LocalVector<uint32_t> offsets; //name i is storage[offsets[i], offsets[i + 1])
+	LocalVector<uint32_t> hashes;
+	LocalVector<Slot> slots;
+
+	void _insert_slot(uint32_t p_hash, uint32_t p_id);
+
+public:
+	uint32_t intern(const char *p_name, uint32_t p_length);
+	uint32_t intern(const char *p_name) { return intern(p_name, strlen(p_name)); }
+
+	//Invalidated by the next intern()
+	HatchXMLSpan get_name(uint32_t p_id) const;
+	uint32_t size() const { return offsets.size() - 1; }
+
+	HatchXMLNames();
+};
+
+/*
+ Pull parser that walks XML straight out of a byte buffer, such as an archive entry, without
+ copying it or building a tree. Every call to next() reports one element start, element end
+ or run of text; names come back interned and attribute values and text as spans into the
+ buffer, so a handler only allocates for the strings it decides to keep.
+
+ <a/> is reported as a start followed by an end. Whitespace-only text, comments, processing
+ instructions and the doctype are skipped. CDATA comes back as text with is_cdata() set.
+ Entities are left in place until HatchXMLSpan::to_string(). Encodings other than UTF-8
+ aren't supported.
+ */
+class HatchXMLReader {
+public:
+	enum Event {
+		EVENT_START,
+		EVENT_END,
+		EVENT_TEXT,
+		EVENT_EOF,
+		EVENT_ERROR,
+	};
+
+	struct Attribute {
+		uint32_t name;
+		HatchXMLSpan value;
+	};
+
+private:
+	const char *data;
+	const char *end;
+	const char *pos;
+	HatchXMLNames &names;
+
+	LocalVector<uint32_t> open_elements;
+	uint32_t name = 0;
+	Attribute attributes[HATCH_XML_MAX_ATTRIBUTES];
+	uint32_t attribute_count = 0;
+	HatchXMLSpan text;
+	bool cdata = false;
+	bool pending_end = false;
+
+	bool failed = false;
+	String error;
+
+	Event _fail(const String &p_message);
+	const char *_find(const char *p_from, const char *p_needle, uint32_t p_length) const;
+	Event _read_start();
+	Event _read_end();
+
+public:
+	Event next();
+
+	//Called right after EVENT_START, reads up to and including the matching end
+	Error skip_element();
+
+	uint32_t get_name() const { return name; }
+	uint32_t get_depth() const { return open_elements.size(); }
+
+	uint32_t get_attribute_count() const { return attribute_count; }
+	const Attribute &get_attribute_at(uint32_t p_index) const { return attributes[p_index]; }
+	bool has_attribute(uint32_t p_name) const;
+	//An empty span if the attribute is missing
+	HatchXMLSpan get_attribute(uint32_t p_name) const;
+
+	const HatchXMLSpan &get_text() const { return text; }
+	bool is_cdata() const { return cdata; }
+
+	int get_line() const;
+	const String &get_error() const { return error; }
+
+	HatchXMLReader(const uint8_t *p_data, uint32_t p_size, HatchXMLNames &p_names);
+};
+
+#endif
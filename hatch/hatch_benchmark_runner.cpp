@@ -0,0 +1,359 @@
+#include "hatch_benchmark_runner.h"
+#include "hatch_performance.h"
+#include "file_io/hatch_archive_reader.h"
+
+#include "core/input/input.h"
+#include "core/io/file_access.h"
+#include "core/io/json.h"
+#include "core/io/resource_loader.h"
+#include "core/os/memory.h"
+#include "core/os/os.h"
+#include "scene/main/window.h"
+#include "scene/resources/packed_scene.h"
+#include "servers/physics_server_2d.h"
+#include "servers/physics_server_3d.h"
+
+void HatchBenchmarkRunner::_parse_arguments(){
+	List<String> args = OS::get_singleton()->get_cmdline_user_args();
+
+	for (const String &arg : args){
+		String value = arg.substr(arg.find("=") + 1);
+
+		if (arg.begins_with("--archive=")){
+			archive_path = value;
+		} else if (arg.begins_with("--bytecode=")){
+			bytecode_paths = value.split(",", false);
+		} else if (arg.begins_with("--scene=")){
+			scene_path = value;
+		} else if (arg.begins_with("--input=")){
+			input_path = value;
+		} else if (arg.begins_with("--output=")){
+			output_path = value;
+		} else if (arg.begins_with("--baseline=")){
+			baseline_path = value;
+		} else if (arg.begins_with("--frames=")){
+			frame_count = MAX(value.to_int(), 1);
+		} else if (arg.begins_with("--warmup=")){
+			warmup_frames = MAX(value.to_int(), 0);
+		} else if (arg.begins_with("--fps=")){
+			fps = MAX(value.to_int(), 1);
+		} else if (arg.begins_with("--seed=")){
+			seed = value.to_int();
+		} else if (arg.begins_with("--tolerance=")){
+			tolerance = MAX(value.to_float(), 0.0);
+		} else {
+			WARN_PRINT("Unknown benchmark option \"" + arg + "\".");
+		}
+	}
+}
+
+Error HatchBenchmarkRunner::_load_input(){
+	if (input_path.is_empty()){
+		return OK;
+	}
+
+	Error err = OK;
+	String text = FileAccess::get_file_as_string(input_path, &err);
+	ERR_FAIL_COND_V_MSG(err != OK, err, "Could not read recorded input \"" + input_path + "\".");
+
+	Variant parsed = JSON::parse_string(text);
+	ERR_FAIL_COND_V_MSG(parsed.get_type() != Variant::ARRAY, ERR_PARSE_ERROR, "Recorded input must be a JSON array.");
+
+	Array events = parsed;
+	for (int i = 0; i < events.size(); i++){
+		Dictionary entry = events[i];
+
+		InputEvent event;
+		event.frame = entry.get("frame", 0);
+		event.action = String(entry.get("action", ""));
+		event.pressed = entry.get("pressed", true);
+		event.strength = entry.get("strength", 1.0);
+
+		if (event.action == StringName()){
+			continue;
+		}
+
+		//insertion sort keeps events on the same frame in file order, so press then release works
+		uint32_t index = input_events.size();
+		input_events.push_back(event);
+		while (index > 0 and input_events[index - 1].frame > event.frame){
+			input_events[index] = input_events[index - 1];
+			index--;
+		}
+		input_events[index] = event;
+	}
+
+	return OK;
+}
+
+void HatchBenchmarkRunner::_boot(){
+	uint64_t start = OS::get_singleton()->get_ticks_usec();
+
+	if (not archive_path.is_empty()){
+		Ref<HatchArchiveReader> archive;
+		archive.instantiate();
+		archive->load(archive_path);
+
+		if (archive->get_file_count() > 0){
+			archive->mount();
+		} else {
+			ERR_PRINT("Could not mount Hatch archive \"" + archive_path + "\".");
+		}
+	}
+
+	for (const String &path : bytecode_paths){
+		Ref<HSLBytecodeReader> reader;
+		reader.instantiate();
+		if (reader->load_file(path) != OK){
+			continue;
+		}
+		bytecode.push_back(reader);
+	}
+
+	if (not scene_path.is_empty()){
+		Ref<PackedScene> scene = ResourceLoader::load(scene_path);
+		if (scene.is_valid()){
+			Node *node = scene->instantiate();
+			get_root()->add_child(node);
+			set_current_scene(node);
+		} else {
+			ERR_PRINT("Could not load benchmark scene \"" + scene_path + "\".");
+		}
+	}
+
+	boot_usec = OS::get_singleton()->get_ticks_usec() - start;
+}
+
+void HatchBenchmarkRunner::_step_physics(double p_delta){
+	PhysicsServer2D *physics_2d = PhysicsServer2D::get_singleton();
+	PhysicsServer3D *physics_3d = PhysicsServer3D::get_singleton();
+
+	//the servers are only active for this step, so the ticks the engine still runs off the
+	//wall clock step nothing; the order is the one Main::iteration uses
+	if (physics_3d != nullptr){
+		physics_3d->set_active(true);
+		physics_3d->sync();
+		physics_3d->flush_queries();
+	}
+	if (physics_2d != nullptr){
+		physics_2d->set_active(true);
+		physics_2d->sync();
+		physics_2d->flush_queries();
+	}
+
+	if (SceneTree::physics_process(p_delta)){
+		quit_requested = true;
+	}
+
+	if (physics_2d != nullptr){
+		physics_2d->end_sync();
+		physics_2d->step(p_delta);
+		physics_2d->set_active(false);
+	}
+	if (physics_3d != nullptr){
+		physics_3d->end_sync();
+		physics_3d->step(p_delta);
+		physics_3d->set_active(false);
+	}
+}
+
+void HatchBenchmarkRunner::_apply_input(){
+	Input *input = Input::get_singleton();
+
+	while (next_input < input_events.size() and input_events[next_input].frame <= frame){
+		const InputEvent &event = input_events[next_input++];
+
+		if (event.pressed){
+			input->action_press(event.action, event.strength);
+		} else {
+			input->action_release(event.action);
+		}
+	}
+}
+
+Dictionary HatchBenchmarkRunner::_percentiles(const LocalVector<uint64_t> &p_samples){
+	Dictionary out;
+	if (p_samples.is_empty()){
+		return out;
+	}
+
+	LocalVector<uint64_t> sorted = p_samples;
+	sorted.sort();
+
+	uint64_t total = 0;
+	for (uint64_t sample : sorted){
+		total += sample;
+	}
+
+	uint32_t last = sorted.size() - 1;
+	out["min"] = sorted[0];
+	out["p50"] = sorted[(uint32_t)Math::round(last * 0.5)];
+	out["p90"] = sorted[(uint32_t)Math::round(last * 0.9)];
+	out["p99"] = sorted[(uint32_t)Math::round(last * 0.99)];
+	out["max"] = sorted[last];
+	out["mean"] = (double)total / sorted.size();
+	return out;
+}
+
+Dictionary HatchBenchmarkRunner::_make_report(){
+	Dictionary report;
+	report["frames"] = frame_usec.size();
+	report["warmup_frames"] = warmup_frames;
+	report["fps"] = fps;
+	report["seed"] = seed;
+	report["archive"] = archive_path;
+	report["scene"] = scene_path;
+	report["boot_usec"] = boot_usec;
+	report["frame_usec"] = _percentiles(frame_usec);
+
+	Dictionary subsystems;
+	subsystems["physics_usec"] = _percentiles(physics_usec);
+	subsystems["process_usec"] = _percentiles(process_usec);
+	report["subsystems"] = subsystems;
+
+	//module counters over the measured frames only; timers are in milliseconds
+	Dictionary counters_end = HatchPerformance::get_counters();
+	Dictionary counters;
+	for (const KeyValue<Variant, Variant> &E : counters_end){
+		counters[E.key] = (double)E.value - (double)counters_start.get(E.key, 0);
+	}
+	report["counters"] = counters;
+	report["hsl_heap_allocations"] = counters.get("hsl_heap_allocations", 0);
+
+	Dictionary memory;
+#ifdef DEBUG_ENABLED
+	memory["available"] = true;
+	memory["static_start"] = memory_start;
+	memory["static_end"] = Memory::get_mem_usage();
+	memory["static_peak"] = Memory::get_mem_max_usage();
+#else
+	//the engine only tracks its allocations in debug builds, and 0 would read as a real figure
+	memory["available"] = false;
+#endif
+	report["memory"] = memory;
+
+	return report;
+}
+
+int HatchBenchmarkRunner::_compare_baseline(const Dictionary &p_report){
+	Error err = OK;
+	String text = FileAccess::get_file_as_string(baseline_path, &err);
+	ERR_FAIL_COND_V_MSG(err != OK, 1, "Could not read benchmark baseline \"" + baseline_path + "\".");
+
+	Dictionary baseline = JSON::parse_string(text);
+	Dictionary baseline_frames = baseline.get("frame_usec", Dictionary());
+	Dictionary frames = p_report.get("frame_usec", Dictionary());
+
+	int exit_code = 0;
+	const char *keys[2] = { "p50", "p99" };
+
+	for (const char *key : keys){
+		double before = baseline_frames.get(key, 0.0);
+		double now = frames.get(key, 0.0);
+
+		if (before > 0.0 and now > before * (1.0 + tolerance)){
+			ERR_PRINT(vformat("Frame time %s regressed from %d to %d usec.", key, (int64_t)before, (int64_t)now));
+			exit_code = 1;
+		}
+	}
+
+	return exit_code;
+}
+
+void HatchBenchmarkRunner::_finish(){
+	finished = true;
+
+	Dictionary report = _make_report();
+
+	int exit_code = 0;
+	if (not baseline_path.is_empty()){
+		exit_code = _compare_baseline(report);
+		report["baseline"] = baseline_path;
+		report["regressed"] = exit_code != 0;
+	}
+
+	String json = JSON::stringify(report, "\t");
+
+	if (output_path.is_empty()){
+		print_line(json);
+	} else {
+		Ref<FileAccess> file = FileAccess::open(output_path, FileAccess::WRITE);
+		if (file.is_valid()){
+			file->store_string(json);
+		} else {
+			ERR_PRINT("Could not write benchmark report to \"" + output_path + "\".");
+			exit_code = 1;
+		}
+	}
+
+	OS::get_singleton()->set_exit_code(exit_code);
+}
+
+void HatchBenchmarkRunner::initialize(){
+	_parse_arguments();
+
+	SceneTree::initialize();
+
+	Math::seed(seed);
+	Engine::get_singleton()->set_physics_ticks_per_second(fps);
+	Engine::get_singleton()->set_time_scale(1.0);
+
+	//stepped only from process(), one fixed step per frame
+	if (PhysicsServer2D::get_singleton() != nullptr){
+		PhysicsServer2D::get_singleton()->set_active(false);
+	}
+	if (PhysicsServer3D::get_singleton() != nullptr){
+		PhysicsServer3D::get_singleton()->set_active(false);
+	}
+
+	frame_usec.reserve(frame_count);
+	physics_usec.reserve(frame_count);
+	process_usec.reserve(frame_count);
+
+	_boot();
+
+	if (_load_input() != OK){
+		input_events.clear();
+	}
+}
+
+bool HatchBenchmarkRunner::physics_process(double p_time){
+	//the engine's own physics ticks follow the wall clock, process() runs them on a fixed step instead
+	return finished;
+}
+
+bool HatchBenchmarkRunner::process(double p_time){
+	if (finished){
+		return true;
+	}
+
+	if (frame == warmup_frames){
+		counters_start = HatchPerformance::get_counters();
+		memory_start = Memory::get_mem_usage();
+	}
+
+	double delta = 1.0 / fps;
+	_apply_input();
+
+	uint64_t start = OS::get_singleton()->get_ticks_usec();
+	_step_physics(delta);
+	uint64_t physics_end = OS::get_singleton()->get_ticks_usec();
+	//the HSLScheduler ticks at the end of this, with the same delta
+	quit_requested = SceneTree::process(delta) or quit_requested;
+	uint64_t end = OS::get_singleton()->get_ticks_usec();
+
+	if (frame >= warmup_frames){
+		frame_usec.push_back(end - start);
+		physics_usec.push_back(physics_end - start);
+		process_usec.push_back(end - physics_end);
+	}
+
+	frame++;
+
+	if (quit_requested or frame >= warmup_frames + frame_count){
+		_finish();
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,92 @@
+#ifndef HATCH_BENCHMARK_RUNNER_H
+#define HATCH_BENCHMARK_RUNNER_H
+
+#include "hsl/hsl_bytecode_reader.h"
+
+#include "core/templates/local_vector.h"
+#include "scene/main/scene_tree.h"
+
+/*
+ A SceneTree that runs a fixed number of frames with a fixed timestep and reports how long
+ they took as JSON, for CI:
+
+   godot --headless --main-loop HatchBenchmarkRunner -- --archive=Data.hatch --frames=600
+
+ Options, after "--":
+   --archive=<path>       mount a .hatch archive before anything else loads
+   --bytecode=<a,b,...>   HSL bytecode to load at boot, usually hatch:// paths; this only
+                          loads it, nothing in it is run
+   --scene=<path>         scene to run instead of the project's main scene
+   --input=<path>         JSON array of {"frame", "action", "pressed", "strength"} to replay
+   --frames=<n>           measured frames (600), after --warmup=<n> unmeasured ones (60)
+   --fps=<n>              simulated frames per second (60)
+   --seed=<n>             random seed (0)
+   --output=<path>        write the report there instead of printing it
+   --baseline=<path>      earlier report to compare against; with --tolerance=<fraction>
+                          (0.1), a p50 or p99 frame time that got slower exits with code 1
+
+ Every frame gets exactly one physics step and one process step, which ends with the
+ HSLScheduler tick, with the same delta no matter how long the previous frame took, so runs
+ replay the same simulation. The physics servers are kept inactive outside that step, so the
+ ticks the engine still schedules off the wall clock advance nothing.
+
+ The report's allocation figure counts the HSL runtime's own trips to the heap (arena chunks,
+ frame and object pool blocks, oversized objects), not engine allocations. Engine memory is
+ only tracked in debug builds, so release builds mark it unavailable rather than report 0.
+ */
+class HatchBenchmarkRunner : public SceneTree {
+	GDCLASS(HatchBenchmarkRunner, SceneTree);
+
+	struct InputEvent {
+		int frame;
+		StringName action;
+		bool pressed;
+		float strength;
+	};
+
+	String archive_path;
+	PackedStringArray bytecode_paths;
+	String scene_path;
+	String input_path;
+	String output_path;
+	String baseline_path;
+	int frame_count = 600;
+	int warmup_frames = 60;
+	int fps = 60;
+	int64_t seed = 0;
+	double tolerance = 0.1;
+
+	LocalVector<Ref<HSLBytecodeReader>> bytecode;
+	LocalVector<InputEvent> input_events;
+	uint32_t next_input = 0;
+
+	int frame = 0;
+	uint64_t boot_usec = 0;
+	LocalVector<uint64_t> frame_usec;
+	LocalVector<uint64_t> physics_usec;
+	LocalVector<uint64_t> process_usec;
+
+	Dictionary counters_start;
+	uint64_t memory_start = 0;
+
+	bool finished = false;
+	bool quit_requested = false;
+
+	void _parse_arguments();
+	Error _load_input();
+	void _boot();
+	void _step_physics(double p_delta);
+	void _apply_input();
+
+	static Dictionary _percentiles(const LocalVector<uint64_t> &p_samples);
+	Dictionary _make_report();
+	int _compare_baseline(const Dictionary &p_report);
+	void _finish();
+
+public:
+	virtual void initialize() override;
+	virtual bool physics_process(double p_time) override;
+	virtual bool process(double p_time) override;
+};
+
+#endif
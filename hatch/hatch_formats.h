@@ -0,0 +1,12 @@
+#ifndef HATCH_FORMATS_H
+#define HATCH_FORMATS_H
+
+//Magics of the file formats more than one part of the module has to recognise, such as the
+//archive type index, which sniffs them without depending on the code that reads them
+
+//Objects.hcm, the class map the Hatch compiler writes next to the bytecode
+#define HSL_CLASS_MAP_MAGIC "HMAP"
+//Sprite animation .bin
+#define HATCH_SPRITE_MAGIC "SPR"
+
+#endif
@@ -0,0 +1,179 @@
+#include "hatch_performance.h"
+#include "core/io/file_access.h"
+#include "core/object/class_db.h"
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "main/performance.h"
+
+SafeNumeric<uint64_t> HatchPerformance::counters[COUNTER_MAX];
+
+const char *HatchPerformance::counter_names[COUNTER_MAX] = {
+	"archive_bytes_read",
+	"archive_entries_loaded",
+	"archive_decrypt_ms",
+	"archive_inflate_ms",
+	"archive_lookups_found",
+	"archive_lookups_missing",
+	"hsl_functions_parsed",
+	"hsl_parse_ms",
+	"hsl_bytes_held",
+	"hsl_heap_allocations",
+	"hsl_arena_bytes_reserved",
+	"hsl_arena_peak_bytes",
+	"hsl_pool_bytes_reserved",
+	"xml_parse_ms",
+	"hsl_shapes",
+	"hsl_instance_bytes",
+};
+
+SafeFlag HatchPerformance::tracing;
+Mutex HatchPerformance::trace_mutex;
+LocalVector<HatchPerformance::TraceEvent> HatchPerformance::trace_events;
+
+//Counters that describe live state rather than accumulating
+static bool _is_live_counter(int p_counter){
+	return p_counter == HatchPerformance::HSL_BYTES_HELD or p_counter == HatchPerformance::HSL_ARENA_BYTES_RESERVED or p_counter == HatchPerformance::HSL_POOL_BYTES_RESERVED or p_counter == HatchPerformance::HSL_SHAPES or p_counter == HatchPerformance::HSL_INSTANCE_BYTES;
+}
+
+static bool _is_usec_counter(int p_counter){
+	return p_counter == HatchPerformance::ARCHIVE_DECRYPT_USEC or p_counter == HatchPerformance::ARCHIVE_INFLATE_USEC or p_counter == HatchPerformance::HSL_PARSE_USEC or p_counter == HatchPerformance::XML_PARSE_USEC;
+}
+
+Variant HatchPerformance::_get_monitor(int p_counter){
+	ERR_FAIL_INDEX_V(p_counter, COUNTER_MAX, 0);
+
+	if (_is_usec_counter(p_counter)){
+		return counters[p_counter].get() / 1000.0;
+	}
+
+	return counters[p_counter].get();
+}
+
+void HatchPerformance::add_trace_event(const char *p_name, uint64_t p_start_usec, uint64_t p_duration_usec){
+	MutexLock lock(trace_mutex);
+
+	if (trace_events.size() >= HATCH_TRACE_MAX_EVENTS){
+		return;
+	}
+
+	TraceEvent event;
+	event.name = p_name;
+	event.start_usec = p_start_usec;
+	event.duration_usec = p_duration_usec;
+	event.thread_id = Thread::get_caller_id();
+
+	trace_events.push_back(event);
+}
+
+void HatchPerformance::register_monitors(){
+	Performance *performance = Performance::get_singleton();
+	ERR_FAIL_NULL(performance);
+
+	for (int i = 0; i < COUNTER_MAX; i++){
+		StringName id = String("hatch/") + counter_names[i];
+
+		if (performance->has_custom_monitor(id)){
+			continue;
+		}
+
+		Vector<Variant> args;
+		args.push_back(i);
+
+		performance->add_custom_monitor(id, callable_mp_static(&HatchPerformance::_get_monitor), args);
+	}
+}
+
+void HatchPerformance::unregister_monitors(){
+	Performance *performance = Performance::get_singleton();
+
+	if (performance == nullptr){
+		return;
+	}
+
+	for (int i = 0; i < COUNTER_MAX; i++){
+		StringName id = String("hatch/") + counter_names[i];
+
+		if (performance->has_custom_monitor(id)){
+			performance->remove_custom_monitor(id);
+		}
+	}
+}
+
+Dictionary HatchPerformance::get_counters(){
+	Dictionary out;
+
+	for (int i = 0; i < COUNTER_MAX; i++){
+		out[counter_names[i]] = _get_monitor(i);
+	}
+
+	return out;
+}
+
+void HatchPerformance::reset_counters(){
+	//live byte counts are left alone, the arena peak starts over
+	for (int i = 0; i < COUNTER_MAX; i++){
+		if (not _is_live_counter(i)){
+			counters[i].set(0);
+		}
+	}
+}
+
+void HatchPerformance::set_tracing_enabled(bool enabled){
+	if (enabled){
+		MutexLock lock(trace_mutex);
+		trace_events.clear();
+		tracing.set();
+	} else {
+		tracing.clear();
+	}
+}
+
+bool HatchPerformance::is_tracing_enabled(){
+	return tracing.is_set();
+}
+
+Error HatchPerformance::save_trace(String path){
+	Ref<FileAccess> out_file = FileAccess::open(path, FileAccess::ModeFlags::WRITE);
+	ERR_FAIL_COND_V_MSG(out_file.is_null(), ERR_FILE_CANT_WRITE, "Could not write Hatch trace to " + path);
+
+	MutexLock lock(trace_mutex);
+
+	out_file->store_string("{\"traceEvents\":[\n");
+
+	for (uint32_t i = 0; i < trace_events.size(); i++){
+		const TraceEvent &event = trace_events[i];
+
+		out_file->store_string(vformat("{\"name\":\"%s\",\"cat\":\"hatch\",\"ph\":\"X\",\"ts\":%d,\"dur\":%d,\"pid\":1,\"tid\":%d}%s\n",
+				event.name, (int64_t)event.start_usec, (int64_t)event.duration_usec, (int64_t)event.thread_id, i + 1 < trace_events.size() ? "," : ""));
+	}
+
+	out_file->store_string("],\"displayTimeUnit\":\"ms\"}\n");
+
+	return OK;
+}
+
+void HatchPerformance::_bind_methods(){
+	ClassDB::bind_static_method("HatchPerformance", D_METHOD("register_monitors"), &HatchPerformance::register_monitors);
+	ClassDB::bind_static_method("HatchPerformance", D_METHOD("get_counters"), &HatchPerformance::get_counters);
+	ClassDB::bind_static_method("HatchPerformance", D_METHOD("reset_counters"), &HatchPerformance::reset_counters);
+
+	ClassDB::bind_static_method("HatchPerformance", D_METHOD("set_tracing_enabled", "enabled"), &HatchPerformance::set_tracing_enabled);
+	ClassDB::bind_static_method("HatchPerformance", D_METHOD("is_tracing_enabled"), &HatchPerformance::is_tracing_enabled);
+	ClassDB::bind_static_method("HatchPerformance", D_METHOD("save_trace", "path"), &HatchPerformance::save_trace);
+}
+
+HatchScopedTimer::HatchScopedTimer(const char *p_name, HatchPerformance::Counter p_counter){
+	name = p_name;
+	counter = p_counter;
+	start_usec = OS::get_singleton()->get_ticks_usec();
+}
+
+HatchScopedTimer::~HatchScopedTimer(){
+	uint64_t duration = OS::get_singleton()->get_ticks_usec() - start_usec;
+
+	HatchPerformance::add(counter, duration);
+
+	if (HatchPerformance::is_tracing()){
+		HatchPerformance::add_trace_event(name, start_usec, duration);
+	}
+}
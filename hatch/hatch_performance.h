@@ -0,0 +1,93 @@
+#ifndef HATCH_PERFORMANCE_H
+#define HATCH_PERFORMANCE_H
+
+#include "core/object/object.h"
+#include "core/os/mutex.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/safe_refcount.h"
+
+//Trace events past this are dropped so a forgotten trace can't eat all memory
+#define HATCH_TRACE_MAX_EVENTS 1000000
+
+/*
+ Module-wide counters, shown in the debugger's Monitors tab under "hatch/". Timers are
+ accumulated in microseconds and reported in milliseconds. With tracing enabled, every
+ scoped timer also records a Chrome trace event (chrome://tracing, Perfetto).
+ */
+class HatchPerformance : public Object {
+	GDCLASS(HatchPerformance, Object);
+
+public:
+	enum Counter {
+		ARCHIVE_BYTES_READ,
+		ARCHIVE_ENTRIES_LOADED,
+		ARCHIVE_DECRYPT_USEC,
+		ARCHIVE_INFLATE_USEC,
+		ARCHIVE_LOOKUPS_FOUND, //TOC lookups by name hash; there is no entry cache
+		ARCHIVE_LOOKUPS_MISSING,
+		HSL_FUNCTIONS_PARSED,
+		HSL_PARSE_USEC,
+		HSL_BYTES_HELD,
+		HSL_HEAP_ALLOCATIONS,
+		HSL_ARENA_BYTES_RESERVED,
+		HSL_ARENA_PEAK_BYTES,
+		HSL_POOL_BYTES_RESERVED,
+		XML_PARSE_USEC,
+		HSL_SHAPES,
+		HSL_INSTANCE_BYTES,
+		COUNTER_MAX
+	};
+
+private:
+	struct TraceEvent {
+		const char *name;
+		uint64_t start_usec;
+		uint64_t duration_usec;
+		uint64_t thread_id;
+	};
+
+	static SafeNumeric<uint64_t> counters[COUNTER_MAX];
+	static const char *counter_names[COUNTER_MAX];
+
+	static SafeFlag tracing;
+	static Mutex trace_mutex;
+	static LocalVector<TraceEvent> trace_events;
+
+	static Variant _get_monitor(int p_counter);
+
+protected:
+	static void _bind_methods();
+
+public:
+	_FORCE_INLINE_ static void add(Counter p_counter, uint64_t p_amount = 1) { counters[p_counter].add(p_amount); }
+	_FORCE_INLINE_ static void sub(Counter p_counter, uint64_t p_amount) { counters[p_counter].sub(p_amount); }
+	_FORCE_INLINE_ static void record_max(Counter p_counter, uint64_t p_value) { counters[p_counter].exchange_if_greater(p_value); }
+	_FORCE_INLINE_ static uint64_t get(Counter p_counter) { return counters[p_counter].get(); }
+	_FORCE_INLINE_ static bool is_tracing() { return tracing.is_set(); }
+
+	static void add_trace_event(const char *p_name, uint64_t p_start_usec, uint64_t p_duration_usec);
+
+	static void register_monitors();
+	static void unregister_monitors();
+
+	static Dictionary get_counters();
+	static void reset_counters();
+
+	static void set_tracing_enabled(bool enabled);
+	static bool is_tracing_enabled();
+	static Error save_trace(String path);
+};
+
+class HatchScopedTimer {
+	const char *name;
+	HatchPerformance::Counter counter;
+	uint64_t start_usec;
+
+public:
+	HatchScopedTimer(const char *p_name, HatchPerformance::Counter p_counter);
+	~HatchScopedTimer();
+};
+
+#define HATCH_SCOPED_TIMER(m_name, m_counter) HatchScopedTimer _hatch_scoped_timer_(m_name, HatchPerformance::m_counter)
+
+#endif
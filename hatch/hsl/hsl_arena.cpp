@@ -0,0 +1,225 @@
+#include "hsl_arena.h"
+#include "../hatch_performance.h"
+
+#include "core/os/memory.h"
+#include "core/os/mutex.h"
+
+//Owns every object pool block for the life of the process; see HSLObjectPool
+struct HSLObjectReserve {
+	Mutex mutex;
+	LocalVector<uint8_t *> blocks;
+	HSLObjectPool::FreeObject *spare[HSL_POOL_CLASS_COUNT] = {};
+
+	~HSLObjectReserve(){
+		for (uint8_t *block : blocks){
+			memfree(block);
+		}
+	}
+};
+
+//thread_local objects are destroyed before statics, so this outlives even the main thread's pool
+static HSLObjectReserve object_reserve;
+
+static thread_local HSLFrameArena thread_arena;
+static thread_local HSLObjectPool thread_object_pool;
+
+HSLFrameArena *HSLFrameArena::get_thread_arena(){
+	return &thread_arena;
+}
+
+void HSLFrameArena::_add_chunk(size_t p_min_size){
+	size_t size = HSL_ARENA_CHUNK_SIZE;
+	if (chunks.size() > 0){
+		size = chunks[chunks.size() - 1].size * 2;
+	}
+	while (size < p_min_size){
+		size *= 2;
+	}
+
+	Chunk chunk;
+	chunk.memory = (uint8_t *)memalloc(size);
+	chunk.size = size;
+	chunks.push_back(chunk);
+
+	HatchPerformance::add(HatchPerformance::HSL_HEAP_ALLOCATIONS);
+	HatchPerformance::add(HatchPerformance::HSL_ARENA_BYTES_RESERVED, size);
+}
+
+void *HSLFrameArena::alloc(size_t p_size, size_t p_align){
+	if (unlikely(chunks.is_empty())){
+		_add_chunk(p_size + p_align);
+	}
+
+	size_t start = (offset + p_align - 1) & ~(p_align - 1);
+
+	if (unlikely(start + p_size > chunks[current].size)){
+		//move on to the next chunk big enough, keeping any left over from before a rewind
+		do {
+			current++;
+			if (current >= chunks.size()){
+				_add_chunk(p_size + p_align);
+			}
+		} while (chunks[current].size < p_size);
+
+		start = 0;
+	}
+
+	offset = start + p_size;
+	used += p_size;
+	peak = MAX(peak, used);
+
+	return chunks[current].memory + start;
+}
+
+void HSLFrameArena::rewind(const Mark &p_mark){
+	current = p_mark.chunk;
+	offset = p_mark.offset;
+	used = p_mark.used;
+}
+
+void HSLFrameArena::reset(){
+	HatchPerformance::record_max(HatchPerformance::HSL_ARENA_PEAK_BYTES, peak);
+
+	if (chunks.size() > 1){
+		size_t total = get_bytes_reserved();
+
+		for (const Chunk &chunk : chunks){
+			memfree(chunk.memory);
+		}
+		chunks.clear();
+		HatchPerformance::sub(HatchPerformance::HSL_ARENA_BYTES_RESERVED, total);
+
+		_add_chunk(total);
+	}
+
+	current = 0;
+	offset = 0;
+	used = 0;
+	peak = 0;
+}
+
+size_t HSLFrameArena::get_bytes_reserved() const {
+	size_t total = 0;
+	for (const Chunk &chunk : chunks){
+		total += chunk.size;
+	}
+	return total;
+}
+
+HSLFrameArena::~HSLFrameArena(){
+	HatchPerformance::sub(HatchPerformance::HSL_ARENA_BYTES_RESERVED, get_bytes_reserved());
+
+	for (const Chunk &chunk : chunks){
+		memfree(chunk.memory);
+	}
+}
+
+HSLObjectPool *HSLObjectPool::get_thread_pool(){
+	return &thread_object_pool;
+}
+
+int HSLObjectPool::_get_class(size_t p_size){
+	if (p_size > HSL_POOL_MAX_SIZE){
+		return -1;
+	}
+
+	int size_class = 0;
+	size_t class_size = 16;
+	while (class_size < p_size){
+		class_size <<= 1;
+		size_class++;
+	}
+	return size_class;
+}
+
+void HSLObjectPool::_grow(int p_class){
+	size_t object_size = (size_t)16 << p_class;
+	size_t count = HSL_POOL_BLOCK_SIZE / object_size;
+
+	MutexLock lock(object_reserve.mutex);
+
+	//objects left behind by exited threads first, a block's worth at a time
+	if (object_reserve.spare[p_class] != nullptr){
+		for (size_t taken = 0; taken < count and object_reserve.spare[p_class] != nullptr; taken++){
+			FreeObject *object = object_reserve.spare[p_class];
+			object_reserve.spare[p_class] = object->next;
+			object->next = free_lists[p_class];
+			free_lists[p_class] = object;
+		}
+		return;
+	}
+
+	uint8_t *block = (uint8_t *)memalloc(HSL_POOL_BLOCK_SIZE);
+	object_reserve.blocks.push_back(block);
+
+	//back to front so objects come out in address order, like the frame pool
+	for (size_t i = count; i > 0; i--){
+		FreeObject *object = (FreeObject *)(block + (i - 1) * object_size);
+		object->next = free_lists[p_class];
+		free_lists[p_class] = object;
+	}
+
+	HatchPerformance::add(HatchPerformance::HSL_HEAP_ALLOCATIONS);
+	HatchPerformance::add(HatchPerformance::HSL_POOL_BYTES_RESERVED, HSL_POOL_BLOCK_SIZE);
+}
+
+void *HSLObjectPool::alloc(size_t p_size){
+	int size_class = _get_class(p_size);
+	if (unlikely(size_class < 0)){
+		HatchPerformance::add(HatchPerformance::HSL_HEAP_ALLOCATIONS);
+		return memalloc(p_size);
+	}
+
+	if (unlikely(free_lists[size_class] == nullptr)){
+		_grow(size_class);
+	}
+
+	FreeObject *object = free_lists[size_class];
+	free_lists[size_class] = object->next;
+	in_use[size_class]++;
+
+	return object;
+}
+
+void HSLObjectPool::free(void *p_object, size_t p_size){
+	ERR_FAIL_NULL(p_object);
+
+	int size_class = _get_class(p_size);
+	if (unlikely(size_class < 0)){
+		memfree(p_object);
+		return;
+	}
+
+	FreeObject *object = (FreeObject *)p_object;
+	object->next = free_lists[size_class];
+	free_lists[size_class] = object;
+	in_use[size_class]--;
+}
+
+int32_t HSLObjectPool::get_objects_in_use() const {
+	int32_t total = 0;
+	for (int i = 0; i < HSL_POOL_CLASS_COUNT; i++){
+		total += in_use[i];
+	}
+	return total;
+}
+
+HSLObjectPool::~HSLObjectPool(){
+	MutexLock lock(object_reserve.mutex);
+
+	//objects from other threads can be in these lists too; they all live in reserve blocks
+	for (int i = 0; i < HSL_POOL_CLASS_COUNT; i++){
+		if (free_lists[i] == nullptr){
+			continue;
+		}
+
+		FreeObject *tail = free_lists[i];
+		while (tail->next != nullptr){
+			tail = tail->next;
+		}
+
+		tail->next = object_reserve.spare[i];
+		object_reserve.spare[i] = free_lists[i];
+		free_lists[i] = nullptr;
+	}
+}
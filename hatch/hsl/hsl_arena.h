@@ -0,0 +1,105 @@
+#ifndef HATCH_HSL_ARENA_H
+#define HATCH_HSL_ARENA_H
+
+#include "core/templates/local_vector.h"
+
+//First chunk an arena grabs; later chunks double, and reset() folds them back into one
+#define HSL_ARENA_CHUNK_SIZE (64 * 1024)
+
+//Object pool size classes are powers of two from 16 up to this, anything larger goes to the heap
+#define HSL_POOL_MAX_SIZE 512
+#define HSL_POOL_CLASS_COUNT 6
+#define HSL_POOL_BLOCK_SIZE (64 * 1024)
+
+/*
+ Per-thread bump allocator for VM temporaries that can't outlive the frame: strings, scratch
+ arrays, argument lists. Allocating is a pointer bump and nothing is freed one at a
+ time; HSLScheduler::tick() resets the main thread's arena every frame, and HSLArenaScope rewinds
+ it early around work that finishes sooner. A value that escapes has to be copied out first.
+ When a frame spills into more chunks, reset() swaps them for one chunk of the combined size,
+ so a steady frame stops touching the heap after the first few.
+ */
+class HSLFrameArena {
+	struct Chunk {
+		uint8_t *memory;
+		size_t size;
+	};
+
+	LocalVector<Chunk> chunks;
+	uint32_t current = 0;
+	size_t offset = 0;
+
+	size_t used = 0; //bytes handed out since the last reset, including earlier chunks
+	size_t peak = 0;
+
+	void _add_chunk(size_t p_min_size);
+
+public:
+	struct Mark {
+		uint32_t chunk;
+		size_t offset;
+		size_t used;
+	};
+
+	static HSLFrameArena *get_thread_arena();
+
+	void *alloc(size_t p_size, size_t p_align = 16);
+
+	template <typename T>
+	_FORCE_INLINE_ T *alloc_array(size_t p_count) { return (T *)alloc(sizeof(T) * p_count, alignof(T)); }
+
+	Mark get_mark() const { return { current, offset, used }; }
+	void rewind(const Mark &p_mark);
+	void reset();
+
+	size_t get_bytes_used() const { return used; }
+	size_t get_bytes_peak() const { return peak; }
+	size_t get_bytes_reserved() const;
+
+	~HSLFrameArena();
+};
+
+//Rewinds the thread's arena when it goes out of scope, for temporaries with a shorter life than the frame
+class HSLArenaScope {
+	HSLFrameArena *arena;
+	HSLFrameArena::Mark mark;
+
+public:
+	HSLArenaScope() :
+			arena(HSLFrameArena::get_thread_arena()), mark(arena->get_mark()) {}
+	~HSLArenaScope() { arena->rewind(mark); }
+};
+
+/*
+ Per-thread free lists for fixed-size VM objects, one per power-of-two size class, so a warm
+ pool never calls the allocator. Objects above HSL_POOL_MAX_SIZE fall through to the heap and
+ are counted. As with HSLFramePool, blocks belong to a process-wide reserve rather than the
+ thread: an exiting thread hands its free objects back there, since objects carved from its
+ blocks may still be in use or on other threads' free lists.
+ */
+class HSLObjectPool {
+	friend struct HSLObjectReserve;
+
+	struct FreeObject {
+		FreeObject *next;
+	};
+
+	FreeObject *free_lists[HSL_POOL_CLASS_COUNT] = {};
+	//signed, since an object allocated elsewhere can be freed into this pool
+	int32_t in_use[HSL_POOL_CLASS_COUNT] = {};
+
+	static int _get_class(size_t p_size);
+	void _grow(int p_class);
+
+public:
+	static HSLObjectPool *get_thread_pool();
+
+	void *alloc(size_t p_size);
+	void free(void *p_object, size_t p_size);
+
+	int32_t get_objects_in_use() const;
+
+	~HSLObjectPool();
+};
+
+#endif
@@ -1,24 +1,32 @@
 #include "hsl_bytecode_reader.h"
+#include "hsl_debugger.h"
+#include "hsl_scheduler.h"
+#include "hsl_shape.h"
+#include "hsl_snapshot.h"
+#include "../file_io/hatch_archive_reader.h"
+#include "../hatch_performance.h"
 #include "core/io/marshalls.h"
 #include "core/io/stream_peer.h"
 
 const char* HSLBytecodeReader::HSL_BYTECODE_MAGIC = "HTVM";
 
-String read_null_term_str(StreamPeerBuffer *peer){
-	String ret;
-	uint8_t byte = peer->get_8();
-
-	while (byte != '\0'){
-		ret += String::chr(byte);
+Mutex HSLBytecodeReader::modules_mutex;
+LocalVector<HSLBytecodeReader *> HSLBytecodeReader::modules;
 
-		if (peer->get_available_bytes() <= 0){
-			break;
-		}
+//Finds the terminator in place and builds the string once, instead of growing it a byte at a time
+String read_null_term_str(StreamPeerBuffer *peer){
+	const Vector<uint8_t> data = peer->get_data_array();
+	int start = peer->get_position();
+	int end = start;
 
-		byte = peer->get_8();
+	while (end < data.size() and data[end] != '\0'){
+		end++;
 	}
 
-	return ret;
+	peer->seek(MIN(end + 1, data.size()));
+
+	//bytes are Latin-1, like String::chr; the length bound covers a last string with no terminator
+	return String((const char *)data.ptr() + start, end - start);
 }
 
 uint32_t murmer_encrypt_data(const void* key, size_t size, uint32_t hash) {
@@ -64,10 +72,12 @@ uint32_t murmur_encrypt_string(String str){
 
 	const char *char_buf = (char *) buf_str.ptr();
 
-	return murmer_encrypt_data(char_buf, strlen(char_buf), 0xDEADBEEF);
+	return murmer_encrypt_data(char_buf, strlen(char_buf), HSL_MURMUR_SEED);
 }
 
-void HSLBytecodeReader::load_bytecode(PackedByteArray p_buffer){
+void HSLBytecodeReader::_parse(const PackedByteArray &p_buffer){
+	HATCH_SCOPED_TIMER("hsl_load_bytecode", HSL_PARSE_USEC);
+
 	StreamPeerBuffer buffer;
 	buffer.set_data_array(p_buffer);
 
@@ -131,6 +141,7 @@ void HSLBytecodeReader::load_bytecode(PackedByteArray p_buffer){
 		uint8_t *raw_bytecode = function.bytecode.ptrw();
 
 		buffer.get_data(&raw_bytecode[0], length);
+		function.digest = murmer_encrypt_data(raw_bytecode, length, HSL_MURMUR_SEED);
 
         if (has_debug_info and buffer.get_available_bytes() > length * sizeof(int)) {
 			function.lines.resize(length);
@@ -165,6 +176,9 @@ void HSLBytecodeReader::load_bytecode(PackedByteArray p_buffer){
 		hash_list.set(i, hash);
     }
 
+	HatchPerformance::add(HatchPerformance::HSL_FUNCTIONS_PARSED, chunk_count);
+	_update_held_bytes();
+
     if (has_debug_info) {
         int tokenCount = buffer.get_32();
         for (int t = 0; t < tokenCount; t++) {
@@ -182,6 +196,377 @@ void HSLBytecodeReader::load_bytecode(PackedByteArray p_buffer){
 	}
 }
 
+void HSLBytecodeReader::load_bytecode(PackedByteArray p_buffer){
+	_parse(p_buffer);
+
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	if (debugger != nullptr){
+		debugger->add_reader(this);
+	}
+}
+
+uint32_t HSLBytecodeReader::_retire(const HSLFunction &p_function){
+	uint32_t key[2] = { p_function.hash, p_function.digest };
+	uint32_t hash = murmer_encrypt_data(key, sizeof(key), HSL_MURMUR_SEED);
+	while (function_list.has(hash) or retired_functions.has(hash)){
+		hash++;
+	}
+
+	HSLFunction retired = p_function;
+	retired.hash = hash;
+	//nothing runs a suspended frame, so its traps can go
+	retired.patched = PackedByteArray();
+	retired_functions.insert(hash, retired);
+
+	return hash;
+}
+
+const HSLBytecodeReader::HSLFunction *HSLBytecodeReader::_find_function(uint32_t p_hash) const {
+	const HSLFunction *function = function_list.getptr(p_hash);
+	return function != nullptr ? function : retired_functions.getptr(p_hash);
+}
+
+Dictionary HSLBytecodeReader::reload_bytecode(PackedByteArray p_buffer){
+	HATCH_SCOPED_TIMER("hsl_reload_bytecode", HSL_PARSE_USEC);
+
+	Ref<HSLBytecodeReader> fresh;
+	fresh.instantiate();
+	//parsed only, so the debugger never sees it
+	fresh->_parse(p_buffer);
+
+	//a broken build of the script shouldn't wipe out the working one
+	ERR_FAIL_COND_V_MSG(fresh->hash_list.is_empty() and not hash_list.is_empty(), Dictionary(), "Reloaded HSL bytecode has no functions, keeping the loaded version.");
+
+	//calls resolve functions by hash, so callers pick up new code on their next call. Scripts
+	//suspended inside a replaced or removed function instead keep running the version they were
+	//suspended in, retired under a hash of its own. Retired code still reads the module's
+	//constants by index, so if those changed, such scripts are cancelled rather than resumed.
+	HSLScheduler *scheduler = HSLScheduler::get_singleton();
+	HashSet<uint32_t> suspended;
+	if (scheduler != nullptr){
+		scheduler->get_suspended_functions(this, suspended);
+	}
+
+	bool constants_changed = constants != fresh->constants;
+	bool keep_suspended = not constants_changed;
+
+	PackedInt32Array added;
+	PackedInt32Array changed;
+	PackedInt32Array removed;
+	HashSet<uint32_t> stale;
+	HashMap<uint32_t, uint32_t> retired;
+	HashSet<uint32_t> retiring;
+
+	for (int i = 0; i < fresh->hash_list.size(); i++){
+		uint32_t hash = fresh->hash_list[i];
+		const HSLFunction &new_function = fresh->function_list[hash];
+		HSLFunction *old_function = function_list.getptr(hash);
+
+		if (old_function == nullptr){
+			function_list.insert(hash, new_function);
+			added.push_back(hash);
+		} else if (old_function->digest != new_function.digest or old_function->arity != new_function.arity or old_function->min_arity != new_function.min_arity){
+			if (keep_suspended and suspended.has(hash)){
+				uint32_t retired_hash = _retire(*old_function);
+				retired.insert(hash, retired_hash);
+				retiring.insert(retired_hash);
+			}
+			*old_function = new_function;
+			changed.push_back(hash);
+			stale.insert(hash);
+		} else {
+			//same code, but lines move whenever anything above the function is edited
+			old_function->lines = new_function.lines;
+		}
+	}
+
+	for (const KeyValue<uint32_t, HSLFunction> &E : function_list){
+		if (not fresh->function_list.has(E.key)){
+			removed.push_back(E.key);
+			stale.insert(E.key);
+		}
+	}
+	for (int i = 0; i < removed.size(); i++){
+		uint32_t hash = removed[i];
+		if (keep_suspended and suspended.has(hash)){
+			uint32_t retired_hash = _retire(function_list[hash]);
+			retired.insert(hash, retired_hash);
+			retiring.insert(retired_hash);
+		}
+		function_list.erase(hash);
+	}
+
+	hash_list = fresh->hash_list;
+	source_file_path = fresh->source_file_path;
+	version = fresh->version;
+	options = fresh->options;
+
+	if (constants_changed){
+		constants = fresh->constants;
+	}
+
+	uint32_t cancelled = 0;
+	if (scheduler != nullptr){
+		if (keep_suspended){
+			scheduler->retarget_functions(this, retired);
+		} else {
+			//code retired by an earlier reload read the old constants too
+			for (const KeyValue<uint32_t, HSLFunction> &E : retired_functions){
+				stale.insert(E.key);
+			}
+			if (not stale.is_empty()){
+				cancelled = scheduler->cancel_functions(this, stale);
+			}
+		}
+	}
+
+	//retired code goes once no suspended script is left in it
+	LocalVector<uint32_t> finished;
+	for (const KeyValue<uint32_t, HSLFunction> &E : retired_functions){
+		if (not keep_suspended or (not suspended.has(E.key) and not retiring.has(E.key))){
+			finished.push_back(E.key);
+		}
+	}
+	for (uint32_t hash : finished){
+		retired_functions.erase(hash);
+	}
+
+	_update_held_bytes();
+
+	//replaced functions come back without traps, and lines may have moved under the rest
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	if (debugger != nullptr){
+		debugger->refresh_reader(this);
+	}
+
+	Dictionary result;
+	result["added"] = added;
+	result["changed"] = changed;
+	result["removed"] = removed;
+	result["constants_changed"] = constants_changed;
+	result["resumed_in_old_code"] = retired.size();
+	result["cancelled_scripts"] = cancelled;
+	return result;
+}
+
+Error HSLBytecodeReader::load_file(const String &p_path){
+	PackedByteArray buffer;
+	Error err = HatchArchiveReader::load_path(p_path, buffer);
+	ERR_FAIL_COND_V_MSG(err != OK, err, "Could not read HSL bytecode \"" + p_path + "\".");
+
+	//classes get their root shapes before any of their code can make instances
+	HSLShapeTable *shapes = HSLShapeTable::get_singleton();
+	if (shapes != nullptr){
+		shapes->ensure_class_map();
+	}
+
+	load_bytecode(buffer);
+
+	MutexLock lock(modules_mutex);
+	if (module_path.is_empty()){
+		modules.push_back(this);
+	}
+	module_path = p_path;
+
+	return OK;
+}
+
+Dictionary HSLBytecodeReader::reload_file(){
+	ERR_FAIL_COND_V_MSG(module_path.is_empty(), Dictionary(), "HSL module was not loaded from a file.");
+
+	PackedByteArray buffer;
+	Error err = HatchArchiveReader::load_path(module_path, buffer);
+	ERR_FAIL_COND_V_MSG(err != OK, Dictionary(), "Could not read HSL bytecode \"" + module_path + "\".");
+
+	return reload_bytecode(buffer);
+}
+
+Dictionary HSLBytecodeReader::reload_modules(const PackedStringArray &p_paths){
+	//referenced under the lock, so a module freed meanwhile is skipped rather than reloaded
+	LocalVector<Ref<HSLBytecodeReader>> reload;
+	{
+		MutexLock lock(modules_mutex);
+		for (HSLBytecodeReader *reader : modules){
+			if (p_paths.is_empty() or p_paths.has(reader->module_path)){
+				Ref<HSLBytecodeReader> ref(reader);
+				if (ref.is_valid()){
+					reload.push_back(ref);
+				}
+			}
+		}
+	}
+
+	Dictionary results;
+	for (const Ref<HSLBytecodeReader> &reader : reload){
+		results[reader->module_path] = reader->reload_file();
+	}
+	return results;
+}
+
+void HSLBytecodeReader::_update_held_bytes(){
+	HatchPerformance::sub(HatchPerformance::HSL_BYTES_HELD, held_bytes);
+
+	held_bytes = 0;
+	for (const KeyValue<uint32_t, HSLFunction> &E : function_list){
+		held_bytes += E.value.bytecode.size() + E.value.lines.size() * sizeof(int32_t);
+	}
+	for (const KeyValue<uint32_t, HSLFunction> &E : retired_functions){
+		held_bytes += E.value.bytecode.size() + E.value.lines.size() * sizeof(int32_t);
+	}
+
+	HatchPerformance::add(HatchPerformance::HSL_BYTES_HELD, held_bytes);
+}
+
+void HSLBytecodeReader::write_state(HSLStateWriter &r_writer) const {
+	r_writer.put_u8(version);
+	r_writer.put_u8(options);
+	r_writer.put_string(source_file_path);
+
+	r_writer.put_u32(hash_list.size());
+	for (int i = 0; i < hash_list.size(); i++){
+		const HSLFunction &function = function_list[hash_list[i]];
+
+		r_writer.put_u32(function.hash);
+		r_writer.put_u32(function.arity);
+		r_writer.put_u32(function.min_arity);
+		r_writer.put_string(function.name);
+		r_writer.put_string(function.class_name);
+
+		r_writer.put_u32(function.bytecode.size());
+		r_writer.put_bytes(function.bytecode.ptr(), function.bytecode.size());
+		r_writer.put_u32(function.lines.size());
+		r_writer.put_bytes(function.lines.ptr(), function.lines.size() * sizeof(int32_t));
+	}
+
+	r_writer.put_u32(constants.size());
+	for (int i = 0; i < constants.size(); i++){
+		const Variant &constant = constants[i];
+
+		switch (constant.get_type()){
+			case Variant::INT:
+				r_writer.put_u8(1);
+				r_writer.put_u32((int32_t)constant);
+				break;
+			case Variant::FLOAT: {
+				r_writer.put_u8(2);
+				float value = constant;
+				r_writer.put_bytes(&value, sizeof(float));
+			} break;
+			case Variant::STRING:
+				r_writer.put_u8(3);
+				r_writer.put_string(constant);
+				break;
+			default:
+				r_writer.put_u8(0);
+				break;
+		}
+	}
+}
+
+Error HSLBytecodeReader::read_state(HSLStateReader &r_reader){
+	function_list.clear();
+	hash_list.clear();
+	constants.clear();
+
+	version = r_reader.get_u8();
+	options = r_reader.get_u8();
+	source_file_path = r_reader.get_string();
+
+	uint32_t function_count = r_reader.get_u32();
+	ERR_FAIL_COND_V(r_reader.failed, ERR_FILE_CORRUPT);
+
+	function_list.reserve(function_count);
+	hash_list.resize(function_count);
+
+	for (uint32_t i = 0; i < function_count and not r_reader.failed; i++){
+		HSLFunction function;
+		function.hash = r_reader.get_u32();
+		function.arity = r_reader.get_u32();
+		function.min_arity = r_reader.get_u32();
+		function.up_value_count = 0;
+		function.name = r_reader.get_string();
+		function.class_name = r_reader.get_string();
+
+		uint32_t length = r_reader.get_u32();
+		const uint8_t *bytecode = r_reader.get_bytes(length);
+		function.digest = 0;
+		if (bytecode != nullptr){
+			function.bytecode.resize(length);
+			memcpy(function.bytecode.ptrw(), bytecode, length);
+			function.digest = murmer_encrypt_data(bytecode, length, HSL_MURMUR_SEED);
+		}
+
+		uint32_t line_count = r_reader.get_u32();
+		//checked before multiplying, since a large count would wrap the byte size
+		if (r_reader.failed or line_count > (r_reader.size - r_reader.pos) / sizeof(int32_t)){
+			r_reader.failed = true;
+			break;
+		}
+
+		const uint8_t *lines = r_reader.get_bytes(line_count * sizeof(int32_t));
+		if (lines != nullptr){
+			function.lines.resize(line_count);
+			memcpy(function.lines.ptrw(), lines, line_count * sizeof(int32_t));
+		}
+
+		function_list.insert(function.hash, function);
+		hash_list.set(i, function.hash);
+	}
+
+	uint32_t constant_count = r_reader.get_u32();
+	for (uint32_t i = 0; i < constant_count and not r_reader.failed; i++){
+		switch (r_reader.get_u8()){
+			case 1:
+				constants.append((int32_t)r_reader.get_u32());
+				break;
+			case 2: {
+				float value = 0.0;
+				const uint8_t *bytes = r_reader.get_bytes(sizeof(float));
+				if (bytes != nullptr){
+					memcpy(&value, bytes, sizeof(float));
+				}
+				constants.append(value);
+			} break;
+			case 3:
+				constants.append(r_reader.get_string());
+				break;
+			default:
+				constants.append(Variant());
+				break;
+		}
+	}
+
+	if (r_reader.failed){
+		function_list.clear();
+		hash_list.clear();
+		constants.clear();
+	}
+
+	_update_held_bytes();
+
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	if (debugger != nullptr){
+		debugger->add_reader(this);
+	}
+
+	ERR_FAIL_COND_V_MSG(r_reader.failed, ERR_FILE_CORRUPT, "HSL snapshot is truncated.");
+	return OK;
+}
+
+HSLBytecodeReader::~HSLBytecodeReader(){
+	if (not module_path.is_empty()){
+		MutexLock lock(modules_mutex);
+		modules.erase(this);
+	}
+
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	if (debugger != nullptr){
+		debugger->remove_reader(this);
+	}
+
+	HatchPerformance::sub(HatchPerformance::HSL_BYTES_HELD, held_bytes);
+}
+
 bool HSLBytecodeReader::has_debug_info(){
 	return options & HAS_DEBUG_INFO;
 };
@@ -194,10 +579,96 @@ uint32_t HSLBytecodeReader::get_function_count(){
 	return function_list.size();
 }
 
-String HSLBytecodeReader::get_source_path(){
+String HSLBytecodeReader::get_source_path() const {
 	return source_file_path;
 }
 
+PackedStringArray HSLBytecodeReader::get_string_constants(){
+	PackedStringArray out;
+
+	for (int i = 0; i < constants.size(); i++){
+		if (constants[i].get_type() == Variant::STRING){
+			out.push_back(constants[i]);
+		}
+	}
+
+	return out;
+}
+
+const uint8_t *HSLBytecodeReader::get_code(uint32_t p_hash) const {
+	const HSLFunction *function = _find_function(p_hash);
+	if (unlikely(function == nullptr)){
+		return nullptr;
+	}
+	return function->patched.is_empty() ? function->bytecode.ptr() : function->patched.ptr();
+}
+
+String HSLBytecodeReader::get_function_name(uint32_t p_hash) const {
+	const HSLFunction *function = _find_function(p_hash);
+	if (function == nullptr){
+		return String();
+	}
+	return function->name.is_empty() ? vformat("0x%08X", p_hash) : function->name;
+}
+
+uint8_t HSLBytecodeReader::get_opcode(uint32_t p_hash, uint32_t p_ip) const {
+	const HSLFunction *function = _find_function(p_hash);
+	ERR_FAIL_NULL_V(function, HSL_OP_TRAP);
+	ERR_FAIL_UNSIGNED_INDEX_V(p_ip, (uint32_t)function->bytecode.size(), HSL_OP_TRAP);
+	return function->bytecode[p_ip];
+}
+
+int HSLBytecodeReader::get_line(uint32_t p_hash, uint32_t p_ip) const {
+	const HSLFunction *function = _find_function(p_hash);
+	if (function == nullptr or p_ip >= (uint32_t)function->lines.size()){
+		return -1;
+	}
+	return function->lines[p_ip];
+}
+
+void HSLBytecodeReader::get_line_starts(uint32_t p_hash, int p_line, LocalVector<uint32_t> &r_offsets) const {
+	const HSLFunction *function = function_list.getptr(p_hash);
+	if (function == nullptr){
+		return;
+	}
+
+	//lines has an entry per byte and operands share their instruction's line, so wherever the
+	//line changes is the start of an instruction
+	const int32_t *lines = function->lines.ptr();
+	int count = MIN(function->lines.size(), function->bytecode.size());
+	for (int i = 0; i < count; i++){
+		if (i > 0 and lines[i] == lines[i - 1]){
+			continue;
+		}
+		if (p_line < 0 or lines[i] == p_line){
+			r_offsets.push_back(i);
+		}
+	}
+}
+
+void HSLBytecodeReader::set_traps(uint32_t p_hash, const LocalVector<uint32_t> &p_offsets){
+	HSLFunction *function = function_list.getptr(p_hash);
+	ERR_FAIL_NULL(function);
+
+	//no traps left, so the function goes back to its original bytecode and the copy is dropped
+	if (p_offsets.is_empty()){
+		function->patched = PackedByteArray();
+		return;
+	}
+
+	if (function->patched.is_empty()){
+		function->patched = function->bytecode.duplicate();
+	}
+
+	//rewritten in place rather than swapped, as a frame may be running this function right now
+	uint8_t *code = function->patched.ptrw();
+	memcpy(code, function->bytecode.ptr(), function->bytecode.size());
+	for (uint32_t offset : p_offsets){
+		ERR_CONTINUE(offset >= (uint32_t)function->bytecode.size());
+		code[offset] = HSL_OP_TRAP;
+	}
+}
+
 Dictionary HSLBytecodeReader::_get_dict_info(HSLFunction *func){
 	Dictionary out;
 
@@ -240,12 +711,18 @@ Dictionary HSLBytecodeReader::get_function_by_hash(uint32_t hash){
 
 void HSLBytecodeReader::_bind_methods(){
 	ClassDB::bind_method(D_METHOD("load_bytecode", "buffer"), &HSLBytecodeReader::load_bytecode);
+	ClassDB::bind_method(D_METHOD("reload_bytecode", "buffer"), &HSLBytecodeReader::reload_bytecode);
+	ClassDB::bind_method(D_METHOD("load_file", "path"), &HSLBytecodeReader::load_file);
+	ClassDB::bind_method(D_METHOD("reload_file"), &HSLBytecodeReader::reload_file);
+	ClassDB::bind_method(D_METHOD("get_file_path"), &HSLBytecodeReader::get_file_path);
+	ClassDB::bind_static_method("HSLBytecodeReader", D_METHOD("reload_modules", "paths"), &HSLBytecodeReader::reload_modules, DEFVAL(PackedStringArray()));
 
 	ClassDB::bind_method(D_METHOD("has_debug_info"), &HSLBytecodeReader::has_debug_info);
 	ClassDB::bind_method(D_METHOD("has_source_path"), &HSLBytecodeReader::has_source_path);
 
 	ClassDB::bind_method(D_METHOD("get_function_count"), &HSLBytecodeReader::get_function_count);
 	ClassDB::bind_method(D_METHOD("get_source_path"), &HSLBytecodeReader::get_source_path);
+	ClassDB::bind_method(D_METHOD("get_string_constants"), &HSLBytecodeReader::get_string_constants);
 
 	ClassDB::bind_method(D_METHOD("get_function_by_index", "index"), &HSLBytecodeReader::get_function_by_index);
 	ClassDB::bind_method(D_METHOD("get_function_by_name", "function_name"), &HSLBytecodeReader::get_function_by_name);
@@ -2,7 +2,20 @@
 #define HATCH_BYTECODE_READER_H
 
 #include "core/object/ref_counted.h"
+#include "core/os/mutex.h"
+#include "core/templates/local_vector.h"
 
+//Seed the Hatch compiler uses when hashing function and native names
+#define HSL_MURMUR_SEED 0xDEADBEEF
+
+//Never emitted by the compiler; the debugger writes it over the first byte of an instruction
+#define HSL_OP_TRAP 0xFF
+
+uint32_t murmer_encrypt_data(const void* key, size_t size, uint32_t hash);
+uint32_t murmur_encrypt_string(String str);
+
+struct HSLStateWriter;
+struct HSLStateReader;
 
 class HSLBytecodeReader : public RefCounted {
 	GDCLASS(HSLBytecodeReader, RefCounted);
@@ -19,12 +32,15 @@ class HSLBytecodeReader : public RefCounted {
 		int up_value_count;
 		PackedByteArray bytecode;
 		PackedInt32Array lines;
-
+		//bytecode with traps written in, made the first time the debugger puts one in this
+		//function and then patched in place, so running frames never lose their code
+		PackedByteArray patched;
 
 		String name;
 		String class_name;
 
 		uint32_t hash;
+		uint32_t digest; //murmur of the bytecode, to spot changed functions on reload
 	};
 
 	static const char *HSL_BYTECODE_MAGIC;
@@ -33,11 +49,31 @@ class HSLBytecodeReader : public RefCounted {
 	PackedInt32Array hash_list;
 	Array constants;
 
+	//Versions a reload replaced or removed while a suspended script was still inside them,
+	//kept under hashes of their own until the last such script leaves
+	HashMap<uint32_t, HSLFunction> retired_functions;
+
 	String source_file_path;
+	//Where load_file read the module from, empty for modules loaded from a buffer
+	String module_path;
+
+	//Every module loaded through load_file, for reload_modules
+	static Mutex modules_mutex;
+	static LocalVector<HSLBytecodeReader *> modules;
 
 	uint8_t version;
 	uint8_t options;
 
+	//bytecode and line tables currently held, reported through HatchPerformance
+	uint64_t held_bytes = 0;
+
+	//load_bytecode without handing the reader to the debugger, for readers that are never run
+	void _parse(const PackedByteArray &p_buffer);
+	void _update_held_bytes();
+
+	uint32_t _retire(const HSLFunction &p_function);
+	const HSLFunction *_find_function(uint32_t p_hash) const;
+
 	Dictionary _get_dict_info(HSLFunction *func);
 
 protected:
@@ -45,6 +81,20 @@ protected:
 public:
 
 	void load_bytecode(PackedByteArray buffer);
+	//Swaps in only the functions whose bytecode changed; returns what was added, changed and removed
+	Dictionary reload_bytecode(PackedByteArray buffer);
+
+	//Loads a module from a path, mounted archives included, and remembers it for reloading
+	Error load_file(const String &p_path);
+	Dictionary reload_file();
+	String get_file_path() const { return module_path; }
+	//Reloads every module loaded from these paths, or every module when none are given;
+	//returns reload_bytecode's result for each path
+	static Dictionary reload_modules(const PackedStringArray &p_paths = PackedStringArray());
+
+	//Everything load_bytecode produced, flattened for HSLSnapshot; reading it back skips the parser
+	void write_state(HSLStateWriter &r_writer) const;
+	Error read_state(HSLStateReader &r_reader);
 
 	bool has_debug_info();
 	bool has_source_path();
@@ -54,7 +104,25 @@ public:
 	Dictionary get_function_by_hash(uint32_t hash);
 
 	uint32_t get_function_count();
-	String get_source_path();
+	String get_source_path() const;
+
+	PackedStringArray get_string_constants();
+
+	//What the interpreter runs, looked up once per call: the patched copy once there is one
+	const uint8_t *get_code(uint32_t p_hash) const;
+
+	//For HSLDebugger, which only reads these while stopped or when breakpoints change
+	const PackedInt32Array &get_hash_list() const { return hash_list; }
+	bool has_function(uint32_t p_hash) const { return _find_function(p_hash) != nullptr; }
+	String get_function_name(uint32_t p_hash) const;
+	uint8_t get_opcode(uint32_t p_hash, uint32_t p_ip) const;
+	int get_line(uint32_t p_hash, uint32_t p_ip) const;
+	//Offsets where a line's code starts, or where every line's does for a line below 0
+	void get_line_starts(uint32_t p_hash, int p_line, LocalVector<uint32_t> &r_offsets) const;
+	//Replaces the function's traps with traps at these offsets
+	void set_traps(uint32_t p_hash, const LocalVector<uint32_t> &p_offsets);
+
+	~HSLBytecodeReader();
 };
 
 
@@ -0,0 +1,347 @@
+#include "hsl_debugger.h"
+#include "hsl_bytecode_reader.h"
+
+#include "core/debugger/engine_debugger.h"
+#include "core/debugger/script_debugger.h"
+#include "core/object/object.h"
+
+HSLDebugger *HSLDebugger::singleton = nullptr;
+
+HSLDebugger *HSLDebugger::get_singleton(){
+	return singleton;
+}
+
+//The compiler records sources relative to the project, the editor as res:// paths
+bool HSLDebugger::_matches_source(const String &p_reader_source, const String &p_source){
+	if (p_reader_source.is_empty()){
+		return false;
+	}
+	return p_source == p_reader_source or p_source.ends_with("/" + p_reader_source);
+}
+
+uint32_t HSLDebugger::_get_depth(const HSLCallFrame *p_frame){
+	uint32_t depth = 0;
+	for (const HSLCallFrame *frame = p_frame; frame != nullptr; frame = frame->caller){
+		depth++;
+	}
+	return depth;
+}
+
+Variant HSLDebugger::_to_variant(const HSLValue &p_value){
+	switch (p_value.type){
+		case HSL_VAL_INTEGER:
+		case HSL_VAL_LINKED_INTEGER:
+			return p_value.get_integer();
+		case HSL_VAL_DECIMAL:
+		case HSL_VAL_LINKED_DECIMAL:
+			return p_value.get_decimal();
+		case HSL_VAL_OBJECT:
+			return vformat("<object 0x%s>", String::num_uint64((uint64_t)p_value.as_object, 16));
+		default:
+			return Variant();
+	}
+}
+
+HSLBytecodeReader *HSLDebugger::_find_reader(uint32_t p_function_hash) const {
+	for (HSLBytecodeReader *reader : readers){
+		if (reader->has_function(p_function_hash)){
+			return reader;
+		}
+	}
+	return nullptr;
+}
+
+const HSLCallFrame *HSLDebugger::_get_level(int p_level) const {
+	const HSLCallFrame *frame = break_frame;
+	for (int i = 0; i < p_level and frame != nullptr; i++){
+		frame = frame->caller;
+	}
+	return frame;
+}
+
+void HSLDebugger::_get_breakpoint_lines(const HSLBytecodeReader *p_reader, LocalVector<int> &r_lines) const {
+	String source = p_reader->get_source_path();
+	for (const KeyValue<String, HashSet<int>> &E : breakpoints){
+		if (not _matches_source(source, E.key)){
+			continue;
+		}
+		for (int line : E.value){
+			r_lines.push_back(line);
+		}
+	}
+}
+
+bool HSLDebugger::_is_breakpoint(const HSLBytecodeReader *p_reader, int p_line) const {
+	LocalVector<int> lines;
+	_get_breakpoint_lines(p_reader, lines);
+	return lines.has(p_line);
+}
+
+void HSLDebugger::_apply(HSLBytecodeReader *p_reader){
+	LocalVector<int> lines;
+	_get_breakpoint_lines(p_reader, lines);
+
+	LocalVector<uint32_t> offsets;
+	const PackedInt32Array &hashes = p_reader->get_hash_list();
+	for (int i = 0; i < hashes.size(); i++){
+		uint32_t hash = hashes[i];
+		offsets.clear();
+
+		if (step_mode == STEP_INTO or (step_mode == STEP_OVER and step_functions.has(hash))){
+			p_reader->get_line_starts(hash, -1, offsets);
+		} else {
+			for (int line : lines){
+				p_reader->get_line_starts(hash, line, offsets);
+			}
+		}
+
+		p_reader->set_traps(hash, offsets);
+	}
+}
+
+void HSLDebugger::_apply_all(){
+	for (HSLBytecodeReader *reader : readers){
+		_apply(reader);
+	}
+}
+
+void HSLDebugger::_set_step(StepMode p_mode, const HSLCallFrame *p_frame){
+	step_mode = p_mode;
+	step_depth = _get_depth(p_frame);
+
+	//stepping over can also finish by returning, at the next line of any caller
+	step_functions.clear();
+	if (p_mode == STEP_OVER){
+		for (const HSLCallFrame *frame = p_frame; frame != nullptr; frame = frame->caller){
+			step_functions.insert(frame->function_hash);
+		}
+	}
+
+	_apply_all();
+}
+
+void HSLDebugger::add_reader(HSLBytecodeReader *p_reader){
+	MutexLock lock(mutex);
+	if (not readers.has(p_reader)){
+		readers.push_back(p_reader);
+	}
+	if (not breakpoints.is_empty() or step_mode != STEP_NONE){
+		_apply(p_reader);
+	}
+}
+
+void HSLDebugger::remove_reader(HSLBytecodeReader *p_reader){
+	MutexLock lock(mutex);
+	readers.erase(p_reader);
+}
+
+void HSLDebugger::refresh_reader(HSLBytecodeReader *p_reader){
+	MutexLock lock(mutex);
+	if (breakpoints.is_empty() and step_mode == STEP_NONE){
+		return;
+	}
+	_apply(p_reader);
+}
+
+void HSLDebugger::sync(){
+	ScriptDebugger *script_debugger = EngineDebugger::get_script_debugger();
+	if (script_debugger == nullptr){
+		return;
+	}
+
+	MutexLock lock(mutex);
+
+	HashMap<String, HashSet<int>> wanted;
+	if (not script_debugger->is_skipping_breakpoints()){
+		for (const KeyValue<int, HashSet<StringName>> &E : script_debugger->get_breakpoints()){
+			for (const StringName &source : E.value){
+				wanted[source].insert(E.key);
+			}
+		}
+	}
+
+	//usually nothing changed, and then no bytecode is touched
+	bool changed = wanted.size() != breakpoints.size();
+	for (const KeyValue<String, HashSet<int>> &E : wanted){
+		if (changed){
+			break;
+		}
+		const HashSet<int> *lines = breakpoints.getptr(E.key);
+		if (lines == nullptr or lines->size() != E.value.size()){
+			changed = true;
+			break;
+		}
+		for (int line : E.value){
+			if (not lines->has(line)){
+				changed = true;
+				break;
+			}
+		}
+	}
+
+	if (changed){
+		breakpoints = wanted;
+		_apply_all();
+	}
+
+	//a pause from the editor arrives as a step request with no script stopped
+	if (step_mode == STEP_NONE and script_debugger->get_lines_left() > 0){
+		_set_step(STEP_INTO, nullptr);
+	}
+}
+
+uint8_t HSLDebugger::trap(HSLCallFrame *p_frame){
+	ERR_FAIL_NULL_V(p_frame, HSL_OP_TRAP);
+
+	ScriptDebugger *script_debugger = EngineDebugger::get_script_debugger();
+	uint8_t opcode;
+
+	{
+		MutexLock lock(mutex);
+
+		HSLBytecodeReader *reader = _find_reader(p_frame->function_hash);
+		ERR_FAIL_NULL_V_MSG(reader, HSL_OP_TRAP, "Hit an HSL trap in a function that isn't loaded.");
+
+		opcode = reader->get_opcode(p_frame->function_hash, p_frame->ip);
+		int line = reader->get_line(p_frame->function_hash, p_frame->ip);
+
+		bool at_breakpoint = _is_breakpoint(reader, line);
+		bool stop = at_breakpoint;
+		if (step_mode == STEP_INTO){
+			stop = true;
+		} else if (step_mode == STEP_OVER and _get_depth(p_frame) <= step_depth){
+			stop = true;
+		}
+
+		if (not stop or script_debugger == nullptr or language == nullptr){
+			return opcode;
+		}
+
+		//whatever happens next, the step that brought us here is done
+		if (step_mode != STEP_NONE){
+			step_mode = STEP_NONE;
+			step_functions.clear();
+			_apply_all();
+		}
+
+		break_frame = p_frame;
+		break_error = at_breakpoint ? "Breakpoint" : "";
+	}
+
+	//runs the editor's debug loop until continue or a step. It can sit here for as long as the
+	//user likes, so the lock is not held: readers still come and go, and the stack queries
+	//made from inside the loop take it themselves
+	script_debugger->debug(language, true, false);
+
+	{
+		MutexLock lock(mutex);
+
+		break_frame = nullptr;
+		break_error = String();
+
+		//the editor leaves "step" as depth -1 and "next" as depth 0 with a line to go
+		if (script_debugger->get_lines_left() > 0){
+			_set_step(script_debugger->get_depth() < 0 ? STEP_INTO : STEP_OVER, p_frame);
+		}
+	}
+
+	//breakpoints may have changed while stopped, and must be in before the script moves on
+	sync();
+
+	return opcode;
+}
+
+int HSLDebugger::get_stack_level_count() const {
+	return _get_depth(break_frame);
+}
+
+int HSLDebugger::get_stack_level_line(int p_level) const {
+	MutexLock lock(mutex);
+
+	const HSLCallFrame *frame = _get_level(p_level);
+	ERR_FAIL_NULL_V(frame, -1);
+
+	HSLBytecodeReader *reader = _find_reader(frame->function_hash);
+	if (reader == nullptr){
+		return -1;
+	}
+
+	//callers sit just past their call instruction, which may already be on the next line
+	uint32_t ip = frame->ip;
+	if (p_level > 0 and ip > 0){
+		ip--;
+	}
+	return reader->get_line(frame->function_hash, ip);
+}
+
+String HSLDebugger::get_stack_level_function(int p_level) const {
+	MutexLock lock(mutex);
+
+	const HSLCallFrame *frame = _get_level(p_level);
+	ERR_FAIL_NULL_V(frame, String());
+
+	HSLBytecodeReader *reader = _find_reader(frame->function_hash);
+	return reader != nullptr ? reader->get_function_name(frame->function_hash) : String();
+}
+
+String HSLDebugger::get_stack_level_source(int p_level) const {
+	MutexLock lock(mutex);
+
+	const HSLCallFrame *frame = _get_level(p_level);
+	ERR_FAIL_NULL_V(frame, String());
+
+	HSLBytecodeReader *reader = _find_reader(frame->function_hash);
+	return reader != nullptr ? reader->get_source_path() : String();
+}
+
+void HSLDebugger::get_stack_level_locals(int p_level, List<String> *p_locals, List<Variant> *p_values) const {
+	const HSLCallFrame *frame = _get_level(p_level);
+	ERR_FAIL_NULL(frame);
+
+	//the bytecode keeps no local names, so they are listed by slot
+	for (uint32_t i = 0; i < frame->local_count; i++){
+		p_locals->push_back("local" + itos(i));
+		p_values->push_back(_to_variant(frame->slots[i]));
+	}
+}
+
+void HSLDebugger::get_stack_level_members(int p_level, List<String> *p_members, List<Variant> *p_values) const {
+	const HSLCallFrame *frame = _get_level(p_level);
+	ERR_FAIL_NULL(frame);
+
+	Object *owner = ObjectDB::get_instance(frame->owner);
+	if (owner != nullptr){
+		p_members->push_back("self");
+		p_values->push_back(owner);
+	}
+}
+
+String HSLDebugger::parse_stack_level_expression(int p_level, const String &p_expression) const {
+	const HSLCallFrame *frame = _get_level(p_level);
+	ERR_FAIL_NULL_V(frame, String());
+
+	String expression = p_expression.strip_edges();
+	if (expression == "self"){
+		Object *owner = ObjectDB::get_instance(frame->owner);
+		return owner != nullptr ? owner->to_string() : "null";
+	}
+
+	if (expression.begins_with("local") and expression.substr(5).is_valid_int()){
+		int64_t slot = expression.substr(5).to_int();
+		if (slot >= 0 and slot < frame->local_count){
+			return _to_variant(frame->slots[slot]).stringify();
+		}
+	}
+
+	return vformat("Cannot evaluate \"%s\", only locals (local0, local1, ...) and self are known.", expression);
+}
+
+HSLDebugger::HSLDebugger(){
+	singleton = this;
+}
+
+HSLDebugger::~HSLDebugger(){
+	if (singleton == this){
+		singleton = nullptr;
+	}
+}
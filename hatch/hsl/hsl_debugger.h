@@ -0,0 +1,98 @@
+#ifndef HATCH_HSL_DEBUGGER_H
+#define HATCH_HSL_DEBUGGER_H
+
+#include "hsl_frame.h"
+
+#include "core/os/mutex.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/hash_set.h"
+#include "core/variant/variant.h"
+
+class HSLBytecodeReader;
+class ScriptLanguage;
+
+/*
+ Breakpoints and stepping without a "debugging?" check in the dispatch loop. A breakpoint
+ writes HSL_OP_TRAP over the first instruction of its line in a copy of the function's
+ bytecode, and the interpreter runs that copy instead; functions without traps run their
+ original bytecode, so a session with no breakpoints costs exactly what a release build does.
+
+ Stepping works the same way, with temporary traps at every line start of the functions it
+ could land in. Nothing about the stack is recorded while running: when a trap stops the
+ script, the frame chain it stopped in is walked on demand for lines, names and locals.
+ */
+class HSLDebugger {
+	enum StepMode {
+		STEP_NONE,
+		STEP_INTO, //stop at the next line anywhere
+		STEP_OVER, //stop at the next line no deeper than where the step started
+	};
+
+	static HSLDebugger *singleton;
+
+	mutable Mutex mutex;
+	LocalVector<HSLBytecodeReader *> readers;
+
+	ScriptLanguage *language = nullptr;
+
+	//source path -> lines, as the engine debugger last had them
+	HashMap<String, HashSet<int>> breakpoints;
+
+	StepMode step_mode = STEP_NONE;
+	uint32_t step_depth = 0;
+	HashSet<uint32_t> step_functions; //what STEP_OVER armed
+
+	//only while stopped
+	HSLCallFrame *break_frame = nullptr;
+	String break_error;
+
+	static bool _matches_source(const String &p_reader_source, const String &p_source);
+
+	static uint32_t _get_depth(const HSLCallFrame *p_frame);
+	static Variant _to_variant(const HSLValue &p_value);
+
+	HSLBytecodeReader *_find_reader(uint32_t p_function_hash) const;
+	const HSLCallFrame *_get_level(int p_level) const;
+	bool _is_breakpoint(const HSLBytecodeReader *p_reader, int p_line) const;
+	void _get_breakpoint_lines(const HSLBytecodeReader *p_reader, LocalVector<int> &r_lines) const;
+
+	void _apply(HSLBytecodeReader *p_reader);
+	void _apply_all();
+	void _set_step(StepMode p_mode, const HSLCallFrame *p_frame);
+
+public:
+	static HSLDebugger *get_singleton();
+
+	void set_language(ScriptLanguage *p_language) { language = p_language; }
+
+	//Readers are added once they hold code that runs, and get their traps then
+	void add_reader(HSLBytecodeReader *p_reader);
+	void remove_reader(HSLBytecodeReader *p_reader);
+	//Rewrites a reader's traps after its functions or lines changed
+	void refresh_reader(HSLBytecodeReader *p_reader);
+
+	//Picks up breakpoints and pause requests from the engine debugger; called once a frame
+	void sync();
+
+	//Called by the interpreter on HSL_OP_TRAP with the frame's ip on the trap. Returns the
+	//opcode the trap replaced, for the interpreter to dispatch as if nothing happened, or
+	//HSL_OP_TRAP itself if the function isn't known, which should end the script with an error.
+	uint8_t trap(HSLCallFrame *p_frame);
+
+	bool is_stopped() const { return break_frame != nullptr; }
+
+	String get_error() const { return break_error; }
+	int get_stack_level_count() const;
+	int get_stack_level_line(int p_level) const;
+	String get_stack_level_function(int p_level) const;
+	String get_stack_level_source(int p_level) const;
+	void get_stack_level_locals(int p_level, List<String> *p_locals, List<Variant> *p_values) const;
+	void get_stack_level_members(int p_level, List<String> *p_members, List<Variant> *p_values) const;
+	//Locals by name (local0, local1, ...) and self; anything else is an error string
+	String parse_stack_level_expression(int p_level, const String &p_expression) const;
+
+	HSLDebugger();
+	~HSLDebugger();
+};
+
+#endif
@@ -0,0 +1,501 @@
+#include "hsl_entity_grid.h"
+
+HSLEntityGrid *HSLEntityGrid::active = nullptr;
+
+void HSLEntityGrid::make_active(){
+	active = this;
+}
+
+uint32_t HSLEntityGrid::_get_cell(float p_x, float p_y){
+	Vector2i coord(_cell_coord(p_x), _cell_coord(p_y));
+	uint64_t key = _cell_key(coord.x, coord.y);
+
+	HashMap<uint64_t, uint32_t>::Iterator E = cell_lookup.find(key);
+	if (E){
+		return E->value;
+	}
+
+	//cells are never removed while the grid is in use, an empty one is cheap to keep around
+	if (cells.is_empty()){
+		cell_min = coord;
+		cell_max = coord;
+	} else {
+		cell_min = cell_min.min(coord);
+		cell_max = cell_max.max(coord);
+	}
+
+	uint32_t index = cells.size();
+	cells.push_back(Cell());
+	cells[index].x = coord.x;
+	cells[index].y = coord.y;
+	cell_lookup.insert(key, index);
+	return index;
+}
+
+void HSLEntityGrid::_insert_into_cell(uint32_t p_slot){
+	uint32_t cell = _get_cell(center_x[p_slot], center_y[p_slot]);
+	slot_cell[p_slot] = cell;
+	slot_cell_index[p_slot] = cells[cell].slots.size();
+	cells[cell].slots.push_back(p_slot);
+}
+
+void HSLEntityGrid::_remove_from_cell(uint32_t p_slot){
+	LocalVector<uint32_t> &slots = cells[slot_cell[p_slot]].slots;
+	uint32_t index = slot_cell_index[p_slot];
+
+	uint32_t last = slots[slots.size() - 1];
+	slots[index] = last;
+	slot_cell_index[last] = index;
+	slots.resize(slots.size() - 1);
+}
+
+template <typename F>
+void HSLEntityGrid::_visit_rect(const Rect2 &p_rect, uint32_t p_mask, F p_visitor) const {
+	if (cells.is_empty()){
+		return;
+	}
+
+	//an entity is only filed under its center, so anything reaching into the rect has its
+	//center at most max_half_extent outside of it
+	Vector2 from = p_rect.position - Vector2(max_half_extent, max_half_extent);
+	Vector2 to = p_rect.get_end() + Vector2(max_half_extent, max_half_extent);
+
+	float min_x = p_rect.position.x;
+	float min_y = p_rect.position.y;
+	float max_x = p_rect.position.x + p_rect.size.x;
+	float max_y = p_rect.position.y + p_rect.size.y;
+
+	//no cell exists outside the occupied bounds, so there is nothing to look up there
+	int64_t cell_from_x = MAX(_cell_coord(from.x), cell_min.x);
+	int64_t cell_from_y = MAX(_cell_coord(from.y), cell_min.y);
+	int64_t cell_to_x = MIN(_cell_coord(to.x), cell_max.x);
+	int64_t cell_to_y = MIN(_cell_coord(to.y), cell_max.y);
+
+	if (cell_from_x > cell_to_x or cell_from_y > cell_to_y){
+		return;
+	}
+
+	auto visit_cell = [&](const Cell &p_cell){
+		for (uint32_t slot : p_cell.slots){
+			if ((layers[slot] & p_mask) == 0){
+				continue;
+			}
+
+			if (center_x[slot] + half_w[slot] < min_x or center_x[slot] - half_w[slot] > max_x or
+					center_y[slot] + half_h[slot] < min_y or center_y[slot] - half_h[slot] > max_y){
+				continue;
+			}
+
+			p_visitor(slot);
+		}
+	};
+
+	//a rect covering more cells than exist is cheaper to answer by walking the cells themselves
+	uint64_t rect_cells = (uint64_t)(cell_to_x - cell_from_x + 1) * (uint64_t)(cell_to_y - cell_from_y + 1);
+
+	if (rect_cells > cells.size()){
+		for (const Cell &cell : cells){
+			if (cell.x >= cell_from_x and cell.x <= cell_to_x and cell.y >= cell_from_y and cell.y <= cell_to_y){
+				visit_cell(cell);
+			}
+		}
+		return;
+	}
+
+	for (int64_t cy = cell_from_y; cy <= cell_to_y; cy++){
+		for (int64_t cx = cell_from_x; cx <= cell_to_x; cx++){
+			HashMap<uint64_t, uint32_t>::ConstIterator E = cell_lookup.find(_cell_key((int32_t)cx, (int32_t)cy));
+			if (E){
+				visit_cell(cells[E->value]);
+			}
+		}
+	}
+}
+
+void HSLEntityGrid::set_cell_size(float size){
+	ERR_FAIL_COND_MSG(size <= 0.0, "Cell size must be positive.");
+
+	cell_size = size;
+	inv_cell_size = 1.0 / size;
+
+	//refile everything under the new cells, which also drops any cells left empty
+	cell_lookup.clear();
+	cells.clear();
+	max_half_extent = 0.0;
+	for (uint32_t i = 0; i < slot_ids.size(); i++){
+		max_half_extent = MAX(max_half_extent, MAX(half_w[i], half_h[i]));
+		_insert_into_cell(i);
+	}
+}
+
+float HSLEntityGrid::get_cell_size() const {
+	return cell_size;
+}
+
+int HSLEntityGrid::add_entity(Rect2 rect, int layer_mask){
+	rect = rect.abs();
+
+	int32_t id;
+	if (free_ids.size() > 0){
+		id = free_ids[free_ids.size() - 1];
+		free_ids.resize(free_ids.size() - 1);
+	} else {
+		id = id_slots.size();
+		id_slots.push_back(HSL_ENTITY_INVALID);
+	}
+
+	uint32_t slot = slot_ids.size();
+	id_slots[id] = slot;
+
+	Vector2 half = rect.size * 0.5;
+	center_x.push_back(rect.position.x + half.x);
+	center_y.push_back(rect.position.y + half.y);
+	half_w.push_back(half.x);
+	half_h.push_back(half.y);
+	layers.push_back((uint32_t)layer_mask);
+	slot_ids.push_back(id);
+	slot_cell.push_back(0);
+	slot_cell_index.push_back(0);
+
+	//only ever grows, so queries may look a little further than needed after big entities go away
+	max_half_extent = MAX(max_half_extent, MAX(half.x, half.y));
+
+	_insert_into_cell(slot);
+	return id;
+}
+
+void HSLEntityGrid::remove_entity(int id){
+	ERR_FAIL_COND(not has_entity(id));
+
+	uint32_t slot = id_slots[id];
+	_remove_from_cell(slot);
+
+	//move the last entity into the freed slot to keep the arrays dense
+	uint32_t last = slot_ids.size() - 1;
+	if (slot != last){
+		center_x[slot] = center_x[last];
+		center_y[slot] = center_y[last];
+		half_w[slot] = half_w[last];
+		half_h[slot] = half_h[last];
+		layers[slot] = layers[last];
+		slot_ids[slot] = slot_ids[last];
+		slot_cell[slot] = slot_cell[last];
+		slot_cell_index[slot] = slot_cell_index[last];
+
+		cells[slot_cell[slot]].slots[slot_cell_index[slot]] = slot;
+		id_slots[slot_ids[slot]] = slot;
+	}
+
+	center_x.resize(last);
+	center_y.resize(last);
+	half_w.resize(last);
+	half_h.resize(last);
+	layers.resize(last);
+	slot_ids.resize(last);
+	slot_cell.resize(last);
+	slot_cell_index.resize(last);
+
+	id_slots[id] = HSL_ENTITY_INVALID;
+	free_ids.push_back(id);
+}
+
+bool HSLEntityGrid::has_entity(int id) const {
+	return id >= 0 and id < (int)id_slots.size() and id_slots[id] != HSL_ENTITY_INVALID;
+}
+
+void HSLEntityGrid::move_entity(int id, Vector2 position){
+	ERR_FAIL_COND(not has_entity(id));
+
+	uint32_t slot = id_slots[id];
+	int32_t old_cx = _cell_coord(center_x[slot]);
+	int32_t old_cy = _cell_coord(center_y[slot]);
+
+	center_x[slot] = position.x + half_w[slot];
+	center_y[slot] = position.y + half_h[slot];
+
+	if (_cell_coord(center_x[slot]) != old_cx or _cell_coord(center_y[slot]) != old_cy){
+		_remove_from_cell(slot);
+		_insert_into_cell(slot);
+	}
+}
+
+void HSLEntityGrid::set_entity_rect(int id, Rect2 rect){
+	ERR_FAIL_COND(not has_entity(id));
+
+	rect = rect.abs();
+	uint32_t slot = id_slots[id];
+
+	Vector2 half = rect.size * 0.5;
+	half_w[slot] = half.x;
+	half_h[slot] = half.y;
+	max_half_extent = MAX(max_half_extent, MAX(half.x, half.y));
+
+	move_entity(id, rect.position);
+}
+
+Rect2 HSLEntityGrid::get_entity_rect(int id) const {
+	ERR_FAIL_COND_V(not has_entity(id), Rect2());
+
+	uint32_t slot = id_slots[id];
+	return Rect2(center_x[slot] - half_w[slot], center_y[slot] - half_h[slot], half_w[slot] * 2.0, half_h[slot] * 2.0);
+}
+
+void HSLEntityGrid::move_entities(PackedInt32Array ids, PackedVector2Array positions){
+	ERR_FAIL_COND_MSG(ids.size() != positions.size(), "Every id needs a position.");
+
+	const int32_t *id_ptr = ids.ptr();
+	const Vector2 *position_ptr = positions.ptr();
+	for (int i = 0; i < ids.size(); i++){
+		move_entity(id_ptr[i], position_ptr[i]);
+	}
+}
+
+PackedInt32Array HSLEntityGrid::query_rect(Rect2 rect, int layer_mask) const {
+	PackedInt32Array found;
+	_visit_rect(rect.abs(), (uint32_t)layer_mask, [&](uint32_t p_slot){
+		found.push_back(slot_ids[p_slot]);
+	});
+	return found;
+}
+
+PackedInt32Array HSLEntityGrid::query_radius(Vector2 center, float radius, int layer_mask) const {
+	PackedInt32Array found;
+	float radius_squared = radius * radius;
+
+	_visit_rect(Rect2(center - Vector2(radius, radius), Vector2(radius, radius) * 2.0), (uint32_t)layer_mask, [&](uint32_t p_slot){
+		//distance from the circle center to the closest point of the box
+		float dx = MAX(Math::abs(center.x - center_x[p_slot]) - half_w[p_slot], 0.0f);
+		float dy = MAX(Math::abs(center.y - center_y[p_slot]) - half_h[p_slot], 0.0f);
+		if (dx * dx + dy * dy <= radius_squared){
+			found.push_back(slot_ids[p_slot]);
+		}
+	});
+	return found;
+}
+
+int HSLEntityGrid::find_nearest(Vector2 point, float max_distance, int layer_mask, int exclude) const {
+	int nearest = HSL_ENTITY_INVALID;
+	float nearest_squared = max_distance * max_distance;
+
+	_visit_rect(Rect2(point - Vector2(max_distance, max_distance), Vector2(max_distance, max_distance) * 2.0), (uint32_t)layer_mask, [&](uint32_t p_slot){
+		if (slot_ids[p_slot] == exclude){
+			return;
+		}
+
+		float dx = center_x[p_slot] - point.x;
+		float dy = center_y[p_slot] - point.y;
+		float distance_squared = dx * dx + dy * dy;
+		if (distance_squared <= nearest_squared){
+			nearest_squared = distance_squared;
+			nearest = slot_ids[p_slot];
+		}
+	});
+	return nearest;
+}
+
+PackedInt32Array HSLEntityGrid::get_collisions(int id, int layer_mask) const {
+	ERR_FAIL_COND_V(not has_entity(id), PackedInt32Array());
+
+	uint32_t slot = id_slots[id];
+	Rect2 bounds(center_x[slot] - half_w[slot], center_y[slot] - half_h[slot], half_w[slot] * 2.0, half_h[slot] * 2.0);
+
+	PackedInt32Array found;
+	_visit_rect(bounds, (uint32_t)layer_mask, [&](uint32_t p_slot){
+		if (p_slot != slot){
+			found.push_back(slot_ids[p_slot]);
+		}
+	});
+	return found;
+}
+
+PackedInt32Array HSLEntityGrid::get_collision_pairs(int layer_mask) const {
+	PackedInt32Array pairs;
+
+	for (uint32_t slot = 0; slot < slot_ids.size(); slot++){
+		if ((layers[slot] & (uint32_t)layer_mask) == 0){
+			continue;
+		}
+
+		Rect2 bounds(center_x[slot] - half_w[slot], center_y[slot] - half_h[slot], half_w[slot] * 2.0, half_h[slot] * 2.0);
+		_visit_rect(bounds, (uint32_t)layer_mask, [&](uint32_t p_other){
+			//each pair is seen from both sides, only report it from the lower slot
+			if (p_other > slot){
+				pairs.push_back(slot_ids[slot]);
+				pairs.push_back(slot_ids[p_other]);
+			}
+		});
+	}
+	return pairs;
+}
+
+int HSLEntityGrid::fill_results_rect(const Rect2 &p_rect, uint32_t p_mask){
+	results.clear();
+	_visit_rect(p_rect.abs(), p_mask, [&](uint32_t p_slot){
+		results.push_back(slot_ids[p_slot]);
+	});
+	return results.size();
+}
+
+int HSLEntityGrid::fill_results_radius(const Vector2 &p_center, float p_radius, uint32_t p_mask){
+	results.clear();
+	float radius_squared = p_radius * p_radius;
+
+	_visit_rect(Rect2(p_center - Vector2(p_radius, p_radius), Vector2(p_radius, p_radius) * 2.0), p_mask, [&](uint32_t p_slot){
+		float dx = MAX(Math::abs(p_center.x - center_x[p_slot]) - half_w[p_slot], 0.0f);
+		float dy = MAX(Math::abs(p_center.y - center_y[p_slot]) - half_h[p_slot], 0.0f);
+		if (dx * dx + dy * dy <= radius_squared){
+			results.push_back(slot_ids[p_slot]);
+		}
+	});
+	return results.size();
+}
+
+int HSLEntityGrid::get_result(int p_index) const {
+	if (p_index < 0 or p_index >= (int)results.size()){
+		return HSL_ENTITY_INVALID;
+	}
+	return results[p_index];
+}
+
+int HSLEntityGrid::get_entity_count() const {
+	return slot_ids.size();
+}
+
+int HSLEntityGrid::get_cell_count() const {
+	return cells.size();
+}
+
+void HSLEntityGrid::clear(){
+	center_x.clear();
+	center_y.clear();
+	half_w.clear();
+	half_h.clear();
+	layers.clear();
+	slot_ids.clear();
+	slot_cell.clear();
+	slot_cell_index.clear();
+	id_slots.clear();
+	free_ids.clear();
+	cell_lookup.clear();
+	cells.clear();
+	results.clear();
+	max_half_extent = 0.0;
+}
+
+void HSLEntityGrid::_bind_methods(){
+	ClassDB::bind_method(D_METHOD("make_active"), &HSLEntityGrid::make_active);
+
+	ClassDB::bind_method(D_METHOD("set_cell_size", "size"), &HSLEntityGrid::set_cell_size);
+	ClassDB::bind_method(D_METHOD("get_cell_size"), &HSLEntityGrid::get_cell_size);
+
+	ClassDB::bind_method(D_METHOD("add_entity", "rect", "layer_mask"), &HSLEntityGrid::add_entity, DEFVAL(1));
+	ClassDB::bind_method(D_METHOD("remove_entity", "id"), &HSLEntityGrid::remove_entity);
+	ClassDB::bind_method(D_METHOD("has_entity", "id"), &HSLEntityGrid::has_entity);
+	ClassDB::bind_method(D_METHOD("move_entity", "id", "position"), &HSLEntityGrid::move_entity);
+	ClassDB::bind_method(D_METHOD("set_entity_rect", "id", "rect"), &HSLEntityGrid::set_entity_rect);
+	ClassDB::bind_method(D_METHOD("get_entity_rect", "id"), &HSLEntityGrid::get_entity_rect);
+	ClassDB::bind_method(D_METHOD("move_entities", "ids", "positions"), &HSLEntityGrid::move_entities);
+
+	ClassDB::bind_method(D_METHOD("query_rect", "rect", "layer_mask"), &HSLEntityGrid::query_rect, DEFVAL(-1));
+	ClassDB::bind_method(D_METHOD("query_radius", "center", "radius", "layer_mask"), &HSLEntityGrid::query_radius, DEFVAL(-1));
+	ClassDB::bind_method(D_METHOD("find_nearest", "point", "max_distance", "layer_mask", "exclude"), &HSLEntityGrid::find_nearest, DEFVAL(-1), DEFVAL(HSL_ENTITY_INVALID));
+	ClassDB::bind_method(D_METHOD("get_collisions", "id", "layer_mask"), &HSLEntityGrid::get_collisions, DEFVAL(-1));
+	ClassDB::bind_method(D_METHOD("get_collision_pairs", "layer_mask"), &HSLEntityGrid::get_collision_pairs, DEFVAL(-1));
+
+	ClassDB::bind_method(D_METHOD("get_entity_count"), &HSLEntityGrid::get_entity_count);
+	ClassDB::bind_method(D_METHOD("get_cell_count"), &HSLEntityGrid::get_cell_count);
+	ClassDB::bind_method(D_METHOD("clear"), &HSLEntityGrid::clear);
+
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "cell_size", PROPERTY_HINT_RANGE, "1,1024,1,or_greater"), "set_cell_size", "get_cell_size");
+}
+
+HSLEntityGrid::~HSLEntityGrid(){
+	if (active == this){
+		active = nullptr;
+	}
+}
+
+/* HSL natives, working on whichever grid is active */
+
+static int32_t hsl_grid_add(float p_x, float p_y, float p_w, float p_h, int32_t p_layers) {
+	if (HSLEntityGrid::get_active() == nullptr) {
+		return HSL_ENTITY_INVALID;
+	}
+	return HSLEntityGrid::get_active()->add_entity(Rect2(p_x, p_y, p_w, p_h), p_layers);
+}
+
+static void hsl_grid_remove(int32_t p_id) {
+	if (HSLEntityGrid::get_active() != nullptr and HSLEntityGrid::get_active()->has_entity(p_id)) {
+		HSLEntityGrid::get_active()->remove_entity(p_id);
+	}
+}
+
+static void hsl_grid_move(int32_t p_id, float p_x, float p_y) {
+	if (HSLEntityGrid::get_active() != nullptr and HSLEntityGrid::get_active()->has_entity(p_id)) {
+		HSLEntityGrid::get_active()->move_entity(p_id, Vector2(p_x, p_y));
+	}
+}
+
+static int32_t hsl_grid_query_rect(float p_x, float p_y, float p_w, float p_h, int32_t p_layers) {
+	if (HSLEntityGrid::get_active() == nullptr) {
+		return 0;
+	}
+	return HSLEntityGrid::get_active()->fill_results_rect(Rect2(p_x, p_y, p_w, p_h), (uint32_t)p_layers);
+}
+
+static int32_t hsl_grid_query_radius(float p_x, float p_y, float p_radius, int32_t p_layers) {
+	if (HSLEntityGrid::get_active() == nullptr) {
+		return 0;
+	}
+	return HSLEntityGrid::get_active()->fill_results_radius(Vector2(p_x, p_y), p_radius, (uint32_t)p_layers);
+}
+
+static int32_t hsl_grid_get_result(int32_t p_index) {
+	if (HSLEntityGrid::get_active() == nullptr) {
+		return HSL_ENTITY_INVALID;
+	}
+	return HSLEntityGrid::get_active()->get_result(p_index);
+}
+
+static int32_t hsl_grid_nearest(float p_x, float p_y, float p_max_distance, int32_t p_layers, int32_t p_exclude) {
+	if (HSLEntityGrid::get_active() == nullptr) {
+		return HSL_ENTITY_INVALID;
+	}
+	return HSLEntityGrid::get_active()->find_nearest(Vector2(p_x, p_y), p_max_distance, p_layers, p_exclude);
+}
+
+static bool hsl_grid_overlaps(int32_t p_a, int32_t p_b) {
+	HSLEntityGrid *grid = HSLEntityGrid::get_active();
+	if (grid == nullptr or not grid->has_entity(p_a) or not grid->has_entity(p_b)) {
+		return false;
+	}
+	return grid->get_entity_rect(p_a).intersects(grid->get_entity_rect(p_b), true);
+}
+
+//First entity overlapping p_id on the given layers, so a script can react without a result loop
+static int32_t hsl_grid_collide_first(int32_t p_id, int32_t p_layers) {
+	HSLEntityGrid *grid = HSLEntityGrid::get_active();
+	if (grid == nullptr or not grid->has_entity(p_id)) {
+		return HSL_ENTITY_INVALID;
+	}
+
+	int count = grid->fill_results_rect(grid->get_entity_rect(p_id), (uint32_t)p_layers);
+	for (int i = 0; i < count; i++) {
+		if (grid->get_result(i) != p_id) {
+			return grid->get_result(i);
+		}
+	}
+	return HSL_ENTITY_INVALID;
+}
+
+void hsl_register_entity_grid_natives(HSLNativeRegistry *p_registry){
+	HSL_BIND_NATIVE(p_registry, "Grid", "Add", &hsl_grid_add);
+	HSL_BIND_NATIVE(p_registry, "Grid", "Remove", &hsl_grid_remove);
+	HSL_BIND_NATIVE(p_registry, "Grid", "Move", &hsl_grid_move);
+	HSL_BIND_NATIVE(p_registry, "Grid", "QueryRect", &hsl_grid_query_rect);
+	HSL_BIND_NATIVE(p_registry, "Grid", "QueryRadius", &hsl_grid_query_radius);
+	HSL_BIND_NATIVE(p_registry, "Grid", "GetResult", &hsl_grid_get_result);
+	HSL_BIND_NATIVE(p_registry, "Grid", "Nearest", &hsl_grid_nearest);
+	HSL_BIND_NATIVE(p_registry, "Grid", "Overlaps", &hsl_grid_overlaps);
+	HSL_BIND_NATIVE(p_registry, "Grid", "CollideFirst", &hsl_grid_collide_first);
+}
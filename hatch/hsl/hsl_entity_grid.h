@@ -0,0 +1,119 @@
+#ifndef HATCH_HSL_ENTITY_GRID_H
+#define HATCH_HSL_ENTITY_GRID_H
+
+#include "hsl_native.h"
+
+#include "core/math/rect2.h"
+#include "core/math/vector2i.h"
+#include "core/object/ref_counted.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+
+#define HSL_ENTITY_INVALID -1
+
+/*
+ Loose uniform grid over HSL entity bounding boxes. Entities live in dense SoA arrays (one
+ array per field, swap-removed) and are bucketed by the cell their center is in; queries grow
+ the searched cells by the largest half extent, so an entity never has to be in more than
+ one cell. Moving an entity is free unless its center crosses into another cell.
+ */
+class HSLEntityGrid : public RefCounted {
+	GDCLASS(HSLEntityGrid, RefCounted);
+
+	struct Cell {
+		int32_t x = 0;
+		int32_t y = 0;
+		LocalVector<uint32_t> slots;
+	};
+
+	static HSLEntityGrid *active;
+
+	float cell_size = 64.0;
+	float inv_cell_size = 1.0 / 64.0;
+
+	//dense per-entity fields, indexed by slot
+	LocalVector<float> center_x;
+	LocalVector<float> center_y;
+	LocalVector<float> half_w;
+	LocalVector<float> half_h;
+	LocalVector<uint32_t> layers;
+	LocalVector<int32_t> slot_ids;
+	LocalVector<uint32_t> slot_cell;
+	LocalVector<uint32_t> slot_cell_index;
+
+	//stable entity id -> slot, with freed ids reused
+	LocalVector<int32_t> id_slots;
+	LocalVector<int32_t> free_ids;
+
+	HashMap<uint64_t, uint32_t> cell_lookup;
+	LocalVector<Cell> cells;
+
+	//bounds of every cell in cells, so queries never walk empty space
+	Vector2i cell_min;
+	Vector2i cell_max;
+
+	float max_half_extent = 0.0;
+
+	//Query results for HSL, which can't take arrays
+	LocalVector<int32_t> results;
+
+	//saturates instead of overflowing the cast for huge, infinite or NaN values
+	_FORCE_INLINE_ int32_t _cell_coord(float p_value) const {
+		float coord = Math::floor(p_value * inv_cell_size);
+		if (not (coord > (float)INT32_MIN)){
+			return INT32_MIN;
+		}
+		if (coord >= (float)INT32_MAX){
+			return INT32_MAX;
+		}
+		return (int32_t)coord;
+	}
+	_FORCE_INLINE_ static uint64_t _cell_key(int32_t p_x, int32_t p_y) { return ((uint64_t)(uint32_t)p_x << 32) | (uint32_t)p_y; }
+
+	uint32_t _get_cell(float p_x, float p_y);
+	void _insert_into_cell(uint32_t p_slot);
+	void _remove_from_cell(uint32_t p_slot);
+
+	template <typename F>
+	void _visit_rect(const Rect2 &p_rect, uint32_t p_mask, F p_visitor) const;
+
+protected:
+	static void _bind_methods();
+
+public:
+	static HSLEntityGrid *get_active() { return active; }
+	void make_active();
+
+	void set_cell_size(float size);
+	float get_cell_size() const;
+
+	int add_entity(Rect2 rect, int layer_mask = 1);
+	void remove_entity(int id);
+	bool has_entity(int id) const;
+
+	void move_entity(int id, Vector2 position);
+	void set_entity_rect(int id, Rect2 rect);
+	Rect2 get_entity_rect(int id) const;
+	void move_entities(PackedInt32Array ids, PackedVector2Array positions);
+
+	PackedInt32Array query_rect(Rect2 rect, int layer_mask = -1) const;
+	PackedInt32Array query_radius(Vector2 center, float radius, int layer_mask = -1) const;
+	int find_nearest(Vector2 point, float max_distance, int layer_mask = -1, int exclude = HSL_ENTITY_INVALID) const;
+	PackedInt32Array get_collisions(int id, int layer_mask = -1) const;
+	PackedInt32Array get_collision_pairs(int layer_mask = -1) const;
+
+	//Fills the internal result list for HSL, returns how many entries it has
+	int fill_results_rect(const Rect2 &p_rect, uint32_t p_mask);
+	int fill_results_radius(const Vector2 &p_center, float p_radius, uint32_t p_mask);
+	int get_result(int p_index) const;
+
+	int get_entity_count() const;
+	int get_cell_count() const;
+	void clear();
+
+	~HSLEntityGrid();
+};
+
+void hsl_register_entity_grid_natives(HSLNativeRegistry *p_registry);
+
+#endif
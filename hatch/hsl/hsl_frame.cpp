@@ -0,0 +1,113 @@
+#include "hsl_frame.h"
+#include "../hatch_performance.h"
+
+#include "core/os/memory.h"
+#include "core/os/mutex.h"
+
+//Owns every frame block for the life of the process; see HSLFramePool
+struct HSLFrameReserve {
+	Mutex mutex;
+	LocalVector<HSLCallFrame *> blocks;
+	HSLFramePool::FreeFrame *spare = nullptr;
+
+	~HSLFrameReserve(){
+		for (HSLCallFrame *block : blocks){
+			memfree(block);
+		}
+	}
+};
+
+//thread_local objects are destroyed before statics, so this outlives even the main thread's pool
+static HSLFrameReserve frame_reserve;
+static thread_local HSLFramePool thread_frame_pool;
+
+HSLFramePool *HSLFramePool::get_thread_pool(){
+	return &thread_frame_pool;
+}
+
+void HSLFramePool::_grow(){
+	MutexLock lock(frame_reserve.mutex);
+
+	//frames left behind by exited threads first, a block at a time
+	if (frame_reserve.spare != nullptr){
+		uint32_t taken = 0;
+		while (frame_reserve.spare != nullptr and taken < HSL_FRAME_POOL_BLOCK){
+			FreeFrame *free_frame = frame_reserve.spare;
+			frame_reserve.spare = free_frame->next;
+			free_frame->next = free_list;
+			free_list = free_frame;
+			taken++;
+		}
+
+		frames_total += taken;
+		return;
+	}
+
+	HSLCallFrame *block = (HSLCallFrame *)memalloc(sizeof(HSLCallFrame) * HSL_FRAME_POOL_BLOCK);
+	frame_reserve.blocks.push_back(block);
+
+	//thread the new frames onto the free list back to front so they come out in address order
+	for (int i = HSL_FRAME_POOL_BLOCK - 1; i >= 0; i--){
+		FreeFrame *free_frame = (FreeFrame *)&block[i];
+		free_frame->next = free_list;
+		free_list = free_frame;
+	}
+
+	frames_total += HSL_FRAME_POOL_BLOCK;
+	HatchPerformance::add(HatchPerformance::HSL_HEAP_ALLOCATIONS);
+}
+
+HSLCallFrame *HSLFramePool::acquire(const HSLBytecodeReader *p_module, uint32_t p_function_hash, ObjectID p_owner, HSLCallFrame *p_caller){
+	if (unlikely(free_list == nullptr)){
+		_grow();
+	}
+
+	HSLCallFrame *frame = (HSLCallFrame *)free_list;
+	free_list = free_list->next;
+	frames_in_use++;
+
+	//only the header is reset, the slots are written before they are read
+	frame->caller = p_caller;
+	frame->module = p_module;
+	frame->function_hash = p_function_hash;
+	frame->ip = 0;
+	frame->stack_top = 0;
+	frame->local_count = 0;
+	frame->owner = p_owner;
+
+	return frame;
+}
+
+void HSLFramePool::release(HSLCallFrame *p_frame){
+	ERR_FAIL_NULL(p_frame);
+
+	FreeFrame *free_frame = (FreeFrame *)p_frame;
+	free_frame->next = free_list;
+	free_list = free_frame;
+	frames_in_use--;
+}
+
+void HSLFramePool::release_chain(HSLCallFrame *p_top){
+	while (p_top != nullptr){
+		HSLCallFrame *caller = p_top->caller;
+		release(p_top);
+		p_top = caller;
+	}
+}
+
+HSLFramePool::~HSLFramePool(){
+	if (free_list == nullptr){
+		return;
+	}
+
+	//frames from other threads can be in this list too; they all live in reserve blocks
+	FreeFrame *tail = free_list;
+	while (tail->next != nullptr){
+		tail = tail->next;
+	}
+
+	MutexLock lock(frame_reserve.mutex);
+	tail->next = frame_reserve.spare;
+	frame_reserve.spare = free_list;
+	free_list = nullptr;
+}
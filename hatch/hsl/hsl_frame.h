@@ -0,0 +1,90 @@
+#ifndef HATCH_HSL_FRAME_H
+#define HATCH_HSL_FRAME_H
+
+#include "hsl_value.h"
+
+#include "core/object/object_id.h"
+#include "core/templates/local_vector.h"
+
+//Operand stack plus locals per frame; Hatch functions rarely come near this
+#define HSL_FRAME_SLOT_COUNT 64
+
+//How many frames a pool grabs from the allocator at once
+#define HSL_FRAME_POOL_BLOCK 128
+
+class HSLBytecodeReader;
+
+/*
+ A call frame lives on the heap instead of the native stack, so a script can stop in the
+ middle of a function (wait, yield) and pick up later without holding an OS thread. A
+ suspended script costs exactly its chain of frames.
+ */
+struct HSLCallFrame {
+	HSLCallFrame *caller;
+
+	//function hashes are only unique within the module they were loaded from
+	const HSLBytecodeReader *module;
+	uint32_t function_hash;
+	uint32_t ip;
+	uint16_t stack_top;
+	uint16_t local_count;
+
+	ObjectID owner;
+
+	HSLValue slots[HSL_FRAME_SLOT_COUNT];
+
+	_FORCE_INLINE_ bool push(const HSLValue &p_value) {
+		if (unlikely(stack_top >= HSL_FRAME_SLOT_COUNT)) {
+			return false;
+		}
+		slots[stack_top++] = p_value;
+		return true;
+	}
+
+	_FORCE_INLINE_ HSLValue pop() {
+		if (unlikely(stack_top <= local_count)) {
+			return HSLValue::make_null();
+		}
+		return slots[--stack_top];
+	}
+};
+
+/*
+ Per-thread free list of frames, so entering and leaving functions never touches the
+ allocator once warm. A frame released on another thread simply joins that thread's free
+ list. That is only safe because blocks don't belong to a thread: when a thread exits, its
+ pool hands its free frames to a process-wide reserve instead of freeing anything, since
+ frames carved from its blocks may still be running or sitting in other threads' free lists.
+ New pools draw from the reserve before allocating, and the blocks go at process exit.
+ */
+class HSLFramePool {
+	friend struct HSLFrameReserve;
+
+	struct FreeFrame {
+		FreeFrame *next;
+	};
+
+	FreeFrame *free_list = nullptr;
+
+	//frames this pool has taken from blocks or the reserve
+	uint32_t frames_total = 0;
+	//signed, since a frame acquired elsewhere can be released into this pool
+	int32_t frames_in_use = 0;
+
+	void _grow();
+
+public:
+	static HSLFramePool *get_thread_pool();
+
+	HSLCallFrame *acquire(const HSLBytecodeReader *p_module, uint32_t p_function_hash, ObjectID p_owner, HSLCallFrame *p_caller = nullptr);
+	void release(HSLCallFrame *p_frame);
+	void release_chain(HSLCallFrame *p_top);
+
+	uint32_t get_frames_total() const { return frames_total; }
+	int32_t get_frames_in_use() const { return frames_in_use; }
+	uint64_t get_bytes_reserved() const { return (uint64_t)frames_total * sizeof(HSLCallFrame); }
+
+	~HSLFramePool();
+};
+
+#endif
@@ -1,9 +1,17 @@
 #include "hsl_lang.h"
+#include "hsl_debugger.h"
+#include "hsl_script.h"
+#include "hsl_shape.h"
 
 void HatchScriptLanguage::load_objects_hcm(){
 	ERR_FAIL_COND_MSG(objects_hcm_path.is_empty(), "The path to Objects.hcm is empty, so HSL cannot be loaded");
 	ERR_FAIL_COND_MSG(not objects_hcm_path.is_valid_filename(), "The path to Objects.hcm is invalid, so HSL cannot be loaded");
 
+	//one root shape per class, so instances of it share layouts from the first one on
+	HSLShapeTable *shapes = HSLShapeTable::get_singleton();
+	ERR_FAIL_NULL(shapes);
+	Error err = shapes->load_class_map_file(objects_hcm_path);
+	ERR_FAIL_COND_MSG(err != OK, "Could not read Objects.hcm, so HSL cannot be loaded");
 }
 
 String HatchScriptLanguage::get_name() const{
@@ -11,7 +19,10 @@ String HatchScriptLanguage::get_name() const{
 }
 
 void HatchScriptLanguage::init(){
-
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	if (debugger != nullptr){
+		debugger->set_language(this);
+	}
 }
 
 String HatchScriptLanguage::get_type() const {
@@ -29,3 +40,77 @@ void HatchScriptLanguage::finish(){
 void HatchScriptLanguage::get_reserved_words(List<String> *p_words) const {
 
 }
+
+void HatchScriptLanguage::frame(){
+	//the scheduler and the debugger step from the module's SceneTree idle callback, language or not
+}
+
+String HatchScriptLanguage::debug_get_error() const {
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	return debugger != nullptr ? debugger->get_error() : String();
+}
+
+int HatchScriptLanguage::debug_get_stack_level_count() const {
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	return debugger != nullptr ? debugger->get_stack_level_count() : 0;
+}
+
+int HatchScriptLanguage::debug_get_stack_level_line(int p_level) const {
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	return debugger != nullptr ? debugger->get_stack_level_line(p_level) : -1;
+}
+
+String HatchScriptLanguage::debug_get_stack_level_function(int p_level) const {
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	return debugger != nullptr ? debugger->get_stack_level_function(p_level) : String();
+}
+
+String HatchScriptLanguage::debug_get_stack_level_source(int p_level) const {
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	return debugger != nullptr ? debugger->get_stack_level_source(p_level) : String();
+}
+
+void HatchScriptLanguage::debug_get_stack_level_locals(int p_level, List<String> *p_locals, List<Variant> *p_values, int p_max_subitems, int p_max_depth){
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	if (debugger != nullptr){
+		debugger->get_stack_level_locals(p_level, p_locals, p_values);
+	}
+}
+
+void HatchScriptLanguage::debug_get_stack_level_members(int p_level, List<String> *p_members, List<Variant> *p_values, int p_max_subitems, int p_max_depth){
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	if (debugger != nullptr){
+		debugger->get_stack_level_members(p_level, p_members, p_values);
+	}
+}
+
+String HatchScriptLanguage::debug_parse_stack_level_expression(int p_level, const String &p_expression, int p_max_subitems, int p_max_depth){
+	HSLDebugger *debugger = HSLDebugger::get_singleton();
+	return debugger != nullptr ? debugger->parse_stack_level_expression(p_level, p_expression) : String();
+}
+
+void HatchScriptLanguage::reload_all_scripts(){
+	//scripts load their modules through HSLBytecodeReader::load_file, so they are all in here
+	HSLBytecodeReader::reload_modules();
+}
+
+void HatchScriptLanguage::reload_scripts(const Array &p_scripts, bool p_soft_reload){
+	for (int i = 0; i < p_scripts.size(); i++){
+		Ref<HatchScript> script = p_scripts[i];
+		if (script.is_null()){
+			continue;
+		}
+
+		//a soft reload keeps instances and only swaps the functions that changed
+		Error err = script->reload(p_soft_reload);
+		if (err != OK){
+			WARN_PRINT("Could not reload HSL script \"" + script->get_path() + "\".");
+		}
+	}
+}
+
+void HatchScriptLanguage::reload_tool_script(const Ref<Script> &p_script, bool p_soft_reload){
+	Array scripts;
+	scripts.push_back(p_script);
+	reload_scripts(scripts, p_soft_reload);
+}
@@ -0,0 +1,38 @@
+#include "hsl_native.h"
+
+HSLNativeRegistry *HSLNativeRegistry::singleton = nullptr;
+
+HSLNativeRegistry *HSLNativeRegistry::get_singleton(){
+	return singleton;
+}
+
+void HSLNativeRegistry::add_native(const char *p_class_name, const char *p_name, HSLNativeCall p_call, int p_arity){
+	HSLNativeFunction native;
+	native.call = p_call;
+	native.class_name = p_class_name;
+	native.name = p_name;
+	native.class_hash = hash_name(p_class_name);
+	native.method_hash = hash_name(p_name);
+	native.arity = p_arity;
+
+	uint64_t key = _make_key(native.class_hash, native.method_hash);
+
+	const HSLNativeFunction *existing = natives.getptr(key);
+	ERR_FAIL_COND_MSG(existing != nullptr, vformat("HSL native \"%s.%s\" collides with \"%s.%s\".", p_class_name, p_name, existing->class_name, existing->name));
+
+	natives.insert(key, native);
+}
+
+const HSLNativeFunction *HSLNativeRegistry::find(uint32_t p_class_hash, uint32_t p_method_hash) const {
+	return natives.getptr(_make_key(p_class_hash, p_method_hash));
+}
+
+HSLNativeRegistry::HSLNativeRegistry(){
+	singleton = this;
+}
+
+HSLNativeRegistry::~HSLNativeRegistry(){
+	if (singleton == this){
+		singleton = nullptr;
+	}
+}
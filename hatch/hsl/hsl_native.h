@@ -0,0 +1,179 @@
+#ifndef HATCH_HSL_NATIVE_H
+#define HATCH_HSL_NATIVE_H
+
+#include "hsl_value.h"
+#include "hsl_bytecode_reader.h"
+
+#include "core/templates/hash_map.h"
+
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+enum HSLNativeError : uint8_t {
+	HSL_NATIVE_OK,
+	HSL_NATIVE_BAD_ARGUMENT_COUNT,
+	HSL_NATIVE_BAD_ARGUMENT_TYPE,
+};
+
+//What the VM calls: raw values in, raw value out, no Variant and no allocation
+typedef HSLValue (*HSLNativeCall)(int p_argc, const HSLValue *p_args, HSLNativeError &r_error);
+
+struct HSLNativeFunction {
+	HSLNativeCall call;
+	const char *class_name;
+	const char *name;
+	uint32_t class_hash;
+	uint32_t method_hash;
+	int arity;
+};
+
+/*
+ Argument and return conversions, one specialization per C++ type a native may use.
+ Integer arguments take integers only, like the engine's own natives: a decimal is a bad
+ argument rather than being truncated. Decimal arguments take either.
+ */
+
+template <typename T>
+struct HSLNativeArg;
+
+template <>
+struct HSLNativeArg<int32_t> {
+	static _FORCE_INLINE_ bool check(const HSLValue &p_value) { return p_value.is_integer(); }
+	static _FORCE_INLINE_ int32_t get(const HSLValue &p_value) { return p_value.get_integer(); }
+};
+
+template <>
+struct HSLNativeArg<float> {
+	static _FORCE_INLINE_ bool check(const HSLValue &p_value) { return p_value.is_number(); }
+	static _FORCE_INLINE_ float get(const HSLValue &p_value) { return p_value.get_decimal(); }
+};
+
+template <>
+struct HSLNativeArg<bool> {
+	static _FORCE_INLINE_ bool check(const HSLValue &p_value) { return p_value.is_integer() or p_value.is_null(); }
+	static _FORCE_INLINE_ bool get(const HSLValue &p_value) { return p_value.get_integer() != 0; }
+};
+
+template <>
+struct HSLNativeArg<void *> {
+	static _FORCE_INLINE_ bool check(const HSLValue &p_value) { return p_value.is_object() or p_value.is_null(); }
+	static _FORCE_INLINE_ void *get(const HSLValue &p_value) { return p_value.is_object() ? p_value.as_object : nullptr; }
+};
+
+template <>
+struct HSLNativeArg<HSLValue> {
+	static _FORCE_INLINE_ bool check(const HSLValue &p_value) { return true; }
+	static _FORCE_INLINE_ HSLValue get(const HSLValue &p_value) { return p_value; }
+};
+
+template <typename T>
+struct HSLNativeReturn;
+
+template <>
+struct HSLNativeReturn<int32_t> {
+	static _FORCE_INLINE_ HSLValue make(int32_t p_value) { return HSLValue::make_integer(p_value); }
+};
+
+template <>
+struct HSLNativeReturn<float> {
+	static _FORCE_INLINE_ HSLValue make(float p_value) { return HSLValue::make_decimal(p_value); }
+};
+
+template <>
+struct HSLNativeReturn<bool> {
+	static _FORCE_INLINE_ HSLValue make(bool p_value) { return HSLValue::make_integer(p_value ? 1 : 0); }
+};
+
+template <>
+struct HSLNativeReturn<void *> {
+	static _FORCE_INLINE_ HSLValue make(void *p_value) { return p_value ? HSLValue::make_object(p_value) : HSLValue::make_null(); }
+};
+
+template <>
+struct HSLNativeReturn<HSLValue> {
+	static _FORCE_INLINE_ HSLValue make(HSLValue p_value) { return p_value; }
+};
+
+/*
+ Generates one trampoline per bound function at compile time. The function pointer is a
+ template argument, so the call inside the trampoline is direct and usually inlined.
+ */
+template <auto F>
+struct HSLNativeBinder;
+
+template <typename R, typename... Args, R (*F)(Args...)>
+struct HSLNativeBinder<F> {
+	static constexpr int arity = sizeof...(Args);
+
+	template <size_t... Is>
+	static _FORCE_INLINE_ bool check_args(const HSLValue *p_args, std::index_sequence<Is...>) {
+		return (true and ... and HSLNativeArg<std::decay_t<Args>>::check(p_args[Is]));
+	}
+
+	template <size_t... Is>
+	static _FORCE_INLINE_ HSLValue call_with(const HSLValue *p_args, std::index_sequence<Is...>) {
+		if constexpr (std::is_void_v<R>) {
+			F(HSLNativeArg<std::decay_t<Args>>::get(p_args[Is])...);
+			return HSLValue::make_null();
+		} else {
+			return HSLNativeReturn<std::decay_t<R>>::make(F(HSLNativeArg<std::decay_t<Args>>::get(p_args[Is])...));
+		}
+	}
+
+	static HSLValue call(int p_argc, const HSLValue *p_args, HSLNativeError &r_error) {
+		if (unlikely(p_argc != arity)) {
+			r_error = HSL_NATIVE_BAD_ARGUMENT_COUNT;
+			return HSLValue::make_null();
+		}
+
+		if (unlikely(not check_args(p_args, std::index_sequence_for<Args...>{}))) {
+			r_error = HSL_NATIVE_BAD_ARGUMENT_TYPE;
+			return HSLValue::make_null();
+		}
+
+		r_error = HSL_NATIVE_OK;
+		return call_with(p_args, std::index_sequence_for<Args...>{});
+	}
+};
+
+/*
+ A call like Math.Sin(x) compiles to a global lookup of "Math" and a method call of "Sin" on
+ it, each carrying the murmur hash of its own name, so natives are keyed by that pair. The VM
+ resolves a call site once and keeps the HSLNativeCall pointer from then on.
+ */
+class HSLNativeRegistry {
+	static HSLNativeRegistry *singleton;
+
+	HashMap<uint64_t, HSLNativeFunction> natives;
+
+	static _FORCE_INLINE_ uint64_t _make_key(uint32_t p_class_hash, uint32_t p_method_hash) {
+		return ((uint64_t)p_class_hash << 32) | p_method_hash;
+	}
+
+public:
+	static HSLNativeRegistry *get_singleton();
+
+	static _FORCE_INLINE_ uint32_t hash_name(const char *p_name) {
+		return murmer_encrypt_data(p_name, strlen(p_name), HSL_MURMUR_SEED);
+	}
+
+	void add_native(const char *p_class_name, const char *p_name, HSLNativeCall p_call, int p_arity);
+
+	template <auto F>
+	void add(const char *p_class_name, const char *p_name) {
+		add_native(p_class_name, p_name, &HSLNativeBinder<F>::call, HSLNativeBinder<F>::arity);
+	}
+
+	const HSLNativeFunction *find(uint32_t p_class_hash, uint32_t p_method_hash) const;
+	_FORCE_INLINE_ const HSLNativeFunction *find(const char *p_class_name, const char *p_name) const { return find(hash_name(p_class_name), hash_name(p_name)); }
+
+	uint32_t get_native_count() const { return natives.size(); }
+
+	HSLNativeRegistry();
+	~HSLNativeRegistry();
+};
+
+#define HSL_BIND_NATIVE(m_registry, m_class, m_name, m_function) (m_registry)->add<m_function>(m_class, m_name)
+
+#endif
@@ -0,0 +1,246 @@
+#include "hsl_scheduler.h"
+#include "hsl_arena.h"
+
+#include "core/object/object.h"
+
+HSLScheduler *HSLScheduler::singleton = nullptr;
+
+HSLScheduler *HSLScheduler::get_singleton(){
+	return singleton;
+}
+
+void HSLScheduler::set_resume_func(HSLResumeFunc p_func){
+	resume_func = p_func;
+}
+
+void HSLScheduler::_heap_push(LocalVector<Sleeper> &r_heap, const Sleeper &p_sleeper, bool p_by_time){
+	uint32_t index = r_heap.size();
+	r_heap.push_back(p_sleeper);
+
+	while (index > 0){
+		uint32_t parent = (index - 1) >> 1;
+
+		bool earlier = p_by_time ? r_heap[index].wake_time < r_heap[parent].wake_time : r_heap[index].wake_frame < r_heap[parent].wake_frame;
+		if (not earlier){
+			break;
+		}
+
+		SWAP(r_heap[index], r_heap[parent]);
+		index = parent;
+	}
+}
+
+HSLScheduler::Sleeper HSLScheduler::_heap_pop(LocalVector<Sleeper> &r_heap, bool p_by_time){
+	Sleeper top = r_heap[0];
+
+	r_heap[0] = r_heap[r_heap.size() - 1];
+	r_heap.resize(r_heap.size() - 1);
+
+	uint32_t index = 0;
+	uint32_t size = r_heap.size();
+
+	while (true){
+		uint32_t smallest = index;
+		uint32_t left = index * 2 + 1;
+		uint32_t right = left + 1;
+
+		if (p_by_time){
+			if (left < size and r_heap[left].wake_time < r_heap[smallest].wake_time) smallest = left;
+			if (right < size and r_heap[right].wake_time < r_heap[smallest].wake_time) smallest = right;
+		} else {
+			if (left < size and r_heap[left].wake_frame < r_heap[smallest].wake_frame) smallest = left;
+			if (right < size and r_heap[right].wake_frame < r_heap[smallest].wake_frame) smallest = right;
+		}
+
+		if (smallest == index){
+			break;
+		}
+
+		SWAP(r_heap[index], r_heap[smallest]);
+		index = smallest;
+	}
+
+	return top;
+}
+
+void HSLScheduler::suspend(HSLCallFrame *p_top, const HSLWait &p_wait){
+	ERR_FAIL_NULL(p_top);
+
+	Sleeper sleeper;
+	sleeper.top = p_top;
+	sleeper.wake_time = 0.0;
+	sleeper.wake_frame = 0;
+
+	if (p_wait.kind == HSLWait::WAIT_SECONDS){
+		sleeper.wake_time = current_time + p_wait.seconds;
+		_heap_push(time_heap, sleeper, true);
+	} else {
+		//always at least the next frame, otherwise a zero-frame wait would spin inside one tick
+		sleeper.wake_frame = current_frame + MAX(p_wait.frames, (uint64_t)1);
+		_heap_push(frame_heap, sleeper, false);
+	}
+}
+
+void HSLScheduler::_resume(Sleeper &p_sleeper){
+	HSLCallFrame *top = p_sleeper.top;
+
+	//the owning object was freed while its script slept
+	if (top->owner.is_valid() and ObjectDB::get_instance(top->owner) == nullptr){
+		HSLFramePool::get_thread_pool()->release_chain(top);
+		return;
+	}
+
+	ERR_FAIL_NULL_MSG(resume_func, "No HSL interpreter is attached to the scheduler.");
+
+	HSLWait wait = {};
+	HSLResumeResult result = resume_func(top, wait);
+
+	if (result == HSL_RESUME_SUSPENDED){
+		suspend(top, wait);
+	} else {
+		HSLFramePool::get_thread_pool()->release_chain(top);
+	}
+}
+
+void HSLScheduler::tick(double p_delta){
+	//nothing allocated in the arena outlives the frame that made it
+	HSLFrameArena::get_thread_arena()->reset();
+
+	current_time += p_delta;
+	current_frame++;
+
+	//collect first and resume after, so anything that suspends again waits for a later tick
+	due.clear();
+
+	while (not time_heap.is_empty() and time_heap[0].wake_time <= current_time){
+		due.push_back(_heap_pop(time_heap, true));
+	}
+
+	while (not frame_heap.is_empty() and frame_heap[0].wake_frame <= current_frame){
+		due.push_back(_heap_pop(frame_heap, false));
+	}
+
+	for (Sleeper &sleeper : due){
+		_resume(sleeper);
+	}
+
+	due.clear();
+}
+
+void HSLScheduler::cancel_owner(ObjectID p_owner){
+	LocalVector<Sleeper> *heaps[2] = { &time_heap, &frame_heap };
+
+	for (int h = 0; h < 2; h++){
+		LocalVector<Sleeper> &heap = *heaps[h];
+		LocalVector<Sleeper> kept;
+		kept.reserve(heap.size());
+
+		for (const Sleeper &sleeper : heap){
+			if (sleeper.top->owner == p_owner){
+				HSLFramePool::get_thread_pool()->release_chain(sleeper.top);
+			} else {
+				_heap_push(kept, sleeper, h == 0);
+			}
+		}
+
+		heap = kept;
+	}
+}
+
+uint32_t HSLScheduler::cancel_functions(const HSLBytecodeReader *p_module, const HashSet<uint32_t> &p_function_hashes){
+	LocalVector<Sleeper> *heaps[2] = { &time_heap, &frame_heap };
+	uint32_t cancelled = 0;
+
+	for (int h = 0; h < 2; h++){
+		LocalVector<Sleeper> &heap = *heaps[h];
+		LocalVector<Sleeper> kept;
+		kept.reserve(heap.size());
+
+		for (const Sleeper &sleeper : heap){
+			bool stale = false;
+			for (HSLCallFrame *frame = sleeper.top; frame != nullptr and not stale; frame = frame->caller){
+				stale = frame->module == p_module and p_function_hashes.has(frame->function_hash);
+			}
+
+			if (stale){
+				HSLFramePool::get_thread_pool()->release_chain(sleeper.top);
+				cancelled++;
+			} else {
+				_heap_push(kept, sleeper, h == 0);
+			}
+		}
+
+		heap = kept;
+	}
+
+	return cancelled;
+}
+
+void HSLScheduler::get_suspended_functions(const HSLBytecodeReader *p_module, HashSet<uint32_t> &r_function_hashes) const {
+	const LocalVector<Sleeper> *heaps[2] = { &time_heap, &frame_heap };
+
+	for (int h = 0; h < 2; h++){
+		for (const Sleeper &sleeper : *heaps[h]){
+			for (HSLCallFrame *frame = sleeper.top; frame != nullptr; frame = frame->caller){
+				if (frame->module == p_module){
+					r_function_hashes.insert(frame->function_hash);
+				}
+			}
+		}
+	}
+}
+
+void HSLScheduler::retarget_functions(const HSLBytecodeReader *p_module, const HashMap<uint32_t, uint32_t> &p_function_hashes){
+	LocalVector<Sleeper> *heaps[2] = { &time_heap, &frame_heap };
+
+	//only the frames change, so both heaps keep their order
+	for (int h = 0; h < 2; h++){
+		for (Sleeper &sleeper : *heaps[h]){
+			for (HSLCallFrame *frame = sleeper.top; frame != nullptr; frame = frame->caller){
+				if (frame->module != p_module){
+					continue;
+				}
+
+				const uint32_t *target = p_function_hashes.getptr(frame->function_hash);
+				if (target != nullptr){
+					frame->function_hash = *target;
+				}
+			}
+		}
+	}
+}
+
+void HSLScheduler::clear(){
+	for (const Sleeper &sleeper : time_heap){
+		HSLFramePool::get_thread_pool()->release_chain(sleeper.top);
+	}
+	for (const Sleeper &sleeper : frame_heap){
+		HSLFramePool::get_thread_pool()->release_chain(sleeper.top);
+	}
+
+	time_heap.clear();
+	frame_heap.clear();
+}
+
+void HSLScheduler::restore_clock(double p_time, uint64_t p_frame){
+	clear();
+
+	current_time = p_time;
+	current_frame = p_frame;
+}
+
+uint32_t HSLScheduler::get_suspended_count() const {
+	return time_heap.size() + frame_heap.size();
+}
+
+HSLScheduler::HSLScheduler(){
+	singleton = this;
+}
+
+HSLScheduler::~HSLScheduler(){
+	clear();
+
+	if (singleton == this){
+		singleton = nullptr;
+	}
+}
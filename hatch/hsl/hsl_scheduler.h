@@ -0,0 +1,84 @@
+#ifndef HATCH_HSL_SCHEDULER_H
+#define HATCH_HSL_SCHEDULER_H
+
+#include "hsl_frame.h"
+
+#include "core/templates/hash_map.h"
+#include "core/templates/hash_set.h"
+
+struct HSLWait {
+	enum Kind : uint8_t {
+		WAIT_SECONDS,
+		WAIT_FRAMES,
+	};
+
+	Kind kind;
+	double seconds;
+	uint64_t frames;
+};
+
+enum HSLResumeResult {
+	HSL_RESUME_FINISHED,
+	HSL_RESUME_SUSPENDED,
+	HSL_RESUME_ERROR,
+};
+
+//Supplied by the interpreter: runs r_top until it returns or suspends again, updating r_top/r_wait
+typedef HSLResumeResult (*HSLResumeFunc)(HSLCallFrame *&r_top, HSLWait &r_wait);
+
+/*
+ Keeps suspended scripts as plain frame chains in two binary heaps, one ordered by wake time
+ and one by wake frame, so a tick only touches the scripts that are actually due.
+ */
+class HSLScheduler {
+	struct Sleeper {
+		HSLCallFrame *top;
+		double wake_time;
+		uint64_t wake_frame;
+	};
+
+	static HSLScheduler *singleton;
+
+	LocalVector<Sleeper> time_heap;
+	LocalVector<Sleeper> frame_heap;
+	LocalVector<Sleeper> due;
+
+	HSLResumeFunc resume_func = nullptr;
+
+	double current_time = 0.0;
+	uint64_t current_frame = 0;
+
+	static void _heap_push(LocalVector<Sleeper> &r_heap, const Sleeper &p_sleeper, bool p_by_time);
+	static Sleeper _heap_pop(LocalVector<Sleeper> &r_heap, bool p_by_time);
+
+	void _resume(Sleeper &p_sleeper);
+
+public:
+	static HSLScheduler *get_singleton();
+
+	void set_resume_func(HSLResumeFunc p_func);
+
+	void suspend(HSLCallFrame *p_top, const HSLWait &p_wait);
+	void cancel_owner(ObjectID p_owner);
+	//Drops scripts with a frame in any of these functions of p_module, returns how many
+	uint32_t cancel_functions(const HSLBytecodeReader *p_module, const HashSet<uint32_t> &p_function_hashes);
+	//Every function of p_module a suspended script has a frame in
+	void get_suspended_functions(const HSLBytecodeReader *p_module, HashSet<uint32_t> &r_function_hashes) const;
+	//Moves suspended frames onto other functions of the same module, for code a reload retired
+	void retarget_functions(const HSLBytecodeReader *p_module, const HashMap<uint32_t, uint32_t> &p_function_hashes);
+	void clear();
+	//Drops every suspended script and rewinds the clock, as when a snapshot is restored
+	void restore_clock(double p_time, uint64_t p_frame);
+
+	//Once per frame on the main thread, which also resets that thread's HSLFrameArena
+	void tick(double p_delta);
+
+	uint32_t get_suspended_count() const;
+	double get_time() const { return current_time; }
+	uint64_t get_frame() const { return current_frame; }
+
+	HSLScheduler();
+	~HSLScheduler();
+};
+
+#endif
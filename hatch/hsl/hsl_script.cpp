@@ -1,9 +1,21 @@
 #include "hsl_script.h"
 
 void HatchScript::reload_from_file(){
-
+	reload(true);
 };
 
+//With state kept, only functions whose bytecode changed are swapped in and live instances are
+//left alone; otherwise the module is parsed from scratch
+Error HatchScript::reload(bool p_keep_state){
+	if (p_keep_state and bytecode.is_valid() and bytecode->get_file_path() == get_path()){
+		Dictionary result = bytecode->reload_file();
+		return result.is_empty() ? ERR_PARSE_ERROR : OK;
+	}
+
+	bytecode.instantiate();
+	return bytecode->load_file(get_path());
+}
+
 bool HatchScript::can_instantiate() const {
 	return false;
 };
@@ -1,11 +1,15 @@
 #ifndef HATCH_SCRIPT_LANG_SCRIPT_H
 #define HATCH_SCRIPT_LANG_SCRIPT_H
 
+#include "hsl_bytecode_reader.h"
+
 #include "core/object/script_language.h"
 
 class HatchScript : public Script {
 	GDCLASS(HatchScript, Script);
 
+	Ref<HSLBytecodeReader> bytecode;
+
 public:
 	virtual void reload_from_file() override;
 
@@ -65,6 +69,8 @@ public:
 	virtual Variant get_rpc_config() const override;
 
 
+	Ref<HSLBytecodeReader> get_bytecode() const { return bytecode; }
+
 protected:
 	static void _bind_methods();
 };
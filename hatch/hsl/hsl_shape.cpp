@@ -0,0 +1,262 @@
+#include "hsl_shape.h"
+#include "hsl_arena.h"
+#include "hsl_snapshot.h"
+#include "../file_io/hatch_archive_reader.h"
+#include "../hatch_performance.h"
+
+#include "core/config/project_settings.h"
+
+HSLShapeTable *HSLShapeTable::singleton = nullptr;
+
+HSLShapeTable *HSLShapeTable::get_singleton(){
+	return singleton;
+}
+
+HSLShape *HSLShapeTable::_create_root(uint32_t p_class_hash){
+	HSLShape *root = memnew(HSLShape);
+	root->root = root;
+	root->class_hash = p_class_hash;
+
+	shapes.push_back(root);
+	roots.insert(p_class_hash, root);
+	HatchPerformance::add(HatchPerformance::HSL_SHAPES);
+
+	return root;
+}
+
+Error HSLShapeTable::load_class_map(const PackedByteArray &p_buffer){
+	HSLStateReader reader(p_buffer.ptr(), p_buffer.size());
+
+	const uint8_t *magic = reader.get_bytes(4);
+	ERR_FAIL_COND_V_MSG(magic == nullptr or memcmp(magic, HSL_CLASS_MAP_MAGIC, 4) != 0, ERR_FILE_UNRECOGNIZED, "Not an HSL class map.");
+
+	//version and padding; nothing here depends on them yet
+	reader.get_u32();
+
+	//class name hash, then the hashes of the bytecode files that define it
+	uint32_t count = reader.get_u32();
+	for (uint32_t i = 0; i < count and not reader.failed; i++){
+		uint32_t class_hash = reader.get_u32();
+		uint32_t file_count = reader.get_u32();
+		reader.get_bytes(file_count * 4);
+
+		if (not reader.failed){
+			get_root(class_hash);
+		}
+	}
+
+	ERR_FAIL_COND_V_MSG(reader.failed, ERR_FILE_CORRUPT, "HSL class map is truncated.");
+	return OK;
+}
+
+Error HSLShapeTable::load_class_map_file(const String &p_path){
+	PackedByteArray bytes;
+	Error err = HatchArchiveReader::load_path(p_path, bytes);
+	ERR_FAIL_COND_V_MSG(err != OK, err, "Could not read HSL class map \"" + p_path + "\".");
+
+	class_map_tried = true;
+	return load_class_map(bytes);
+}
+
+void HSLShapeTable::ensure_class_map(){
+	//tried once either way, so a project without a class map doesn't fail on every module
+	if (class_map_tried or class_map_path.is_empty()){
+		return;
+	}
+	class_map_tried = true;
+
+	load_class_map_file(class_map_path);
+}
+
+const HSLShape *HSLShapeTable::get_root(uint32_t p_class_hash){
+	HSLShape **root = roots.getptr(p_class_hash);
+	return root ? *root : _create_root(p_class_hash);
+}
+
+const HSLShape *HSLShapeTable::add_field(const HSLShape *p_shape, uint32_t p_field_hash){
+	ERR_FAIL_NULL_V(p_shape, nullptr);
+
+	if (p_shape->find_slot(p_field_hash) >= 0){
+		return p_shape;
+	}
+
+	//instances of one class almost always take the same path, so this list is usually one long
+	for (const HSLShape::Transition &transition : p_shape->transitions){
+		if (transition.field_hash == p_field_hash){
+			return transition.shape;
+		}
+	}
+
+	HSLShape *shape = memnew(HSLShape);
+	shape->parent = p_shape;
+	shape->root = p_shape->root;
+	shape->class_hash = p_shape->class_hash;
+	shape->field_hash = p_field_hash;
+	shape->fields = p_shape->fields;
+	shape->fields.push_back(p_field_hash);
+
+	if (shape->fields.size() > HSL_SHAPE_LINEAR_FIELDS){
+		for (uint32_t i = 0; i < shape->fields.size(); i++){
+			shape->field_index.insert(shape->fields[i], i);
+		}
+	}
+
+	//shapes are only ever handed out const, the table is the one place that extends them
+	HSLShape *parent = const_cast<HSLShape *>(p_shape);
+	parent->transitions.push_back({ p_field_hash, shape });
+
+	shapes.push_back(shape);
+	HatchPerformance::add(HatchPerformance::HSL_SHAPES);
+
+	return shape;
+}
+
+void HSLShapeTable::_grow_slots(HSLInstance *p_instance, uint32_t p_min_capacity){
+	uint32_t capacity = MAX(MAX(p_instance->capacity * 2, 4U), p_min_capacity);
+
+	HSLObjectPool *pool = HSLObjectPool::get_thread_pool();
+	HSLValue *slots = (HSLValue *)pool->alloc(capacity * sizeof(HSLValue));
+
+	if (p_instance->slots != nullptr){
+		memcpy(slots, p_instance->slots, p_instance->shape->get_slot_count() * sizeof(HSLValue));
+		pool->free(p_instance->slots, p_instance->capacity * sizeof(HSLValue));
+	}
+
+	instance_bytes += (uint64_t)(capacity - p_instance->capacity) * sizeof(HSLValue);
+	HatchPerformance::add(HatchPerformance::HSL_INSTANCE_BYTES, (uint64_t)(capacity - p_instance->capacity) * sizeof(HSLValue));
+
+	p_instance->slots = slots;
+	p_instance->capacity = capacity;
+}
+
+HSLInstance *HSLShapeTable::instance_create(uint32_t p_class_hash){
+	const HSLShape *root = get_root(p_class_hash);
+
+	HSLInstance *instance = (HSLInstance *)HSLObjectPool::get_thread_pool()->alloc(sizeof(HSLInstance));
+	instance->shape = root;
+	instance->slots = nullptr;
+	instance->capacity = 0;
+
+	instance_bytes += sizeof(HSLInstance);
+	HatchPerformance::add(HatchPerformance::HSL_INSTANCE_BYTES, sizeof(HSLInstance));
+
+	//sized for the fields earlier instances of the class ended up with, so the constructor doesn't regrow it
+	if (root->expected_slots > 0){
+		_grow_slots(instance, root->expected_slots);
+	}
+
+	return instance;
+}
+
+void HSLShapeTable::instance_free(HSLInstance *p_instance){
+	ERR_FAIL_NULL(p_instance);
+
+	HSLObjectPool *pool = HSLObjectPool::get_thread_pool();
+	uint64_t bytes = sizeof(HSLInstance) + (uint64_t)p_instance->capacity * sizeof(HSLValue);
+
+	if (p_instance->slots != nullptr){
+		pool->free(p_instance->slots, p_instance->capacity * sizeof(HSLValue));
+	}
+	pool->free(p_instance, sizeof(HSLInstance));
+
+	instance_bytes -= bytes;
+	HatchPerformance::sub(HatchPerformance::HSL_INSTANCE_BYTES, bytes);
+}
+
+HSLValue HSLShapeTable::get_field(const HSLInstance *p_instance, uint32_t p_field_hash, HSLFieldCache *r_cache) const {
+	const HSLShape *shape = p_instance->shape;
+
+	if (r_cache != nullptr and r_cache->shape == shape and r_cache->transition == nullptr){
+		return p_instance->slots[r_cache->slot];
+	}
+
+	int slot = shape->find_slot(p_field_hash);
+	if (slot < 0){
+		return HSLValue::make_null();
+	}
+
+	if (r_cache != nullptr){
+		r_cache->shape = shape;
+		r_cache->slot = slot;
+		r_cache->transition = nullptr;
+	}
+
+	return p_instance->slots[slot];
+}
+
+void HSLShapeTable::set_field(HSLInstance *p_instance, uint32_t p_field_hash, const HSLValue &p_value, HSLFieldCache *r_cache){
+	const HSLShape *shape = p_instance->shape;
+	const HSLShape *next = nullptr;
+
+	if (r_cache != nullptr and r_cache->shape == shape){
+		if (r_cache->transition == nullptr){
+			p_instance->slots[r_cache->slot] = p_value;
+			return;
+		}
+		next = r_cache->transition;
+	} else {
+		int slot = shape->find_slot(p_field_hash);
+		if (slot < 0){
+			next = add_field(shape, p_field_hash);
+			slot = shape->get_slot_count();
+		}
+
+		if (r_cache != nullptr){
+			r_cache->shape = shape;
+			r_cache->slot = slot;
+			r_cache->transition = next;
+		}
+
+		if (next == nullptr){
+			p_instance->slots[slot] = p_value;
+			return;
+		}
+	}
+
+	//adding a field always appends it, the new slot is the old slot count
+	uint32_t slot = shape->get_slot_count();
+	if (slot >= p_instance->capacity){
+		_grow_slots(p_instance, slot + 1);
+	}
+
+	p_instance->slots[slot] = p_value;
+	p_instance->shape = next;
+
+	if (next->get_slot_count() > next->root->expected_slots){
+		next->root->expected_slots = next->get_slot_count();
+	}
+}
+
+bool HSLShapeTable::has_field(const HSLInstance *p_instance, uint32_t p_field_hash) const {
+	return p_instance->shape->find_slot(p_field_hash) >= 0;
+}
+
+void HSLShapeTable::clear(){
+	for (HSLShape *shape : shapes){
+		memdelete(shape);
+	}
+
+	HatchPerformance::sub(HatchPerformance::HSL_SHAPES, shapes.size());
+	shapes.clear();
+	roots.clear();
+	class_map_tried = false;
+}
+
+HSLShapeTable::HSLShapeTable(){
+	singleton = this;
+
+	class_map_path = GLOBAL_DEF("hatch/hsl/class_map_path", "Objects/Objects.hcm");
+}
+
+HSLShapeTable::~HSLShapeTable(){
+	clear();
+
+	if (instance_bytes > 0){
+		WARN_PRINT(vformat("%d bytes of HSL instances were never freed.", instance_bytes));
+		HatchPerformance::sub(HatchPerformance::HSL_INSTANCE_BYTES, instance_bytes);
+	}
+
+	if (singleton == this){
+		singleton = nullptr;
+	}
+}
@@ -0,0 +1,125 @@
+#ifndef HATCH_HSL_SHAPE_H
+#define HATCH_HSL_SHAPE_H
+
+#include "hsl_value.h"
+#include "../hatch_formats.h"
+
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+#include "core/variant/variant.h"
+
+//Shapes with more fields than this also get a hash index, smaller ones are scanned
+#define HSL_SHAPE_LINEAR_FIELDS 12
+
+/*
+ A hidden class: the ordered list of fields an instance has, shared by every instance that
+ gained the same fields in the same order. Each class starts from a root shape with no fields;
+ adding a field follows (or creates) a transition to the child shape with that field in the
+ next slot. Shapes are immutable once made apart from their transition list, and live until
+ the table is cleared.
+ */
+struct HSLShape {
+	struct Transition {
+		uint32_t field_hash;
+		HSLShape *shape;
+	};
+
+	const HSLShape *parent = nullptr;
+	const HSLShape *root = nullptr;
+	uint32_t class_hash = 0;
+	uint32_t field_hash = 0; //the field this shape added, 0 on a root
+
+	LocalVector<uint32_t> fields; //field name hashes in slot order
+	HashMap<uint32_t, uint32_t> field_index; //only filled past HSL_SHAPE_LINEAR_FIELDS
+	LocalVector<Transition> transitions;
+
+	//on a root: the most fields any instance of the class has reached, used to size new ones
+	mutable uint32_t expected_slots = 0;
+
+	_FORCE_INLINE_ uint32_t get_slot_count() const { return fields.size(); }
+
+	//Slot of a field, or -1
+	_FORCE_INLINE_ int find_slot(uint32_t p_field_hash) const {
+		if (fields.size() > HSL_SHAPE_LINEAR_FIELDS){
+			const uint32_t *slot = field_index.getptr(p_field_hash);
+			return slot ? (int)*slot : -1;
+		}
+
+		for (uint32_t i = 0; i < fields.size(); i++){
+			if (fields[i] == p_field_hash){
+				return i;
+			}
+		}
+		return -1;
+	}
+};
+
+//One per field access site in the bytecode; a hit is a pointer compare and an indexed load
+struct HSLFieldCache {
+	const HSLShape *shape = nullptr;
+	uint32_t slot = 0;
+	const HSLShape *transition = nullptr; //for stores that add the field
+};
+
+//Instances stay at one address for their lifetime, only the slot array moves when it grows
+struct HSLInstance {
+	const HSLShape *shape;
+	HSLValue *slots;
+	uint32_t capacity;
+};
+
+/*
+ Owns every shape in the runtime and lays out HSL instances with them. Instances are a shape
+ pointer plus a flat slot array from the object pool, so an instance costs its field count
+ and nothing else, and a field access with a warm HSLFieldCache never hashes.
+
+ Root shapes come from Objects.hcm, one per class, loaded with the first bytecode module. Each root remembers how many fields its
+ instances end up with, so new instances are allocated at their final size up front.
+ */
+class HSLShapeTable {
+	static HSLShapeTable *singleton;
+
+	LocalVector<HSLShape *> shapes;
+	HashMap<uint32_t, HSLShape *> roots;
+
+	uint64_t instance_bytes = 0;
+
+	String class_map_path;
+	bool class_map_tried = false;
+
+	HSLShape *_create_root(uint32_t p_class_hash);
+	void _grow_slots(HSLInstance *p_instance, uint32_t p_min_capacity);
+
+public:
+	static HSLShapeTable *get_singleton();
+
+	//Registers a root shape for every class in an Objects.hcm buffer
+	Error load_class_map(const PackedByteArray &p_buffer);
+	Error load_class_map_file(const String &p_path);
+	//Loads the project's class map (hatch/hsl/class_map_path) the first time it is called
+	void ensure_class_map();
+
+	const HSLShape *get_root(uint32_t p_class_hash);
+	//The shape reached by adding a field, created on first use
+	const HSLShape *add_field(const HSLShape *p_shape, uint32_t p_field_hash);
+
+	HSLInstance *instance_create(uint32_t p_class_hash);
+	void instance_free(HSLInstance *p_instance);
+
+	//Reads null for a field the instance doesn't have
+	HSLValue get_field(const HSLInstance *p_instance, uint32_t p_field_hash, HSLFieldCache *r_cache = nullptr) const;
+	//Adds the field, moving the instance to a new shape, if it doesn't have it yet
+	void set_field(HSLInstance *p_instance, uint32_t p_field_hash, const HSLValue &p_value, HSLFieldCache *r_cache = nullptr);
+	bool has_field(const HSLInstance *p_instance, uint32_t p_field_hash) const;
+
+	uint32_t get_shape_count() const { return shapes.size(); }
+	uint32_t get_class_count() const { return roots.size(); }
+
+	//Only valid once every instance has been freed
+	void clear();
+
+	HSLShapeTable();
+	~HSLShapeTable();
+};
+
+#endif
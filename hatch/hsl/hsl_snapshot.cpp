@@ -0,0 +1,252 @@
+#include "hsl_snapshot.h"
+#include "hsl_scheduler.h"
+#include "../hatch_performance.h"
+
+#include "core/io/file_access.h"
+#include "core/io/marshalls.h"
+
+void HSLStateWriter::put_u32(uint32_t p_value){
+	uint32_t offset = data.size();
+	data.resize(offset + 4);
+	encode_uint32(p_value, data.ptr() + offset);
+}
+
+void HSLStateWriter::put_u64(uint64_t p_value){
+	uint32_t offset = data.size();
+	data.resize(offset + 8);
+	encode_uint64(p_value, data.ptr() + offset);
+}
+
+void HSLStateWriter::put_bytes(const void *p_bytes, uint32_t p_size){
+	if (p_size == 0){
+		return;
+	}
+
+	uint32_t offset = data.size();
+	data.resize(offset + p_size);
+	memcpy(data.ptr() + offset, p_bytes, p_size);
+}
+
+void HSLStateWriter::put_string(const String &p_string){
+	CharString utf8 = p_string.utf8();
+	put_u32(utf8.length());
+	put_bytes(utf8.get_data(), utf8.length());
+}
+
+uint32_t HSLStateWriter::reserve_u32(){
+	uint32_t offset = data.size();
+	put_u32(0);
+	return offset;
+}
+
+void HSLStateWriter::patch_u32(uint32_t p_offset, uint32_t p_value){
+	ERR_FAIL_COND(p_offset + 4 > data.size());
+	encode_uint32(p_value, data.ptr() + p_offset);
+}
+
+const uint8_t *HSLStateReader::get_bytes(uint32_t p_size){
+	if (failed or p_size > size - pos){
+		failed = true;
+		return nullptr;
+	}
+
+	const uint8_t *bytes = data + pos;
+	pos += p_size;
+	return bytes;
+}
+
+uint8_t HSLStateReader::get_u8(){
+	const uint8_t *bytes = get_bytes(1);
+	return bytes ? *bytes : 0;
+}
+
+uint32_t HSLStateReader::get_u32(){
+	const uint8_t *bytes = get_bytes(4);
+	return bytes ? decode_uint32(bytes) : 0;
+}
+
+uint64_t HSLStateReader::get_u64(){
+	const uint8_t *bytes = get_bytes(8);
+	return bytes ? decode_uint64(bytes) : 0;
+}
+
+String HSLStateReader::get_string(){
+	uint32_t length = get_u32();
+	const uint8_t *bytes = get_bytes(length);
+	return bytes ? String::utf8((const char *)bytes, length) : String();
+}
+
+//magic, format version, source key, section count
+#define HSL_SNAPSHOT_HEADER_SIZE 16
+
+Error HSLSnapshot::_validate(const PackedByteArray &p_image, uint32_t p_source_key) const {
+	ERR_FAIL_COND_V_MSG(p_image.size() < HSL_SNAPSHOT_HEADER_SIZE, ERR_FILE_CORRUPT, "HSL snapshot is too small.");
+	ERR_FAIL_COND_V_MSG(memcmp(p_image.ptr(), HSL_SNAPSHOT_MAGIC, 4) != 0, ERR_FILE_UNRECOGNIZED, "Not an HSL snapshot.");
+
+	//images aren't converted between versions, an old one is simply rebuilt
+	if (decode_uint32(p_image.ptr() + 4) != HSL_SNAPSHOT_VERSION){
+		return ERR_FILE_UNRECOGNIZED;
+	}
+	if (p_source_key != 0 and decode_uint32(p_image.ptr() + 8) != p_source_key){
+		return ERR_FILE_MISSING_DEPENDENCIES;
+	}
+
+	return OK;
+}
+
+Error HSLSnapshot::capture(TypedArray<HSLBytecodeReader> readers, int key){
+	HSLStateWriter writer;
+
+	writer.put_bytes(HSL_SNAPSHOT_MAGIC, 4);
+	writer.put_u32(HSL_SNAPSHOT_VERSION);
+	writer.put_u32(key);
+	uint32_t section_count_at = writer.reserve_u32();
+	uint32_t section_count = 0;
+
+	writer.put_u32(SECTION_CLASSES);
+	uint32_t size_at = writer.reserve_u32();
+	uint32_t start = writer.data.size();
+
+	writer.put_u32(readers.size());
+	for (int i = 0; i < readers.size(); i++){
+		Ref<HSLBytecodeReader> reader = readers[i];
+		ERR_FAIL_COND_V_MSG(reader.is_null(), ERR_INVALID_PARAMETER, "Can't capture a null bytecode reader.");
+		reader->write_state(writer);
+	}
+
+	writer.patch_u32(size_at, writer.data.size() - start);
+	section_count++;
+
+	HSLScheduler *scheduler = HSLScheduler::get_singleton();
+	if (scheduler != nullptr){
+		writer.put_u32(SECTION_SCHEDULER);
+		writer.put_u32(16);
+
+		double time = scheduler->get_time();
+		uint64_t time_bits;
+		memcpy(&time_bits, &time, sizeof(double));
+		writer.put_u64(time_bits);
+		writer.put_u64(scheduler->get_frame());
+
+		section_count++;
+	}
+
+	writer.patch_u32(section_count_at, section_count);
+
+	image.resize(writer.data.size());
+	memcpy(image.ptrw(), writer.data.ptr(), writer.data.size());
+	source_key = key;
+
+	return OK;
+}
+
+TypedArray<HSLBytecodeReader> HSLSnapshot::restore(){
+	HATCH_SCOPED_TIMER("hsl_restore_snapshot", HSL_PARSE_USEC);
+
+	TypedArray<HSLBytecodeReader> readers;
+	ERR_FAIL_COND_V(_validate(image, 0) != OK, readers);
+
+	HSLStateReader reader(image.ptr(), image.size());
+	reader.pos = 12;
+	uint32_t section_count = reader.get_u32();
+
+	for (uint32_t s = 0; s < section_count and not reader.failed; s++){
+		uint32_t type = reader.get_u32();
+		uint32_t size = reader.get_u32();
+		uint32_t end = reader.pos + size;
+
+		ERR_FAIL_COND_V_MSG(reader.failed or size > image.size() - reader.pos, TypedArray<HSLBytecodeReader>(), "HSL snapshot is truncated.");
+
+		switch (type){
+			case SECTION_CLASSES: {
+				uint32_t count = reader.get_u32();
+				for (uint32_t i = 0; i < count and not reader.failed; i++){
+					Ref<HSLBytecodeReader> bytecode_reader;
+					bytecode_reader.instantiate();
+					ERR_FAIL_COND_V(bytecode_reader->read_state(reader) != OK, TypedArray<HSLBytecodeReader>());
+					readers.push_back(bytecode_reader);
+				}
+			} break;
+			case SECTION_SCHEDULER: {
+				uint64_t time_bits = reader.get_u64();
+				uint64_t frame = reader.get_u64();
+
+				double time;
+				memcpy(&time, &time_bits, sizeof(double));
+
+				HSLScheduler *scheduler = HSLScheduler::get_singleton();
+				if (scheduler != nullptr and not reader.failed){
+					scheduler->restore_clock(time, frame);
+				}
+			} break;
+			default:
+				//written by a newer build, nothing here depends on it
+				break;
+		}
+
+		ERR_FAIL_COND_V_MSG(reader.failed or reader.pos > end, TypedArray<HSLBytecodeReader>(), "HSL snapshot section is corrupt.");
+		reader.pos = end;
+	}
+
+	return readers;
+}
+
+Error HSLSnapshot::save(String path) const {
+	ERR_FAIL_COND_V_MSG(image.is_empty(), ERR_UNCONFIGURED, "Nothing has been captured into this snapshot.");
+
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::WRITE);
+	ERR_FAIL_COND_V_MSG(file.is_null(), ERR_FILE_CANT_WRITE, "Could not write HSL snapshot to \"" + path + "\".");
+
+	file->store_buffer(image.ptr(), image.size());
+	return OK;
+}
+
+Error HSLSnapshot::load(String path, int key){
+	Error err = OK;
+	PackedByteArray data = FileAccess::get_file_as_bytes(path, &err);
+	if (err != OK){
+		return err;
+	}
+
+	//a stale snapshot is expected after the game data changes, so that's not an error print
+	err = _validate(data, key);
+	if (err != OK){
+		return err;
+	}
+
+	image = data;
+	source_key = decode_uint32(image.ptr() + 8);
+	return OK;
+}
+
+void HSLSnapshot::set_image(PackedByteArray data){
+	ERR_FAIL_COND(_validate(data, 0) != OK);
+
+	image = data;
+	source_key = decode_uint32(image.ptr() + 8);
+}
+
+PackedByteArray HSLSnapshot::get_image() const {
+	return image;
+}
+
+int HSLSnapshot::get_source_key() const {
+	return source_key;
+}
+
+bool HSLSnapshot::is_empty() const {
+	return image.is_empty();
+}
+
+void HSLSnapshot::_bind_methods(){
+	ClassDB::bind_method(D_METHOD("capture", "readers", "key"), &HSLSnapshot::capture, DEFVAL(0));
+	ClassDB::bind_method(D_METHOD("restore"), &HSLSnapshot::restore);
+
+	ClassDB::bind_method(D_METHOD("save", "path"), &HSLSnapshot::save);
+	ClassDB::bind_method(D_METHOD("load", "path", "key"), &HSLSnapshot::load, DEFVAL(0));
+
+	ClassDB::bind_method(D_METHOD("set_image", "data"), &HSLSnapshot::set_image);
+	ClassDB::bind_method(D_METHOD("get_image"), &HSLSnapshot::get_image);
+	ClassDB::bind_method(D_METHOD("get_source_key"), &HSLSnapshot::get_source_key);
+	ClassDB::bind_method(D_METHOD("is_empty"), &HSLSnapshot::is_empty);
+}
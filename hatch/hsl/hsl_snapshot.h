@@ -0,0 +1,83 @@
+#ifndef HATCH_HSL_SNAPSHOT_H
+#define HATCH_HSL_SNAPSHOT_H
+
+#include "hsl_bytecode_reader.h"
+
+#include "core/templates/local_vector.h"
+#include "core/variant/typed_array.h"
+
+#define HSL_SNAPSHOT_MAGIC "HSNP"
+#define HSL_SNAPSHOT_VERSION 1
+
+//Appends little-endian fields to a flat buffer; snapshots hold offsets and lengths, never pointers
+struct HSLStateWriter {
+	LocalVector<uint8_t> data;
+
+	void put_u8(uint8_t p_value) { data.push_back(p_value); }
+	void put_u32(uint32_t p_value);
+	void put_u64(uint64_t p_value);
+	void put_bytes(const void *p_bytes, uint32_t p_size);
+	void put_string(const String &p_string);
+
+	//Writes a zero placeholder and returns where it is, for sizes only known later
+	uint32_t reserve_u32();
+	void patch_u32(uint32_t p_offset, uint32_t p_value);
+};
+
+struct HSLStateReader {
+	const uint8_t *data;
+	uint32_t size;
+	uint32_t pos = 0;
+	bool failed = false; //sticky, so callers can check once after a run of reads
+
+	HSLStateReader(const uint8_t *p_data, uint32_t p_size) :
+			data(p_data), size(p_size) {}
+
+	const uint8_t *get_bytes(uint32_t p_size);
+	uint8_t get_u8();
+	uint32_t get_u32();
+	uint64_t get_u64();
+	String get_string();
+};
+
+/*
+ A compact image of the HSL runtime that can be written out once and restored instead of
+ booting again. Restoring skips the bytecode parser: function bodies and line tables are
+ copied straight out of the image. The image is position independent, so it can be saved
+ to disk and loaded at any address.
+
+ Sections are tagged so later runtime state can be added without breaking older images.
+ */
+class HSLSnapshot : public RefCounted {
+	GDCLASS(HSLSnapshot, RefCounted);
+
+public:
+	enum Section : uint32_t {
+		SECTION_CLASSES = 1, //one HSLBytecodeReader per class file
+		SECTION_SCHEDULER = 2, //script clock
+	};
+
+private:
+	PackedByteArray image;
+	uint32_t source_key = 0;
+
+	Error _validate(const PackedByteArray &p_image, uint32_t p_source_key) const;
+
+protected:
+	static void _bind_methods();
+
+public:
+	Error capture(TypedArray<HSLBytecodeReader> readers, int key = 0);
+	TypedArray<HSLBytecodeReader> restore();
+
+	Error save(String path) const;
+	Error load(String path, int key = 0);
+
+	void set_image(PackedByteArray data);
+	PackedByteArray get_image() const;
+
+	int get_source_key() const;
+	bool is_empty() const;
+};
+
+#endif
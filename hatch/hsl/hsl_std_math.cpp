@@ -0,0 +1,44 @@
+#include "hsl_std_math.h"
+
+#include "core/math/math_funcs.h"
+
+//Plain C++ signatures; HSLNativeBinder turns each into a typed trampoline
+
+static float math_sin(float p_n) { return Math::sin(p_n); }
+static float math_cos(float p_n) { return Math::cos(p_n); }
+static float math_tan(float p_n) { return Math::tan(p_n); }
+static float math_sqrt(float p_n) { return Math::sqrt(p_n); }
+static float math_pow(float p_base, float p_exp) { return Math::pow(p_base, p_exp); }
+static float math_exp(float p_n) { return Math::exp(p_n); }
+static float math_floor(float p_n) { return Math::floor(p_n); }
+static float math_ceil(float p_n) { return Math::ceil(p_n); }
+static float math_round(float p_n) { return Math::round(p_n); }
+static float math_abs(float p_n) { return Math::abs(p_n); }
+static float math_min(float p_a, float p_b) { return MIN(p_a, p_b); }
+static float math_max(float p_a, float p_b) { return MAX(p_a, p_b); }
+static float math_clamp(float p_n, float p_min, float p_max) { return CLAMP(p_n, p_min, p_max); }
+static float math_sign(float p_n) { return SIGN(p_n); }
+
+static float math_distance(float p_x1, float p_y1, float p_x2, float p_y2) {
+	float dx = p_x2 - p_x1;
+	float dy = p_y2 - p_y1;
+	return Math::sqrt(dx * dx + dy * dy);
+}
+
+void hsl_register_std_math(HSLNativeRegistry *p_registry){
+	HSL_BIND_NATIVE(p_registry, "Math", "Sin", &math_sin);
+	HSL_BIND_NATIVE(p_registry, "Math", "Cos", &math_cos);
+	HSL_BIND_NATIVE(p_registry, "Math", "Tan", &math_tan);
+	HSL_BIND_NATIVE(p_registry, "Math", "Sqrt", &math_sqrt);
+	HSL_BIND_NATIVE(p_registry, "Math", "Pow", &math_pow);
+	HSL_BIND_NATIVE(p_registry, "Math", "Exp", &math_exp);
+	HSL_BIND_NATIVE(p_registry, "Math", "Floor", &math_floor);
+	HSL_BIND_NATIVE(p_registry, "Math", "Ceil", &math_ceil);
+	HSL_BIND_NATIVE(p_registry, "Math", "Round", &math_round);
+	HSL_BIND_NATIVE(p_registry, "Math", "Abs", &math_abs);
+	HSL_BIND_NATIVE(p_registry, "Math", "Min", &math_min);
+	HSL_BIND_NATIVE(p_registry, "Math", "Max", &math_max);
+	HSL_BIND_NATIVE(p_registry, "Math", "Clamp", &math_clamp);
+	HSL_BIND_NATIVE(p_registry, "Math", "Sign", &math_sign);
+	HSL_BIND_NATIVE(p_registry, "Math", "Distance", &math_distance);
+}
@@ -0,0 +1,8 @@
+#ifndef HATCH_HSL_STD_MATH_H
+#define HATCH_HSL_STD_MATH_H
+
+#include "hsl_native.h"
+
+void hsl_register_std_math(HSLNativeRegistry *p_registry);
+
+#endif
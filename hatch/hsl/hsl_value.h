@@ -0,0 +1,86 @@
+#ifndef HATCH_HSL_VALUE_H
+#define HATCH_HSL_VALUE_H
+
+#include "core/typedefs.h"
+
+#include <stdint.h>
+
+//Mirrors the value types of the Hatch VM; the linked types point at native engine storage
+enum HSLValueType : uint8_t {
+	HSL_VAL_NULL,
+	HSL_VAL_INTEGER,
+	HSL_VAL_DECIMAL,
+	HSL_VAL_OBJECT,
+	HSL_VAL_LINKED_INTEGER,
+	HSL_VAL_LINKED_DECIMAL,
+};
+
+//Plain old data on purpose: frames, pools and snapshots copy these with memcpy
+struct HSLValue {
+	HSLValueType type;
+	union {
+		int32_t as_integer;
+		float as_decimal;
+		void *as_object;
+		int32_t *as_linked_integer;
+		float *as_linked_decimal;
+	};
+
+	_FORCE_INLINE_ bool is_null() const { return type == HSL_VAL_NULL; }
+	_FORCE_INLINE_ bool is_integer() const { return type == HSL_VAL_INTEGER or type == HSL_VAL_LINKED_INTEGER; }
+	_FORCE_INLINE_ bool is_decimal() const { return type == HSL_VAL_DECIMAL or type == HSL_VAL_LINKED_DECIMAL; }
+	_FORCE_INLINE_ bool is_number() const { return is_integer() or is_decimal(); }
+	_FORCE_INLINE_ bool is_object() const { return type == HSL_VAL_OBJECT; }
+
+	_FORCE_INLINE_ int32_t get_integer() const {
+		switch (type) {
+			case HSL_VAL_INTEGER: return as_integer;
+			case HSL_VAL_LINKED_INTEGER: return *as_linked_integer;
+			case HSL_VAL_DECIMAL: return (int32_t)as_decimal;
+			case HSL_VAL_LINKED_DECIMAL: return (int32_t)*as_linked_decimal;
+			default: return 0;
+		}
+	}
+
+	_FORCE_INLINE_ float get_decimal() const {
+		switch (type) {
+			case HSL_VAL_DECIMAL: return as_decimal;
+			case HSL_VAL_LINKED_DECIMAL: return *as_linked_decimal;
+			case HSL_VAL_INTEGER: return (float)as_integer;
+			case HSL_VAL_LINKED_INTEGER: return (float)*as_linked_integer;
+			default: return 0.0f;
+		}
+	}
+
+	static _FORCE_INLINE_ HSLValue make_null() {
+		HSLValue value;
+		value.type = HSL_VAL_NULL;
+		value.as_object = nullptr;
+		return value;
+	}
+
+	static _FORCE_INLINE_ HSLValue make_integer(int32_t p_value) {
+		HSLValue value;
+		value.type = HSL_VAL_INTEGER;
+		value.as_object = nullptr;
+		value.as_integer = p_value;
+		return value;
+	}
+
+	static _FORCE_INLINE_ HSLValue make_decimal(float p_value) {
+		HSLValue value;
+		value.type = HSL_VAL_DECIMAL;
+		value.as_object = nullptr;
+		value.as_decimal = p_value;
+		return value;
+	}
+
+	static _FORCE_INLINE_ HSLValue make_object(void *p_object) {
+		HSLValue value;
+		value.type = HSL_VAL_OBJECT;
+		value.as_object = p_object;
+		return value;
+	}
+};
+
+#endif
@@ -0,0 +1,170 @@
+#include "hatch_atlas_packer.h"
+
+HatchAtlasPacker::HatchAtlasPacker(Size2i p_page_size, int p_padding){
+	page_size = p_page_size;
+	padding = p_padding;
+}
+
+//Lowest y a rect can sit at when its left edge starts at skyline node p_node, or -1
+int HatchAtlasPacker::_fit(const Page &p_page, uint32_t p_node, int p_width, int p_height) const {
+	int x = p_page.skyline[p_node].x;
+
+	if (x + p_width > page_size.x){
+		return -1;
+	}
+
+	int y = 0;
+	int width_left = p_width;
+
+	for (uint32_t i = p_node; width_left > 0; i++){
+		if (i >= p_page.skyline.size()){
+			return -1;
+		}
+
+		y = MAX(y, p_page.skyline[i].y);
+		if (y + p_height > page_size.y){
+			return -1;
+		}
+
+		width_left -= p_page.skyline[i].width;
+	}
+
+	return y;
+}
+
+void HatchAtlasPacker::_add_level(Page &p_page, uint32_t p_node, int p_x, int p_y, int p_width, int p_height){
+	SkylineNode level;
+	level.x = p_x;
+	level.y = p_y + p_height;
+	level.width = p_width;
+
+	p_page.skyline.insert(p_node, level);
+
+	//trim or drop the nodes the new level now covers
+	for (uint32_t i = p_node + 1; i < p_page.skyline.size(); i++){
+		SkylineNode &previous = p_page.skyline[i - 1];
+		SkylineNode &node = p_page.skyline[i];
+
+		int overlap = previous.x + previous.width - node.x;
+		if (overlap <= 0){
+			break;
+		}
+
+		node.x += overlap;
+		node.width -= overlap;
+
+		if (node.width > 0){
+			break;
+		}
+
+		p_page.skyline.remove_at(i);
+		i--;
+	}
+
+	//merge neighbours at the same height
+	for (uint32_t i = 0; i + 1 < p_page.skyline.size(); i++){
+		if (p_page.skyline[i].y == p_page.skyline[i + 1].y){
+			p_page.skyline[i].width += p_page.skyline[i + 1].width;
+			p_page.skyline.remove_at(i + 1);
+			i--;
+		}
+	}
+}
+
+bool HatchAtlasPacker::_place(Page &p_page, int p_width, int p_height, Point2i &r_position){
+	int best_bottom = INT32_MAX;
+	int best_width = INT32_MAX;
+	int best_node = -1;
+	int best_y = 0;
+
+	for (uint32_t i = 0; i < p_page.skyline.size(); i++){
+		int y = _fit(p_page, i, p_width, p_height);
+		if (y < 0){
+			continue;
+		}
+
+		int bottom = y + p_height;
+		if (bottom < best_bottom or (bottom == best_bottom and p_page.skyline[i].width < best_width)){
+			best_bottom = bottom;
+			best_width = p_page.skyline[i].width;
+			best_node = i;
+			best_y = y;
+		}
+	}
+
+	if (best_node < 0){
+		return false;
+	}
+
+	r_position = Point2i(p_page.skyline[best_node].x, best_y);
+	_add_level(p_page, best_node, r_position.x, r_position.y, p_width, p_height);
+
+	return true;
+}
+
+bool HatchAtlasPacker::pack(const LocalVector<Size2i> &p_sizes, LocalVector<Placement> &r_placements){
+	struct Order {
+		uint32_t index;
+		int height;
+		int width;
+
+		bool operator<(const Order &p_other) const {
+			if (height != p_other.height){
+				return height > p_other.height;
+			}
+			if (width != p_other.width){
+				return width > p_other.width;
+			}
+			return index < p_other.index;
+		}
+	};
+
+	LocalVector<Order> order;
+	order.resize(p_sizes.size());
+
+	for (uint32_t i = 0; i < p_sizes.size(); i++){
+		order[i].index = i;
+		order[i].width = p_sizes[i].x + padding;
+		order[i].height = p_sizes[i].y + padding;
+	}
+
+	//tallest first keeps the skyline flat, which wastes the least space
+	order.sort();
+
+	r_placements.resize(p_sizes.size());
+	bool all_fit = true;
+
+	for (const Order &entry : order){
+		Placement &placement = r_placements[entry.index];
+
+		if (entry.width > page_size.x or entry.height > page_size.y){
+			placement.page = UINT32_MAX;
+			placement.rect = Rect2i();
+			all_fit = false;
+			continue;
+		}
+
+		Point2i position;
+		uint32_t page = 0;
+
+		for (; page < pages.size(); page++){
+			if (_place(pages[page], entry.width, entry.height, position)){
+				break;
+			}
+		}
+
+		if (page == pages.size()){
+			Page new_page;
+			SkylineNode ground = { 0, 0, page_size.x };
+			new_page.skyline.push_back(ground);
+			pages.push_back(new_page);
+
+			_place(pages[page], entry.width, entry.height, position);
+		}
+
+		placement.page = page;
+		placement.rect = Rect2i(position, p_sizes[entry.index]);
+	}
+
+	return all_fit;
+}
@@ -0,0 +1,46 @@
+#ifndef HATCH_ATLAS_PACKER_H
+#define HATCH_ATLAS_PACKER_H
+
+#include "core/math/rect2i.h"
+#include "core/templates/local_vector.h"
+
+/*
+ Skyline bottom-left packer. Rects are placed largest-first on as many fixed-size pages as
+ needed; each page only tracks its top outline, so packing thousands of frames stays cheap.
+ */
+class HatchAtlasPacker {
+	struct SkylineNode {
+		int x;
+		int y;
+		int width;
+	};
+
+	struct Page {
+		LocalVector<SkylineNode> skyline;
+	};
+
+	Size2i page_size;
+	int padding;
+
+	LocalVector<Page> pages;
+
+	int _fit(const Page &p_page, uint32_t p_node, int p_width, int p_height) const;
+	bool _place(Page &p_page, int p_width, int p_height, Point2i &r_position);
+	void _add_level(Page &p_page, uint32_t p_node, int p_x, int p_y, int p_width, int p_height);
+
+public:
+	struct Placement {
+		uint32_t page;
+		Rect2i rect; //excluding padding
+	};
+
+	//Returns false only if a rect can never fit on a page
+	bool pack(const LocalVector<Size2i> &p_sizes, LocalVector<Placement> &r_placements);
+
+	uint32_t get_page_count() const { return pages.size(); }
+	Size2i get_page_size() const { return page_size; }
+
+	HatchAtlasPacker(Size2i p_page_size, int p_padding = 1);
+};
+
+#endif
@@ -0,0 +1,424 @@
+#include "hatch_gif_decoder.h"
+
+#include "core/templates/hash_map.h"
+
+#define GIF_MAX_CODES 4096
+
+struct GIFCursor {
+	const uint8_t *data;
+	int64_t size;
+	int64_t pos;
+
+	_FORCE_INLINE_ bool has(int64_t p_bytes) const { return pos + p_bytes <= size; }
+	_FORCE_INLINE_ uint8_t u8() { return data[pos++]; }
+	_FORCE_INLINE_ uint16_t u16() {
+		uint16_t value = data[pos] | (data[pos + 1] << 8);
+		pos += 2;
+		return value;
+	}
+
+	//Skips a chain of data sub-blocks, ending at the zero-length terminator
+	bool skip_sub_blocks() {
+		while (has(1)) {
+			uint8_t length = u8();
+			if (length == 0) {
+				return true;
+			}
+			if (not has(length)) {
+				return false;
+			}
+			pos += length;
+		}
+		return false;
+	}
+};
+
+static void _read_palette(GIFCursor &p_cursor, int p_count, uint32_t *r_palette){
+	for (int i = 0; i < p_count; i++){
+		uint8_t r = p_cursor.u8();
+		uint8_t g = p_cursor.u8();
+		uint8_t b = p_cursor.u8();
+		r_palette[i] = ((uint32_t)r << 24) | ((uint32_t)g << 16) | ((uint32_t)b << 8) | 0xFF;
+	}
+}
+
+bool HatchGIFDecoder::is_gif(const uint8_t *p_data, int64_t p_size){
+	return p_size >= 6 and (memcmp(p_data, "GIF87a", 6) == 0 or memcmp(p_data, "GIF89a", 6) == 0);
+}
+
+bool HatchGIFDecoder::_decode_lzw(const uint8_t *p_data, int64_t p_size, int p_min_code_size, uint8_t *r_pixels, int64_t p_pixel_count){
+	if (p_min_code_size < 2 or p_min_code_size > 8){
+		return false;
+	}
+
+	uint16_t prefix[GIF_MAX_CODES];
+	uint8_t suffix[GIF_MAX_CODES];
+	uint8_t stack[GIF_MAX_CODES + 1];
+
+	const int clear_code = 1 << p_min_code_size;
+	const int end_code = clear_code + 1;
+
+	for (int i = 0; i < clear_code; i++){
+		prefix[i] = 0;
+		suffix[i] = i;
+	}
+
+	int code_size = p_min_code_size + 1;
+	int next_code = end_code + 1;
+	int old_code = -1;
+	uint8_t first_byte = 0;
+
+	uint32_t bit_buffer = 0;
+	int bit_count = 0;
+	int64_t in_pos = 0;
+	int64_t out_pos = 0;
+
+	while (out_pos < p_pixel_count){
+		while (bit_count < code_size){
+			if (in_pos >= p_size){
+				//truncated streams still keep what was decoded so far, like most decoders
+				return out_pos > 0;
+			}
+			bit_buffer |= (uint32_t)p_data[in_pos++] << bit_count;
+			bit_count += 8;
+		}
+
+		int code = bit_buffer & ((1 << code_size) - 1);
+		bit_buffer >>= code_size;
+		bit_count -= code_size;
+
+		if (code == clear_code){
+			code_size = p_min_code_size + 1;
+			next_code = end_code + 1;
+			old_code = -1;
+			continue;
+		}
+
+		if (code == end_code){
+			break;
+		}
+
+		if (old_code == -1){
+			if (code >= clear_code){
+				return false;
+			}
+			r_pixels[out_pos++] = code;
+			old_code = code;
+			first_byte = code;
+			continue;
+		}
+
+		int in_code = code;
+		int stack_top = 0;
+
+		if (code > next_code){
+			return false;
+		}
+
+		if (code == next_code){
+			//the KwKwK case: the code being defined right now
+			stack[stack_top++] = first_byte;
+			code = old_code;
+		}
+
+		while (code >= clear_code){
+			stack[stack_top++] = suffix[code];
+			code = prefix[code];
+		}
+
+		first_byte = code;
+		stack[stack_top++] = first_byte;
+
+		while (stack_top > 0 and out_pos < p_pixel_count){
+			r_pixels[out_pos++] = stack[--stack_top];
+		}
+
+		if (next_code < GIF_MAX_CODES){
+			prefix[next_code] = old_code;
+			suffix[next_code] = first_byte;
+			next_code++;
+
+			if (next_code == (1 << code_size) and code_size < 12){
+				code_size++;
+			}
+		}
+
+		old_code = in_code;
+	}
+
+	return true;
+}
+
+Error HatchGIFDecoder::read_info(const uint8_t *p_data, int64_t p_size, HatchGIFInfo &r_info){
+	return decode_indices(p_data, p_size, r_info, nullptr);
+}
+
+Error HatchGIFDecoder::decode_indices(const uint8_t *p_data, int64_t p_size, HatchGIFInfo &r_info, uint8_t *r_indices){
+	ERR_FAIL_COND_V(not is_gif(p_data, p_size), ERR_FILE_UNRECOGNIZED);
+
+	GIFCursor cursor = { p_data, p_size, 6 };
+
+	ERR_FAIL_COND_V(not cursor.has(7), ERR_FILE_CORRUPT);
+
+	r_info.width = cursor.u16();
+	r_info.height = cursor.u16();
+	uint8_t screen_flags = cursor.u8();
+	uint8_t background_index = cursor.u8();
+	cursor.u8(); //pixel aspect ratio
+
+	ERR_FAIL_COND_V(r_info.width <= 0 or r_info.height <= 0, ERR_FILE_CORRUPT);
+
+	r_info.palette_size = 0;
+	r_info.transparent_index = -1;
+
+	if (screen_flags & 0x80){
+		r_info.palette_size = 2 << (screen_flags & 0x07);
+		ERR_FAIL_COND_V(not cursor.has(r_info.palette_size * 3), ERR_FILE_CORRUPT);
+		_read_palette(cursor, r_info.palette_size, r_info.palette);
+	}
+
+	while (cursor.has(1)){
+		uint8_t block = cursor.u8();
+
+		if (block == 0x3B){ //trailer without any image
+			break;
+		}
+
+		if (block == 0x21){
+			ERR_FAIL_COND_V(not cursor.has(1), ERR_FILE_CORRUPT);
+			uint8_t label = cursor.u8();
+
+			if (label == 0xF9 and cursor.has(6)){ //graphic control extension
+				cursor.u8(); //block size, always 4
+				uint8_t gce_flags = cursor.u8();
+				cursor.u16(); //delay
+				uint8_t transparent = cursor.u8();
+
+				if (gce_flags & 0x01){
+					r_info.transparent_index = transparent;
+				}
+			}
+
+			ERR_FAIL_COND_V(not cursor.skip_sub_blocks(), ERR_FILE_CORRUPT);
+			continue;
+		}
+
+		ERR_FAIL_COND_V_MSG(block != 0x2C, ERR_FILE_CORRUPT, "Unknown block in GIF data.");
+		ERR_FAIL_COND_V(not cursor.has(9), ERR_FILE_CORRUPT);
+
+		int left = cursor.u16();
+		int top = cursor.u16();
+		int frame_width = cursor.u16();
+		int frame_height = cursor.u16();
+		uint8_t frame_flags = cursor.u8();
+
+		if (frame_flags & 0x80){
+			//a local palette replaces the global one for this frame
+			r_info.palette_size = 2 << (frame_flags & 0x07);
+			ERR_FAIL_COND_V(not cursor.has(r_info.palette_size * 3), ERR_FILE_CORRUPT);
+			_read_palette(cursor, r_info.palette_size, r_info.palette);
+		}
+
+		if (r_info.transparent_index >= 0 and r_info.transparent_index < r_info.palette_size){
+			r_info.palette[r_info.transparent_index] &= 0xFFFFFF00;
+		}
+
+		if (r_indices == nullptr){
+			return OK;
+		}
+
+		ERR_FAIL_COND_V(not cursor.has(1), ERR_FILE_CORRUPT);
+		int min_code_size = cursor.u8();
+
+		//gather the sub-blocks into one contiguous LZW stream
+		LocalVector<uint8_t> lzw_data;
+		while (cursor.has(1)){
+			uint8_t length = cursor.u8();
+			if (length == 0){
+				break;
+			}
+			ERR_FAIL_COND_V(not cursor.has(length), ERR_FILE_CORRUPT);
+
+			uint32_t start = lzw_data.size();
+			lzw_data.resize(start + length);
+			memcpy(lzw_data.ptr() + start, p_data + cursor.pos, length);
+			cursor.pos += length;
+		}
+
+		int64_t frame_pixels = (int64_t)frame_width * frame_height;
+		LocalVector<uint8_t> frame;
+		frame.resize(frame_pixels);
+		memset(frame.ptr(), r_info.transparent_index >= 0 ? r_info.transparent_index : background_index, frame_pixels);
+
+		ERR_FAIL_COND_V_MSG(not _decode_lzw(lzw_data.ptr(), lzw_data.size(), min_code_size, frame.ptr(), frame_pixels), ERR_FILE_CORRUPT, "Invalid LZW data in GIF.");
+
+		memset(r_indices, r_info.transparent_index >= 0 ? r_info.transparent_index : background_index, (size_t)r_info.width * r_info.height);
+
+		//interlaced frames store rows in four passes
+		static const int pass_start[4] = { 0, 4, 2, 1 };
+		static const int pass_step[4] = { 8, 8, 4, 2 };
+		bool interlaced = frame_flags & 0x40;
+
+		int source_row = 0;
+		for (int pass = 0; pass < (interlaced ? 4 : 1); pass++){
+			int start = interlaced ? pass_start[pass] : 0;
+			int step = interlaced ? pass_step[pass] : 1;
+
+			for (int y = start; y < frame_height; y += step, source_row++){
+				int canvas_y = top + y;
+				if (canvas_y < 0 or canvas_y >= r_info.height){
+					continue;
+				}
+
+				int copy_width = MIN(frame_width, r_info.width - left);
+				if (copy_width <= 0){
+					continue;
+				}
+
+				memcpy(r_indices + (int64_t)canvas_y * r_info.width + left, frame.ptr() + (int64_t)source_row * frame_width, copy_width);
+			}
+		}
+
+		return OK;
+	}
+
+	ERR_FAIL_V_MSG(ERR_FILE_CORRUPT, "GIF data has no image.");
+}
+
+Ref<Image> HatchGIFDecoder::decode_rgba(const PackedByteArray &p_buffer){
+	HatchGIFInfo info;
+	ERR_FAIL_COND_V(read_info(p_buffer.ptr(), p_buffer.size(), info) != OK, Ref<Image>());
+
+	LocalVector<uint8_t> indices;
+	indices.resize((int64_t)info.width * info.height);
+
+	ERR_FAIL_COND_V(decode_indices(p_buffer.ptr(), p_buffer.size(), info, indices.ptr()) != OK, Ref<Image>());
+
+	PackedByteArray rgba;
+	rgba.resize(indices.size() * 4);
+	uint8_t *out = rgba.ptrw();
+
+	for (uint32_t i = 0; i < indices.size(); i++){
+		uint32_t color = info.palette[indices[i]];
+		out[i * 4 + 0] = color >> 24;
+		out[i * 4 + 1] = (color >> 16) & 0xFF;
+		out[i * 4 + 2] = (color >> 8) & 0xFF;
+		out[i * 4 + 3] = color & 0xFF;
+	}
+
+	return Image::create_from_data(info.width, info.height, false, Image::FORMAT_RGBA8, rgba);
+}
+
+Ref<Image> HatchGIFDecoder::decode_sheet(const PackedByteArray &p_buffer){
+	Ref<Image> image;
+
+	if (is_gif(p_buffer.ptr(), p_buffer.size())){
+		image = decode_rgba(p_buffer);
+	} else {
+		image.instantiate();
+		if (image->load_png_from_buffer(p_buffer) != OK){
+			return Ref<Image>();
+		}
+	}
+
+	if (image.is_valid() and image->get_format() != Image::FORMAT_RGBA8){
+		image->convert(Image::FORMAT_RGBA8);
+	}
+
+	return image;
+}
+
+Ref<Image> HatchGIFDecoder::decode_sheet_indexed(const PackedByteArray &p_buffer, LocalVector<uint32_t> &r_palette){
+	if (not is_gif(p_buffer.ptr(), p_buffer.size())){
+		return index_image(decode_sheet(p_buffer), r_palette);
+	}
+
+	HatchGIFInfo info;
+	ERR_FAIL_COND_V(read_info(p_buffer.ptr(), p_buffer.size(), info) != OK, Ref<Image>());
+
+	PackedByteArray indices;
+	indices.resize((int64_t)info.width * info.height);
+
+	ERR_FAIL_COND_V(decode_indices(p_buffer.ptr(), p_buffer.size(), info, indices.ptrw()) != OK, Ref<Image>());
+
+	r_palette.resize(info.palette_size);
+	memcpy(r_palette.ptr(), info.palette, info.palette_size * sizeof(uint32_t));
+
+	uint8_t *out = indices.ptrw();
+	int64_t pixel_count = indices.size();
+	int transparent = info.transparent_index < info.palette_size ? info.transparent_index : -1;
+
+	if (transparent > HATCH_TRANSPARENT_INDEX){
+		//swap the GIF's transparent entry into the reserved index
+		for (int64_t i = 0; i < pixel_count; i++){
+			if (out[i] == transparent){
+				out[i] = HATCH_TRANSPARENT_INDEX;
+			} else if (out[i] == HATCH_TRANSPARENT_INDEX){
+				out[i] = transparent;
+			}
+		}
+		SWAP(r_palette[HATCH_TRANSPARENT_INDEX], r_palette[transparent]);
+	} else if (transparent < 0){
+		if (info.palette_size >= 256){
+			//no spare entry to make transparent, so index the colors actually used instead
+			return index_image(decode_rgba(p_buffer), r_palette);
+		}
+
+		for (int64_t i = 0; i < pixel_count; i++){
+			out[i]++;
+		}
+		r_palette.insert(HATCH_TRANSPARENT_INDEX, 0);
+	}
+
+	return Image::create_from_data(info.width, info.height, false, Image::FORMAT_L8, indices);
+}
+
+Ref<Image> HatchGIFDecoder::index_image(const Ref<Image> &p_image, LocalVector<uint32_t> &r_palette){
+	if (p_image.is_null()){
+		return Ref<Image>();
+	}
+
+	Ref<Image> rgba = p_image;
+	if (rgba->get_format() != Image::FORMAT_RGBA8){
+		rgba = p_image->duplicate();
+		rgba->convert(Image::FORMAT_RGBA8);
+	}
+
+	PackedByteArray source = rgba->get_data();
+	const uint8_t *in = source.ptr();
+	int64_t pixel_count = (int64_t)rgba->get_width() * rgba->get_height();
+
+	PackedByteArray indices;
+	indices.resize(pixel_count);
+	uint8_t *out = indices.ptrw();
+
+	HashMap<uint32_t, uint8_t> lookup;
+	r_palette.clear();
+
+	r_palette.push_back(0);
+	lookup.insert(0, HATCH_TRANSPARENT_INDEX);
+
+	for (int64_t i = 0; i < pixel_count; i++){
+		uint32_t color = ((uint32_t)in[i * 4] << 24) | ((uint32_t)in[i * 4 + 1] << 16) | ((uint32_t)in[i * 4 + 2] << 8) | in[i * 4 + 3];
+		if (in[i * 4 + 3] == 0){
+			color = 0; //every transparent pixel shares one index
+		}
+
+		HashMap<uint32_t, uint8_t>::Iterator E = lookup.find(color);
+		if (E){
+			out[i] = E->value;
+			continue;
+		}
+
+		if (r_palette.size() >= 256){
+			r_palette.clear();
+			return Ref<Image>();
+		}
+
+		out[i] = r_palette.size();
+		lookup.insert(color, r_palette.size());
+		r_palette.push_back(color);
+	}
+
+	return Image::create_from_data(rgba->get_width(), rgba->get_height(), false, Image::FORMAT_L8, indices);
+}
@@ -0,0 +1,41 @@
+#ifndef HATCH_GIF_DECODER_H
+#define HATCH_GIF_DECODER_H
+
+#include "core/io/image.h"
+#include "core/templates/local_vector.h"
+
+//Indexed sheets always keep this index transparent, so the zeroed space around frames on an
+//L8 atlas page draws nothing whichever palette row the page is drawn with
+#define HATCH_TRANSPARENT_INDEX 0
+
+//Hatch sprite sheets are mostly 8-bit GIFs, which Godot has no loader for
+struct HatchGIFInfo {
+	int width = 0;
+	int height = 0;
+	int palette_size = 0;
+	int transparent_index = -1;
+	uint32_t palette[256] = {}; //RGBA8, alpha already cleared for the transparent index
+};
+
+class HatchGIFDecoder {
+	static bool _decode_lzw(const uint8_t *p_data, int64_t p_size, int p_min_code_size, uint8_t *r_pixels, int64_t p_pixel_count);
+
+public:
+	static bool is_gif(const uint8_t *p_data, int64_t p_size);
+
+	//Decodes the first frame into one palette index per pixel; r_indices must hold width * height bytes
+	static Error read_info(const uint8_t *p_data, int64_t p_size, HatchGIFInfo &r_info);
+	static Error decode_indices(const uint8_t *p_data, int64_t p_size, HatchGIFInfo &r_info, uint8_t *r_indices);
+
+	static Ref<Image> decode_rgba(const PackedByteArray &p_buffer);
+
+	//Sheets are either GIF or PNG; returns an RGBA8 image or null
+	static Ref<Image> decode_sheet(const PackedByteArray &p_buffer);
+
+	//Same, but keeps one L8 palette index per pixel, with HATCH_TRANSPARENT_INDEX transparent.
+	//PNGs are indexed if they use at most 255 colors besides transparency
+	static Ref<Image> decode_sheet_indexed(const PackedByteArray &p_buffer, LocalVector<uint32_t> &r_palette);
+	static Ref<Image> index_image(const Ref<Image> &p_image, LocalVector<uint32_t> &r_palette);
+};
+
+#endif
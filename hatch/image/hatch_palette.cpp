@@ -0,0 +1,237 @@
+#include "hatch_palette.h"
+
+#include "core/object/callable_method_pointer.h"
+
+Ref<Shader> HatchPalette::shader;
+
+//Index pages are L8, so the index is the red channel. texelFetch keeps linear filtering or
+//mipmaps on the canvas item from blending indices together.
+static const char *hatch_palette_shader_code = R"(
+shader_type canvas_item;
+
+uniform sampler2D palette : filter_nearest, repeat_disable;
+uniform int palette_row = 0;
+
+varying vec4 modulate;
+
+void vertex() {
+	modulate = COLOR;
+}
+
+void fragment() {
+	ivec2 size = textureSize(TEXTURE, 0);
+	ivec2 texel = clamp(ivec2(UV * vec2(size)), ivec2(0), size - 1);
+	int index = int(texelFetch(TEXTURE, texel, 0).r * 255.0 + 0.5);
+	COLOR = texelFetch(palette, ivec2(index, palette_row), 0) * modulate;
+}
+)";
+
+Ref<Shader> HatchPalette::get_shader(){
+	if (shader.is_null()){
+		shader.instantiate();
+		shader->set_code(hatch_palette_shader_code);
+	}
+	return shader;
+}
+
+void HatchPalette::free_shader(){
+	shader.unref();
+}
+
+void HatchPalette::_queue_update(){
+	if (texture.is_null() or update_queued){
+		return;
+	}
+
+	update_queued = true;
+	callable_mp(this, &HatchPalette::_update_texture).call_deferred();
+}
+
+void HatchPalette::_update_texture(){
+	update_queued = false;
+
+	int rows = MAX(get_row_count(), 1);
+
+	PackedByteArray data;
+	data.resize(HATCH_PALETTE_COLORS * rows * 4);
+	memset(data.ptrw(), 0, data.size());
+
+	uint8_t *out = data.ptrw();
+	for (uint32_t i = 0; i < colors.size(); i++){
+		out[i * 4 + 0] = colors[i] >> 24;
+		out[i * 4 + 1] = (colors[i] >> 16) & 0xFF;
+		out[i * 4 + 2] = (colors[i] >> 8) & 0xFF;
+		out[i * 4 + 3] = colors[i] & 0xFF;
+	}
+
+	Ref<Image> image = Image::create_from_data(HATCH_PALETTE_COLORS, rows, false, Image::FORMAT_RGBA8, data);
+
+	if (texture.is_null()){
+		texture = ImageTexture::create_from_image(image);
+	} else if (texture->get_height() != rows){
+		texture->set_image(image);
+	} else {
+		texture->update(image);
+	}
+}
+
+int HatchPalette::add_row(const uint32_t *p_colors, int p_count){
+	ERR_FAIL_COND_V_MSG(get_row_count() >= Image::MAX_HEIGHT, -1, "Too many palette rows.");
+
+	int row = get_row_count();
+	colors.resize(colors.size() + HATCH_PALETTE_COLORS);
+
+	uint32_t *out = colors.ptr() + row * HATCH_PALETTE_COLORS;
+	int count = CLAMP(p_count, 0, HATCH_PALETTE_COLORS);
+	memcpy(out, p_colors, count * sizeof(uint32_t));
+	memset(out + count, 0, (HATCH_PALETTE_COLORS - count) * sizeof(uint32_t));
+
+	_queue_update();
+	return row;
+}
+
+int HatchPalette::find_row(const uint32_t *p_colors, int p_count) const {
+	int count = CLAMP(p_count, 0, HATCH_PALETTE_COLORS);
+
+	for (int row = 0; row < get_row_count(); row++){
+		const uint32_t *existing = get_row_ptr(row);
+		if (memcmp(existing, p_colors, count * sizeof(uint32_t)) != 0){
+			continue;
+		}
+
+		bool rest_empty = true;
+		for (int i = count; i < HATCH_PALETTE_COLORS and rest_empty; i++){
+			rest_empty = existing[i] == 0;
+		}
+
+		if (rest_empty){
+			return row;
+		}
+	}
+
+	return -1;
+}
+
+int HatchPalette::add_palette(PackedColorArray palette){
+	uint32_t row_colors[HATCH_PALETTE_COLORS];
+	int count = MIN(palette.size(), HATCH_PALETTE_COLORS);
+
+	for (int i = 0; i < count; i++){
+		row_colors[i] = palette[i].to_rgba32();
+	}
+
+	return add_row(row_colors, count);
+}
+
+void HatchPalette::set_palette(int row, PackedColorArray palette){
+	ERR_FAIL_INDEX(row, get_row_count());
+
+	uint32_t *out = colors.ptr() + row * HATCH_PALETTE_COLORS;
+	for (int i = 0; i < HATCH_PALETTE_COLORS; i++){
+		out[i] = i < palette.size() ? palette[i].to_rgba32() : 0;
+	}
+
+	_queue_update();
+}
+
+PackedColorArray HatchPalette::get_palette(int row) const {
+	ERR_FAIL_INDEX_V(row, get_row_count(), PackedColorArray());
+
+	PackedColorArray palette;
+	palette.resize(HATCH_PALETTE_COLORS);
+
+	const uint32_t *row_colors = get_row_ptr(row);
+	for (int i = 0; i < HATCH_PALETTE_COLORS; i++){
+		palette.set(i, Color::hex(row_colors[i]));
+	}
+	return palette;
+}
+
+void HatchPalette::set_color(int row, int index, Color color){
+	ERR_FAIL_INDEX(row, get_row_count());
+	ERR_FAIL_INDEX(index, HATCH_PALETTE_COLORS);
+
+	colors[row * HATCH_PALETTE_COLORS + index] = color.to_rgba32();
+	_queue_update();
+}
+
+Color HatchPalette::get_color(int row, int index) const {
+	ERR_FAIL_INDEX_V(row, get_row_count(), Color());
+	ERR_FAIL_INDEX_V(index, HATCH_PALETTE_COLORS, Color());
+
+	return Color::hex(colors[row * HATCH_PALETTE_COLORS + index]);
+}
+
+//Rotates a run of colors, the usual way Hatch games animate water and lights
+void HatchPalette::cycle(int row, int first, int count, int steps){
+	ERR_FAIL_INDEX(row, get_row_count());
+	ERR_FAIL_COND(first < 0 or count <= 0 or first + count > HATCH_PALETTE_COLORS);
+
+	int shift = ((steps % count) + count) % count;
+	if (shift == 0){
+		return;
+	}
+
+	uint32_t *run = colors.ptr() + row * HATCH_PALETTE_COLORS + first;
+	uint32_t rotated[HATCH_PALETTE_COLORS];
+	for (int i = 0; i < count; i++){
+		rotated[(i + shift) % count] = run[i];
+	}
+	memcpy(run, rotated, count * sizeof(uint32_t));
+
+	_queue_update();
+}
+
+void HatchPalette::copy_row(int from, int to){
+	ERR_FAIL_INDEX(from, get_row_count());
+	ERR_FAIL_INDEX(to, get_row_count());
+
+	memcpy(colors.ptr() + to * HATCH_PALETTE_COLORS, get_row_ptr(from), HATCH_PALETTE_COLORS * sizeof(uint32_t));
+	_queue_update();
+}
+
+int HatchPalette::get_row_count() const {
+	return colors.size() / HATCH_PALETTE_COLORS;
+}
+
+Ref<Texture2D> HatchPalette::get_texture(){
+	if (texture.is_null()){
+		_update_texture();
+	}
+	return texture;
+}
+
+Ref<ShaderMaterial> HatchPalette::get_material(int row){
+	ERR_FAIL_INDEX_V(row, get_row_count(), Ref<ShaderMaterial>());
+
+	//one material per row, so sprites sharing a palette can still batch together
+	HashMap<int, Ref<ShaderMaterial>>::Iterator E = materials.find(row);
+	if (E){
+		return E->value;
+	}
+
+	Ref<ShaderMaterial> material;
+	material.instantiate();
+	material->set_shader(get_shader());
+	material->set_shader_parameter(SNAME("palette"), get_texture());
+	material->set_shader_parameter(SNAME("palette_row"), row);
+
+	materials.insert(row, material);
+	return material;
+}
+
+void HatchPalette::_bind_methods(){
+	ClassDB::bind_method(D_METHOD("add_palette", "palette"), &HatchPalette::add_palette);
+	ClassDB::bind_method(D_METHOD("set_palette", "row", "palette"), &HatchPalette::set_palette);
+	ClassDB::bind_method(D_METHOD("get_palette", "row"), &HatchPalette::get_palette);
+	ClassDB::bind_method(D_METHOD("set_color", "row", "index", "color"), &HatchPalette::set_color);
+	ClassDB::bind_method(D_METHOD("get_color", "row", "index"), &HatchPalette::get_color);
+	ClassDB::bind_method(D_METHOD("cycle", "row", "first", "count", "steps"), &HatchPalette::cycle, DEFVAL(1));
+	ClassDB::bind_method(D_METHOD("copy_row", "from", "to"), &HatchPalette::copy_row);
+
+	ClassDB::bind_method(D_METHOD("get_row_count"), &HatchPalette::get_row_count);
+	ClassDB::bind_method(D_METHOD("get_texture"), &HatchPalette::get_texture);
+	ClassDB::bind_method(D_METHOD("get_material", "row"), &HatchPalette::get_material);
+
+	ClassDB::bind_static_method("HatchPalette", D_METHOD("get_shader"), &HatchPalette::get_shader);
+}
@@ -0,0 +1,59 @@
+#ifndef HATCH_PALETTE_H
+#define HATCH_PALETTE_H
+
+#include "core/object/ref_counted.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+#include "scene/resources/image_texture.h"
+#include "scene/resources/material.h"
+
+#define HATCH_PALETTE_COLORS 256
+
+/*
+ A stack of 256-color palettes kept in one small RGBA texture, one palette per row. Indexed
+ sprites (8-bit index pages from HatchSpriteAtlasBuilder) are drawn with the material for a
+ row, whose shader looks each pixel's index up in the texture. Swapping or cycling colors only
+ rewrites the row; the texture is uploaded once per frame however many changes were made, and
+ the sprite pages themselves never change.
+ */
+class HatchPalette : public RefCounted {
+	GDCLASS(HatchPalette, RefCounted);
+
+	static Ref<Shader> shader;
+
+	LocalVector<uint32_t> colors; //RGBA8, HATCH_PALETTE_COLORS per row
+	Ref<ImageTexture> texture;
+	HashMap<int, Ref<ShaderMaterial>> materials;
+	bool update_queued = false;
+
+	void _queue_update();
+	void _update_texture();
+
+protected:
+	static void _bind_methods();
+
+public:
+	static Ref<Shader> get_shader();
+	static void free_shader();
+
+	int add_row(const uint32_t *p_colors, int p_count);
+	int find_row(const uint32_t *p_colors, int p_count) const;
+
+	int add_palette(PackedColorArray palette);
+	void set_palette(int row, PackedColorArray palette);
+	PackedColorArray get_palette(int row) const;
+
+	void set_color(int row, int index, Color color);
+	Color get_color(int row, int index) const;
+
+	void cycle(int row, int first, int count, int steps = 1);
+	void copy_row(int from, int to);
+
+	int get_row_count() const;
+	Ref<Texture2D> get_texture();
+	Ref<ShaderMaterial> get_material(int row);
+
+	const uint32_t *get_row_ptr(int p_row) const { return colors.ptr() + p_row * HATCH_PALETTE_COLORS; }
+};
+
+#endif
@@ -0,0 +1,615 @@
+#include "hatch_sprite_atlas.h"
+#include "hatch_atlas_packer.h"
+#include "hatch_gif_decoder.h"
+#include "../file_io/hatch_archive_reader.h"
+
+#include "core/io/dir_access.h"
+#include "core/io/file_access.h"
+#include "core/io/stream_peer.h"
+#include "core/object/worker_thread_pool.h"
+#include "scene/resources/atlas_texture.h"
+
+//StreamPeerBuffer clamps seeks and zero-fills short reads, so lengths are checked before reading
+static _FORCE_INLINE_ bool _has_bytes(const StreamPeerBuffer &p_buffer, uint64_t p_bytes){
+	return p_bytes <= (uint64_t)(p_buffer.get_size() - p_buffer.get_position());
+}
+
+//Sprite strings are a length byte followed by the characters, sometimes with a trailing null
+static bool _read_headered_string(StreamPeerBuffer &p_buffer, String &r_string){
+	if (not _has_bytes(p_buffer, 1)){
+		return false;
+	}
+
+	uint8_t length = p_buffer.get_u8();
+	if (not _has_bytes(p_buffer, length)){
+		return false;
+	}
+
+	CharString chars;
+	chars.resize(length + 1);
+	p_buffer.get_data((uint8_t *)chars.ptrw(), length);
+	chars.set(length, '\0');
+
+	r_string = String::utf8(chars.get_data());
+	return true;
+}
+
+Error HatchSpriteData::parse(const PackedByteArray &p_buffer, HatchSpriteData &r_data){
+	ERR_FAIL_COND_V(p_buffer.size() < 9, ERR_FILE_CORRUPT);
+	ERR_FAIL_COND_V_MSG(memcmp(p_buffer.ptr(), HATCH_SPRITE_MAGIC, 4) != 0, ERR_FILE_UNRECOGNIZED, "Not a Hatch sprite file.");
+
+	StreamPeerBuffer buffer;
+	buffer.set_data_array(p_buffer);
+	buffer.seek(4);
+
+	r_data.total_frames = buffer.get_u32();
+
+	uint8_t sheet_count = buffer.get_u8();
+	for (int i = 0; i < sheet_count; i++){
+		String sheet;
+		ERR_FAIL_COND_V_MSG(not _read_headered_string(buffer, sheet), ERR_FILE_CORRUPT, "Hatch sprite file is truncated.");
+		r_data.sheets.push_back(sheet);
+	}
+
+	ERR_FAIL_COND_V_MSG(not _has_bytes(buffer, 1), ERR_FILE_CORRUPT, "Hatch sprite file is truncated.");
+	uint8_t hitbox_count = buffer.get_u8();
+	for (int i = 0; i < hitbox_count; i++){
+		String hitbox;
+		ERR_FAIL_COND_V_MSG(not _read_headered_string(buffer, hitbox), ERR_FILE_CORRUPT, "Hatch sprite file is truncated.");
+		r_data.hitboxes.push_back(hitbox);
+	}
+
+	ERR_FAIL_COND_V_MSG(not _has_bytes(buffer, 2), ERR_FILE_CORRUPT, "Hatch sprite file is truncated.");
+	uint16_t animation_count = buffer.get_u16();
+	r_data.animations.resize(animation_count);
+
+	//sheet, duration, id, rect and pivot, then a box per hitbox
+	const uint64_t frame_size = 17 + hitbox_count * 4 * sizeof(int16_t);
+
+	for (HatchSpriteAnimation &animation : r_data.animations){
+		ERR_FAIL_COND_V_MSG(not _read_headered_string(buffer, animation.name), ERR_FILE_CORRUPT, "Hatch sprite file is truncated.");
+
+		ERR_FAIL_COND_V_MSG(not _has_bytes(buffer, 6), ERR_FILE_CORRUPT, "Hatch sprite file is truncated.");
+		uint16_t frame_count = buffer.get_u16();
+		animation.speed = buffer.get_u16();
+		animation.loop_frame = buffer.get_u8();
+		animation.rotation_flags = buffer.get_u8();
+
+		ERR_FAIL_COND_V_MSG(not _has_bytes(buffer, frame_count * frame_size), ERR_FILE_CORRUPT, "Hatch sprite file is truncated.");
+		animation.frames.resize(frame_count);
+
+		for (HatchSpriteFrame &frame : animation.frames){
+			frame.sheet = buffer.get_u8();
+			frame.duration = buffer.get_16();
+			frame.id = buffer.get_u16();
+			frame.rect.position.x = buffer.get_u16();
+			frame.rect.position.y = buffer.get_u16();
+			frame.rect.size.x = buffer.get_u16();
+			frame.rect.size.y = buffer.get_u16();
+			frame.pivot.x = buffer.get_16();
+			frame.pivot.y = buffer.get_16();
+
+			//hitboxes aren't needed for drawing
+			buffer.seek(buffer.get_position() + hitbox_count * 4 * sizeof(int16_t));
+		}
+	}
+
+	return OK;
+}
+
+//What a cached atlas depends on, without reading any sheet pixels
+static uint32_t _sheet_content_key(const String &p_path, uint32_t p_key){
+	if (p_path.begins_with(HATCH_FILE_PREFIX)){
+		Ref<HatchArchiveReader> archive = HatchArchiveReader::get_mounted();
+		const ResourceRegistryItem *item = archive.is_valid() ? archive->find_item(HatchArchiveReader::crc32_string(HatchArchiveReader::strip_prefix(p_path))) : nullptr;
+
+		if (item != nullptr){
+			uint64_t record[3] = { item->offset, item->size, item->compressed_size };
+			return HatchArchiveReader::crc_32_encrypt_data(record, sizeof(record), p_key);
+		}
+		return p_key;
+	}
+
+	uint64_t modified = FileAccess::get_modified_time(p_path);
+	return HatchArchiveReader::crc_32_encrypt_data(&modified, sizeof(modified), p_key);
+}
+
+void HatchSpriteAtlasBuilder::_decode_sheet(uint32_t p_index, SheetJob *p_jobs){
+	SheetJob &job = p_jobs[p_index];
+
+	if (job.bytes.is_empty()){
+		return;
+	}
+
+	if (indexed){
+		job.image = HatchGIFDecoder::decode_sheet_indexed(job.bytes, job.palette);
+		if (job.image.is_null()){
+			WARN_PRINT("Sprite sheet \"" + job.path + "\" has more than 256 colors and can't be indexed.");
+		}
+	} else {
+		job.image = HatchGIFDecoder::decode_sheet(job.bytes);
+	}
+	job.bytes = PackedByteArray();
+}
+
+Error HatchSpriteAtlasBuilder::_load_sprites(uint32_t &r_content_key){
+	HashMap<String, uint32_t> sheet_ids;
+
+	uint32_t key = HATCH_CRC_MAGIC_VALUE;
+	int32_t settings[3] = { page_size, padding, indexed };
+	key = HatchArchiveReader::crc_32_encrypt_data(settings, sizeof(settings), key);
+
+	for (const String &path : sprite_paths){
+		PackedByteArray bytes;
+		Error err = HatchArchiveReader::load_path(path, bytes);
+		ERR_FAIL_COND_V_MSG(err != OK, err, "Could not read sprite \"" + path + "\".");
+
+		SpriteEntry entry;
+		entry.path = path;
+
+		err = HatchSpriteData::parse(bytes, entry.data);
+		ERR_FAIL_COND_V_MSG(err != OK, err, "Could not parse sprite \"" + path + "\".");
+
+		CharString path_utf8 = path.utf8();
+		key = HatchArchiveReader::crc_32_encrypt_data(path_utf8.get_data(), path_utf8.length(), key);
+		key = HatchArchiveReader::crc_32_encrypt_data(bytes.ptr(), bytes.size(), key);
+
+		for (const String &sheet : entry.data.sheets){
+			//sheets are archive paths, or relative to the sprite on disk
+			String sheet_path = path.begins_with(HATCH_FILE_PREFIX) ? HATCH_FILE_PREFIX + sheet : path.get_base_dir().path_join(sheet);
+
+			HashMap<String, uint32_t>::Iterator found = sheet_ids.find(sheet_path);
+			if (found){
+				entry.sheet_ids.push_back(found->value);
+				continue;
+			}
+
+			uint32_t id = sheet_paths.size();
+			sheet_ids.insert(sheet_path, id);
+			sheet_paths.push_back(sheet_path);
+			entry.sheet_ids.push_back(id);
+
+			key = _sheet_content_key(sheet_path, key);
+		}
+
+		sprites.push_back(entry);
+	}
+
+	r_content_key = key;
+	return OK;
+}
+
+Error HatchSpriteAtlasBuilder::_pack(LocalVector<Ref<Image>> &r_page_images){
+	//decode every sheet in parallel; archive reads stay on this thread
+	LocalVector<SheetJob> jobs;
+	jobs.resize(sheet_paths.size());
+
+	for (uint32_t i = 0; i < jobs.size(); i++){
+		jobs[i].path = sheet_paths[i];
+		if (HatchArchiveReader::load_path(sheet_paths[i], jobs[i].bytes) != OK){
+			WARN_PRINT("Could not read sprite sheet \"" + sheet_paths[i] + "\".");
+		}
+	}
+
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(this, &HatchSpriteAtlasBuilder::_decode_sheet, jobs.ptr(), jobs.size(), -1, false, "Hatch sprite sheet decoding");
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+
+	if (indexed){
+		//sheets with the same colors share one palette row
+		sheet_palette_rows.resize(jobs.size());
+		for (uint32_t i = 0; i < jobs.size(); i++){
+			if (jobs[i].image.is_null()){
+				sheet_palette_rows[i] = -1;
+				continue;
+			}
+
+			int row = palette->find_row(jobs[i].palette.ptr(), jobs[i].palette.size());
+			sheet_palette_rows[i] = row >= 0 ? row : palette->add_row(jobs[i].palette.ptr(), jobs[i].palette.size());
+		}
+	}
+
+	//collect each distinct frame rect once, many animations reuse the same frames
+	LocalVector<FrameKey> keys;
+	LocalVector<Size2i> sizes;
+	HashMap<FrameKey, uint32_t, FrameKey> key_indices;
+
+	for (const SpriteEntry &sprite : sprites){
+		for (const HatchSpriteAnimation &animation : sprite.data.animations){
+			for (const HatchSpriteFrame &frame : animation.frames){
+				if (frame.sheet >= sprite.sheet_ids.size() or frame.rect.size.x <= 0 or frame.rect.size.y <= 0){
+					continue;
+				}
+
+				FrameKey key = { sprite.sheet_ids[frame.sheet], frame.rect };
+				if (key_indices.has(key)){
+					continue;
+				}
+
+				const Ref<Image> &sheet = jobs[key.sheet].image;
+				if (sheet.is_null() or not Rect2i(Point2i(), sheet->get_size()).encloses(frame.rect)){
+					continue;
+				}
+
+				key_indices.insert(key, keys.size());
+				keys.push_back(key);
+				sizes.push_back(frame.rect.size);
+			}
+		}
+	}
+
+	HatchAtlasPacker packer(Size2i(page_size, page_size), padding);
+	LocalVector<HatchAtlasPacker::Placement> packed;
+
+	if (not packer.pack(sizes, packed)){
+		WARN_PRINT("Some sprite frames are larger than an atlas page and were skipped.");
+	}
+
+	r_page_images.resize(packer.get_page_count());
+	for (Ref<Image> &page : r_page_images){
+		page = Image::create_empty(page_size, page_size, false, indexed ? Image::FORMAT_L8 : Image::FORMAT_RGBA8);
+	}
+
+	for (uint32_t i = 0; i < keys.size(); i++){
+		if (packed[i].page == UINT32_MAX){
+			continue;
+		}
+
+		r_page_images[packed[i].page]->blit_rect(jobs[keys[i].sheet].image, keys[i].rect, packed[i].rect.position);
+		placements.insert(keys[i], { packed[i].page, packed[i].rect.position });
+	}
+
+	return OK;
+}
+
+bool HatchSpriteAtlasBuilder::_load_cache(uint32_t p_content_key){
+	if (cache_directory.is_empty()){
+		return false;
+	}
+
+	String base = cache_directory.path_join(String::num_uint64(p_content_key, 16).lpad(8, "0"));
+
+	Ref<FileAccess> layout = FileAccess::open(base + ".atlas", FileAccess::READ);
+	if (layout.is_null()){
+		return false;
+	}
+
+	uint8_t magic[4];
+	layout->get_buffer(magic, 4);
+	if (memcmp(magic, HATCH_ATLAS_CACHE_MAGIC, 4) != 0 or layout->get_32() != HATCH_ATLAS_CACHE_VERSION){
+		return false;
+	}
+
+	uint32_t page_count = layout->get_32();
+	uint32_t placement_count = layout->get_32();
+
+	for (uint32_t i = 0; i < placement_count; i++){
+		FrameKey key;
+		key.sheet = layout->get_32();
+		key.rect.position.x = layout->get_32();
+		key.rect.position.y = layout->get_32();
+		key.rect.size.x = layout->get_32();
+		key.rect.size.y = layout->get_32();
+
+		FramePlacement placement;
+		placement.page = layout->get_32();
+		placement.position.x = layout->get_32();
+		placement.position.y = layout->get_32();
+
+		if (layout->eof_reached() or placement.page >= page_count){
+			placements.clear();
+			return false;
+		}
+
+		placements.insert(key, placement);
+	}
+
+	if (indexed){
+		uint32_t row_count = layout->get_32();
+		LocalVector<uint32_t> row_colors;
+		row_colors.resize(HATCH_PALETTE_COLORS);
+
+		for (uint32_t i = 0; i < row_count; i++){
+			for (uint32_t &color : row_colors){
+				color = layout->get_32();
+			}
+			palette->add_row(row_colors.ptr(), row_colors.size());
+		}
+
+		sheet_palette_rows.resize(layout->get_32());
+		for (int32_t &row : sheet_palette_rows){
+			row = layout->get_32();
+		}
+
+		if (layout->eof_reached() or sheet_palette_rows.size() != (uint32_t)sheet_paths.size()){
+			placements.clear();
+			sheet_palette_rows.clear();
+			palette.instantiate(); //drop rows read so far, packing refills it
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < page_count; i++){
+		Ref<Image> image = Image::load_from_file(base + "_" + itos(i) + ".png");
+		if (image.is_null()){
+			placements.clear();
+			pages.clear();
+			sheet_palette_rows.clear();
+			if (indexed){
+				palette.instantiate();
+			}
+			return false;
+		}
+		if (indexed and image->get_format() != Image::FORMAT_L8){
+			image->convert(Image::FORMAT_L8);
+		}
+		pages.push_back(ImageTexture::create_from_image(image));
+	}
+
+	return true;
+}
+
+void HatchSpriteAtlasBuilder::_save_cache(uint32_t p_content_key, const LocalVector<Ref<Image>> &p_page_images){
+	if (cache_directory.is_empty()){
+		return;
+	}
+
+	Error err = DirAccess::make_dir_recursive_absolute(cache_directory);
+	ERR_FAIL_COND_MSG(err != OK and err != ERR_ALREADY_EXISTS, "Could not create the atlas cache directory \"" + cache_directory + "\".");
+
+	String base = cache_directory.path_join(String::num_uint64(p_content_key, 16).lpad(8, "0"));
+
+	//pages first, so a layout file is only ever next to complete pages
+	for (uint32_t i = 0; i < p_page_images.size(); i++){
+		ERR_FAIL_COND(p_page_images[i]->save_png(base + "_" + itos(i) + ".png") != OK);
+	}
+
+	Ref<FileAccess> layout = FileAccess::open(base + ".atlas", FileAccess::WRITE);
+	ERR_FAIL_COND(layout.is_null());
+
+	layout->store_buffer((const uint8_t *)HATCH_ATLAS_CACHE_MAGIC, 4);
+	layout->store_32(HATCH_ATLAS_CACHE_VERSION);
+	layout->store_32(p_page_images.size());
+	layout->store_32(placements.size());
+
+	for (const KeyValue<FrameKey, FramePlacement> &E : placements){
+		layout->store_32(E.key.sheet);
+		layout->store_32(E.key.rect.position.x);
+		layout->store_32(E.key.rect.position.y);
+		layout->store_32(E.key.rect.size.x);
+		layout->store_32(E.key.rect.size.y);
+		layout->store_32(E.value.page);
+		layout->store_32(E.value.position.x);
+		layout->store_32(E.value.position.y);
+	}
+
+	if (indexed){
+		layout->store_32(palette->get_row_count());
+		for (int row = 0; row < palette->get_row_count(); row++){
+			const uint32_t *row_colors = palette->get_row_ptr(row);
+			for (int i = 0; i < HATCH_PALETTE_COLORS; i++){
+				layout->store_32(row_colors[i]);
+			}
+		}
+
+		layout->store_32(sheet_palette_rows.size());
+		for (int32_t row : sheet_palette_rows){
+			layout->store_32(row);
+		}
+	}
+}
+
+void HatchSpriteAtlasBuilder::_emit_sprite_frames(){
+	for (const SpriteEntry &sprite : sprites){
+		Ref<SpriteFrames> frames;
+		frames.instantiate();
+
+		if (sprite.data.animations.size() > 0){
+			frames->remove_animation(SNAME("default"));
+		}
+
+		Dictionary pivots;
+		Dictionary loop_frames;
+
+		for (const HatchSpriteAnimation &animation : sprite.data.animations){
+			StringName name = animation.name;
+			if (frames->has_animation(name)){
+				continue;
+			}
+
+			//frame durations are in ticks relative to the animation speed, so play at a fixed 60 fps
+			frames->add_animation(name);
+			frames->set_animation_speed(name, 60.0);
+			frames->set_animation_loop(name, animation.loop_frame < animation.frames.size());
+
+			Array animation_pivots;
+
+			for (const HatchSpriteFrame &frame : animation.frames){
+				Ref<AtlasTexture> texture;
+				texture.instantiate();
+
+				if (frame.sheet < sprite.sheet_ids.size()){
+					FrameKey key = { sprite.sheet_ids[frame.sheet], frame.rect };
+					HashMap<FrameKey, FramePlacement, FrameKey>::ConstIterator placement = placements.find(key);
+
+					if (placement){
+						texture->set_atlas(pages[placement->value.page]);
+						texture->set_region(Rect2(placement->value.position, frame.rect.size));
+					}
+				}
+
+				float duration = animation.speed > 0 ? (float)frame.duration / animation.speed : 1.0;
+				frames->add_frame(name, texture, MAX(duration, 0.0f));
+				animation_pivots.push_back(frame.pivot);
+			}
+
+			pivots[name] = animation_pivots;
+			loop_frames[name] = animation.loop_frame;
+		}
+
+		//AnimatedSprite2D has no per-frame offset, so keep the pivots where scripts can reach them
+		frames->set_meta(SNAME("hatch_pivots"), pivots);
+		frames->set_meta(SNAME("hatch_loop_frames"), loop_frames);
+
+		if (indexed){
+			//the material follows the first sheet; sprites mixing palettes across sheets are rare
+			int32_t row = sprite.sheet_ids.size() > 0 ? sheet_palette_rows[sprite.sheet_ids[0]] : -1;
+			frames->set_meta(SNAME("hatch_palette_row"), row);
+		}
+
+		sprite_frames[sprite.path] = frames;
+	}
+}
+
+void HatchSpriteAtlasBuilder::add_sprite(String path){
+	if (not sprite_paths.has(path)){
+		sprite_paths.push_back(path);
+	}
+}
+
+void HatchSpriteAtlasBuilder::clear(){
+	sprite_paths.clear();
+	sprites.clear();
+	sheet_paths.clear();
+	placements.clear();
+	pages.clear();
+	sprite_frames.clear();
+	palette.unref();
+	sheet_palette_rows.clear();
+}
+
+Error HatchSpriteAtlasBuilder::build(){
+	ERR_FAIL_COND_V_MSG(sprite_paths.is_empty(), ERR_INVALID_DATA, "No sprites were added to the atlas builder.");
+	ERR_FAIL_COND_V(page_size <= 0 or padding < 0, ERR_INVALID_PARAMETER);
+
+	sprites.clear();
+	sheet_paths.clear();
+	placements.clear();
+	pages.clear();
+	sprite_frames.clear();
+	sheet_palette_rows.clear();
+
+	//a fresh palette each build, materials handed out earlier keep the old one alive
+	palette.unref();
+	if (indexed){
+		palette.instantiate();
+	}
+
+	uint32_t content_key = 0;
+	Error err = _load_sprites(content_key);
+	if (err != OK){
+		return err;
+	}
+
+	if (not _load_cache(content_key)){
+		LocalVector<Ref<Image>> page_images;
+		err = _pack(page_images);
+		if (err != OK){
+			return err;
+		}
+
+		for (const Ref<Image> &image : page_images){
+			pages.push_back(ImageTexture::create_from_image(image));
+		}
+
+		_save_cache(content_key, page_images);
+	}
+
+	_emit_sprite_frames();
+
+	return OK;
+}
+
+Ref<SpriteFrames> HatchSpriteAtlasBuilder::get_sprite_frames(String path) const {
+	return sprite_frames.get(path, Variant());
+}
+
+Dictionary HatchSpriteAtlasBuilder::get_all_sprite_frames() const {
+	return sprite_frames;
+}
+
+int HatchSpriteAtlasBuilder::get_page_count() const {
+	return pages.size();
+}
+
+Ref<Texture2D> HatchSpriteAtlasBuilder::get_page(int index) const {
+	ERR_FAIL_UNSIGNED_INDEX_V((uint32_t)index, pages.size(), Ref<Texture2D>());
+	return pages[index];
+}
+
+Ref<HatchPalette> HatchSpriteAtlasBuilder::get_palette() const {
+	return palette;
+}
+
+Ref<ShaderMaterial> HatchSpriteAtlasBuilder::get_sprite_material(String path) const {
+	ERR_FAIL_COND_V_MSG(palette.is_null(), Ref<ShaderMaterial>(), "Sprite materials only exist for indexed atlases.");
+
+	Ref<SpriteFrames> frames = get_sprite_frames(path);
+	ERR_FAIL_COND_V(frames.is_null(), Ref<ShaderMaterial>());
+
+	int row = frames->get_meta(SNAME("hatch_palette_row"), -1);
+	if (row < 0){
+		return Ref<ShaderMaterial>();
+	}
+	return palette->get_material(row);
+}
+
+void HatchSpriteAtlasBuilder::set_cache_directory(String path){
+	cache_directory = path;
+}
+
+String HatchSpriteAtlasBuilder::get_cache_directory() const {
+	return cache_directory;
+}
+
+void HatchSpriteAtlasBuilder::set_page_size(int size){
+	ERR_FAIL_COND(size <= 0 or size > Image::MAX_WIDTH);
+	page_size = size;
+}
+
+int HatchSpriteAtlasBuilder::get_page_size() const {
+	return page_size;
+}
+
+void HatchSpriteAtlasBuilder::set_padding(int pixels){
+	ERR_FAIL_COND(pixels < 0);
+	padding = pixels;
+}
+
+int HatchSpriteAtlasBuilder::get_padding() const {
+	return padding;
+}
+
+void HatchSpriteAtlasBuilder::set_indexed(bool enabled){
+	indexed = enabled;
+}
+
+bool HatchSpriteAtlasBuilder::is_indexed() const {
+	return indexed;
+}
+
+void HatchSpriteAtlasBuilder::_bind_methods(){
+	ClassDB::bind_method(D_METHOD("add_sprite", "path"), &HatchSpriteAtlasBuilder::add_sprite);
+	ClassDB::bind_method(D_METHOD("clear"), &HatchSpriteAtlasBuilder::clear);
+	ClassDB::bind_method(D_METHOD("build"), &HatchSpriteAtlasBuilder::build);
+
+	ClassDB::bind_method(D_METHOD("get_sprite_frames", "path"), &HatchSpriteAtlasBuilder::get_sprite_frames);
+	ClassDB::bind_method(D_METHOD("get_all_sprite_frames"), &HatchSpriteAtlasBuilder::get_all_sprite_frames);
+	ClassDB::bind_method(D_METHOD("get_page_count"), &HatchSpriteAtlasBuilder::get_page_count);
+	ClassDB::bind_method(D_METHOD("get_page", "index"), &HatchSpriteAtlasBuilder::get_page);
+	ClassDB::bind_method(D_METHOD("get_palette"), &HatchSpriteAtlasBuilder::get_palette);
+	ClassDB::bind_method(D_METHOD("get_sprite_material", "path"), &HatchSpriteAtlasBuilder::get_sprite_material);
+
+	ClassDB::bind_method(D_METHOD("set_cache_directory", "path"), &HatchSpriteAtlasBuilder::set_cache_directory);
+	ClassDB::bind_method(D_METHOD("get_cache_directory"), &HatchSpriteAtlasBuilder::get_cache_directory);
+	ClassDB::bind_method(D_METHOD("set_page_size", "size"), &HatchSpriteAtlasBuilder::set_page_size);
+	ClassDB::bind_method(D_METHOD("get_page_size"), &HatchSpriteAtlasBuilder::get_page_size);
+	ClassDB::bind_method(D_METHOD("set_padding", "pixels"), &HatchSpriteAtlasBuilder::set_padding);
+	ClassDB::bind_method(D_METHOD("get_padding"), &HatchSpriteAtlasBuilder::get_padding);
+	ClassDB::bind_method(D_METHOD("set_indexed", "enabled"), &HatchSpriteAtlasBuilder::set_indexed);
+	ClassDB::bind_method(D_METHOD("is_indexed"), &HatchSpriteAtlasBuilder::is_indexed);
+
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "cache_directory", PROPERTY_HINT_DIR), "set_cache_directory", "get_cache_directory");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "page_size", PROPERTY_HINT_RANGE, "256,16384,1"), "set_page_size", "get_page_size");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "padding", PROPERTY_HINT_RANGE, "0,16,1"), "set_padding", "get_padding");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "indexed"), "set_indexed", "is_indexed");
+}
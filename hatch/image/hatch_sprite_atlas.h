@@ -0,0 +1,146 @@
+#ifndef HATCH_SPRITE_ATLAS_H
+#define HATCH_SPRITE_ATLAS_H
+
+#include "hatch_palette.h"
+#include "../hatch_formats.h"
+
+#include "core/io/image.h"
+#include "core/object/ref_counted.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+#include "scene/resources/image_texture.h"
+#include "scene/resources/sprite_frames.h"
+
+#define HATCH_ATLAS_CACHE_MAGIC "HATL"
+#define HATCH_ATLAS_CACHE_VERSION 3
+#define HATCH_ATLAS_DEFAULT_CACHE_DIR "user://hatch_atlas_cache"
+
+struct HatchSpriteFrame {
+	uint8_t sheet = 0;
+	int16_t duration = 0;
+	uint16_t id = 0;
+	Rect2i rect;
+	Vector2i pivot;
+};
+
+struct HatchSpriteAnimation {
+	String name;
+	uint16_t speed = 0;
+	uint8_t loop_frame = 0;
+	uint8_t rotation_flags = 0;
+	LocalVector<HatchSpriteFrame> frames;
+};
+
+//Layout of a Hatch sprite animation (.bin) file
+struct HatchSpriteData {
+	uint32_t total_frames = 0;
+	Vector<String> sheets;
+	Vector<String> hitboxes;
+	LocalVector<HatchSpriteAnimation> animations;
+
+	static Error parse(const PackedByteArray &p_buffer, HatchSpriteData &r_data);
+};
+
+/*
+ Packs the frames of many sprites onto shared atlas pages. Sheets are decoded on worker
+ threads, each distinct frame rect is placed once with the skyline packer, and every sprite
+ gets a SpriteFrames whose frames are AtlasTextures into those pages. The packed pages and
+ their layout are cached on disk keyed by the sprite and sheet contents, so later builds of
+ the same set only have to load a few PNGs.
+
+ With indexed set, pages hold one palette index per pixel instead of RGBA, and every distinct
+ sheet palette becomes a row of the builder's HatchPalette. Draw such sprites with
+ get_sprite_material() so palette swaps and cycling never touch the pages.
+ */
+class HatchSpriteAtlasBuilder : public RefCounted {
+	GDCLASS(HatchSpriteAtlasBuilder, RefCounted);
+
+	struct SheetJob {
+		String path;
+		PackedByteArray bytes;
+		Ref<Image> image;
+		LocalVector<uint32_t> palette; //only when indexed
+	};
+
+	struct FrameKey {
+		uint32_t sheet;
+		Rect2i rect;
+
+		static uint32_t hash(const FrameKey &p_key) {
+			uint32_t h = hash_murmur3_one_32(p_key.sheet);
+			h = hash_murmur3_one_32(p_key.rect.position.x, h);
+			h = hash_murmur3_one_32(p_key.rect.position.y, h);
+			h = hash_murmur3_one_32(p_key.rect.size.x, h);
+			h = hash_murmur3_one_32(p_key.rect.size.y, h);
+			return hash_fmix32(h);
+		}
+
+		bool operator==(const FrameKey &p_other) const {
+			return sheet == p_other.sheet and rect == p_other.rect;
+		}
+	};
+
+	struct FramePlacement {
+		uint32_t page;
+		Point2i position;
+	};
+
+	struct SpriteEntry {
+		String path;
+		HatchSpriteData data;
+		LocalVector<uint32_t> sheet_ids; //sprite-local sheet index -> builder sheet id
+	};
+
+	String cache_directory = HATCH_ATLAS_DEFAULT_CACHE_DIR;
+	int page_size = 2048;
+	int padding = 1;
+	bool indexed = false;
+
+	Vector<String> sprite_paths;
+
+	LocalVector<SpriteEntry> sprites;
+	Vector<String> sheet_paths;
+	HashMap<FrameKey, FramePlacement, FrameKey> placements;
+	LocalVector<Ref<ImageTexture>> pages;
+	Dictionary sprite_frames;
+
+	Ref<HatchPalette> palette;
+	LocalVector<int32_t> sheet_palette_rows;
+
+	void _decode_sheet(uint32_t p_index, SheetJob *p_jobs);
+
+	Error _load_sprites(uint32_t &r_content_key);
+	Error _pack(LocalVector<Ref<Image>> &r_page_images);
+	bool _load_cache(uint32_t p_content_key);
+	void _save_cache(uint32_t p_content_key, const LocalVector<Ref<Image>> &p_page_images);
+	void _emit_sprite_frames();
+
+protected:
+	static void _bind_methods();
+
+public:
+	void add_sprite(String path);
+	void clear();
+
+	Error build();
+
+	Ref<SpriteFrames> get_sprite_frames(String path) const;
+	Dictionary get_all_sprite_frames() const;
+
+	int get_page_count() const;
+	Ref<Texture2D> get_page(int index) const;
+
+	Ref<HatchPalette> get_palette() const;
+	Ref<ShaderMaterial> get_sprite_material(String path) const;
+
+	void set_cache_directory(String path);
+	String get_cache_directory() const;
+	void set_page_size(int size);
+	int get_page_size() const;
+	void set_padding(int pixels);
+	int get_padding() const;
+	void set_indexed(bool enabled);
+	bool is_indexed() const;
+};
+
+#endif
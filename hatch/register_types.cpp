@@ -1,8 +1,54 @@
 #include "register_types.h"
 #include "core/object/class_db.h"
 
+#include "hatch_benchmark_runner.h"
+#include "hatch_performance.h"
+#include "audio/audio_stream_hatch.h"
+#include "draw/hatch_draw_buffer.h"
+#include "file_io/hatch_archive_manifest.h"
+#include "file_io/hatch_archive_patch.h"
 #include "file_io/hatch_archive_reader.h"
+#include "file_io/hatch_archive_types.h"
+#include "file_io/hatch_name_recovery.h"
+#include "file_io/hatch_sprite_loader.h"
 #include "hsl/hsl_bytecode_reader.h"
+#include "hsl/hsl_debugger.h"
+#include "hsl/hsl_entity_grid.h"
+#include "hsl/hsl_native.h"
+#include "hsl/hsl_scheduler.h"
+#include "hsl/hsl_shape.h"
+#include "hsl/hsl_snapshot.h"
+#include "hsl/hsl_std_math.h"
+#include "image/hatch_palette.h"
+#include "image/hatch_sprite_atlas.h"
+#include "scene/hatch_tile_streamer.h"
+
+#include "core/debugger/engine_debugger.h"
+#include "scene/main/scene_tree.h"
+
+static HSLScheduler *hsl_scheduler = nullptr;
+static HSLShapeTable *hsl_shape_table = nullptr;
+static HSLDebugger *hsl_debugger = nullptr;
+static HSLNativeRegistry *hsl_native_registry = nullptr;
+static Ref<ResourceFormatLoaderHatchSprite> sprite_loader;
+
+//The HSL runtime's per-frame step, run by SceneTree at the end of every process step; idle
+//callbacks can't be removed, so this outlives the singletons and checks for them
+static void _hsl_frame(){
+	SceneTree *tree = SceneTree::get_singleton();
+	if (tree == nullptr){
+		return;
+	}
+
+	if (hsl_scheduler != nullptr){
+		hsl_scheduler->tick(tree->get_process_time());
+	}
+
+	//breakpoints go in as traps between frames, the running code never asks about them
+	if (hsl_debugger != nullptr and EngineDebugger::is_active()){
+		hsl_debugger->sync();
+	}
+}
 
 void register_hatch_types(){
 	ClassDB::register_class<HatchArchiveReader>();
@@ -17,8 +63,69 @@ void initialize_hatch_module(ModuleInitializationLevel p_level){
 
 	if (p_level == MODULE_INITIALIZATION_LEVEL_SCENE) {
 		GDREGISTER_CLASS(HatchArchiveReader);
+		GDREGISTER_CLASS(HatchArchiveManifest);
+		GDREGISTER_CLASS(HatchArchivePatch);
+		GDREGISTER_CLASS(HatchArchiveTypeIndex);
+		GDREGISTER_CLASS(HatchNameRecovery);
 		GDREGISTER_CLASS(HSLBytecodeReader);
+		GDREGISTER_CLASS(HSLSnapshot);
+		GDREGISTER_ABSTRACT_CLASS(HatchPerformance);
+		GDREGISTER_CLASS(HatchDrawBuffer);
+		GDREGISTER_CLASS(HatchSpriteAtlasBuilder);
+		GDREGISTER_CLASS(HatchPalette);
+		GDREGISTER_CLASS(AudioStreamHatch);
+		GDREGISTER_CLASS(AudioStreamPlaybackHatch);
+		GDREGISTER_CLASS(HatchTileStreamer);
+		GDREGISTER_CLASS(HSLEntityGrid);
+		GDREGISTER_CLASS(HatchBenchmarkRunner);
+
+		sprite_loader.instantiate();
+		ResourceLoader::add_resource_format_loader(sprite_loader);
+
+		hsl_scheduler = memnew(HSLScheduler);
+		hsl_shape_table = memnew(HSLShapeTable);
+		hsl_debugger = memnew(HSLDebugger);
+
+		hsl_native_registry = memnew(HSLNativeRegistry);
+		hsl_register_std_math(hsl_native_registry);
+		hatch_register_draw_natives(hsl_native_registry);
+		hsl_register_entity_grid_natives(hsl_native_registry);
+
+		SceneTree::add_idle_callback(&_hsl_frame);
+
+		//Performance may not exist yet at this level, so wait for the first frame
+		callable_mp_static(&HatchPerformance::register_monitors).call_deferred();
 	}
 }
 
-void uninitialize_hatch_module(ModuleInitializationLevel p_level){}
+void uninitialize_hatch_module(ModuleInitializationLevel p_level){
+	if (p_level == MODULE_INITIALIZATION_LEVEL_SCENE) {
+		HatchPerformance::unregister_monitors();
+
+		ResourceLoader::remove_resource_format_loader(sprite_loader);
+		sprite_loader.unref();
+
+		HatchArchiveReader::unmount();
+		HatchPalette::free_shader();
+
+		if (hsl_scheduler != nullptr){
+			memdelete(hsl_scheduler);
+			hsl_scheduler = nullptr;
+		}
+
+		if (hsl_shape_table != nullptr){
+			memdelete(hsl_shape_table);
+			hsl_shape_table = nullptr;
+		}
+
+		if (hsl_debugger != nullptr){
+			memdelete(hsl_debugger);
+			hsl_debugger = nullptr;
+		}
+
+		if (hsl_native_registry != nullptr){
+			memdelete(hsl_native_registry);
+			hsl_native_registry = nullptr;
+		}
+	}
+}
@@ -0,0 +1,601 @@
+#include "hatch_tile_streamer.h"
+#include "../file_io/hatch_archive_reader.h"
+#include "../image/hatch_gif_decoder.h"
+
+#include "core/io/compression.h"
+#include "core/io/marshalls.h"
+#include "scene/resources/image_texture.h"
+
+//TileMapLayer's packed cell data: a format id, then x, y, source, atlas x, atlas y and alternative per cell
+#define TILE_MAP_DATA_HEADER_SIZE 2
+#define TILE_MAP_DATA_CELL_SIZE 12
+
+void HatchTileStreamer::_compress_chunk(uint32_t p_index, const LayerJob *p_job){
+	const int size = chunk_tiles;
+	const HatchTMXLayer &source = *p_job->layer;
+
+	Chunk &chunk = chunks[p_index];
+	ChunkLayer &layer = chunk.layers[p_job->layer_index];
+
+	LocalVector<uint32_t> tiles;
+	tiles.resize(size * size);
+	memset(tiles.ptr(), 0, tiles.size() * sizeof(uint32_t));
+
+	bool has_tiles = false;
+
+	for (int y = 0; y < size; y++){
+		int layer_y = chunk.coords.y * size + y;
+		if (layer_y >= source.size.y){
+			break;
+		}
+
+		for (int x = 0; x < size; x++){
+			int layer_x = chunk.coords.x * size + x;
+			if (layer_x >= source.size.x){
+				break;
+			}
+
+			uint32_t gid = p_job->gids[(int64_t)layer_y * source.size.x + layer_x];
+			tiles[y * size + x] = gid;
+			has_tiles = has_tiles or gid != 0;
+		}
+	}
+
+	if (not has_tiles){
+		return;
+	}
+
+	int64_t raw_size = tiles.size() * sizeof(uint32_t);
+	layer.compressed.resize(Compression::get_max_compressed_buffer_size(raw_size, Compression::MODE_ZSTD));
+	int64_t compressed_size = Compression::compress(layer.compressed.ptrw(), (const uint8_t *)tiles.ptr(), raw_size, Compression::MODE_ZSTD);
+	layer.compressed.resize(compressed_size);
+
+	if (chunk.state == CHUNK_EMPTY){
+		chunk.state = CHUNK_IDLE;
+	}
+}
+
+void HatchTileStreamer::_add_layer(void *p_userdata, const HatchTMXLayer &p_layer, const uint32_t *p_gids){
+	HatchTileStreamer *self = (HatchTileStreamer *)p_userdata;
+	const int size = self->chunk_tiles;
+
+	//load_scene rejects the map once parsing is done
+	if (self->map.size.x > HATCH_TILE_STREAMER_MAX_MAP_SIZE or self->map.size.y > HATCH_TILE_STREAMER_MAX_MAP_SIZE){
+		return;
+	}
+
+	if (self->chunks.is_empty()){
+		self->chunk_count = Vector2i((self->map.size.x + size - 1) / size, (self->map.size.y + size - 1) / size);
+		self->chunks.resize(self->chunk_count.x * self->chunk_count.y);
+
+		for (int y = 0; y < self->chunk_count.y; y++){
+			for (int x = 0; x < self->chunk_count.x; x++){
+				self->chunks[y * self->chunk_count.x + x].coords = Vector2i(x, y);
+			}
+		}
+	}
+
+	Node2D *container = memnew(Node2D);
+	container->set_name(p_layer.name.validate_node_name());
+	container->set_visible(p_layer.visible);
+	container->set_modulate(Color(1, 1, 1, p_layer.opacity));
+	container->set_position(p_layer.offset);
+	self->add_child(container, false, INTERNAL_MODE_FRONT);
+	self->layer_nodes.push_back(container);
+
+	for (Chunk &chunk : self->chunks){
+		chunk.layers.push_back(ChunkLayer());
+	}
+
+	if (self->chunks.is_empty()){
+		return;
+	}
+
+	//each task only touches its own chunk, and the gids stay valid until the parser moves on
+	LayerJob job = { &p_layer, p_gids, self->layer_nodes.size() - 1 };
+
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(self, &HatchTileStreamer::_compress_chunk, (const LayerJob *)&job, self->chunks.size(), -1, false, "Hatch tile chunk compression");
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+}
+
+void HatchTileStreamer::_build_chunk(Chunk *p_chunk){
+	const int size = chunk_tiles;
+
+	LocalVector<uint32_t> tiles;
+	tiles.resize(size * size);
+
+	for (ChunkLayer &layer : p_chunk->layers){
+		if (layer.compressed.is_empty()){
+			continue;
+		}
+
+		int64_t raw_size = tiles.size() * sizeof(uint32_t);
+		if (Compression::decompress((uint8_t *)tiles.ptr(), raw_size, layer.compressed.ptr(), layer.compressed.size(), Compression::MODE_ZSTD) != raw_size){
+			continue;
+		}
+
+		//sized for every tile; trimmed once the ones without a tileset are skipped
+		layer.cells.resize(TILE_MAP_DATA_HEADER_SIZE + tiles.size() * TILE_MAP_DATA_CELL_SIZE);
+		uint8_t *out = layer.cells.ptrw();
+		encode_uint16(0, out);
+		out += TILE_MAP_DATA_HEADER_SIZE;
+
+		uint32_t cell_count = 0;
+
+		for (int i = 0; i < size * size; i++){
+			uint32_t gid = tiles[i] & HATCH_TMX_GID_MASK;
+			if (gid == 0){
+				continue;
+			}
+
+			//tilesets are in ascending firstgid order, so the last one that starts at or below wins
+			int source = tileset_lookup.size() - 1;
+			while (source >= 0 and tileset_lookup[source].first_gid > gid){
+				source--;
+			}
+
+			if (source < 0 or tileset_lookup[source].columns <= 0){
+				continue;
+			}
+
+			int columns = tileset_lookup[source].columns;
+			uint32_t local = gid - tileset_lookup[source].first_gid;
+
+			uint16_t alternative = 0;
+			if (tiles[i] & HATCH_TMX_FLIP_H){
+				alternative |= TileSetAtlasSource::TRANSFORM_FLIP_H;
+			}
+			if (tiles[i] & HATCH_TMX_FLIP_V){
+				alternative |= TileSetAtlasSource::TRANSFORM_FLIP_V;
+			}
+			if (tiles[i] & HATCH_TMX_FLIP_DIAGONAL){
+				alternative |= TileSetAtlasSource::TRANSFORM_TRANSPOSE;
+			}
+
+			encode_uint16((int16_t)(p_chunk->coords.x * size + i % size), out);
+			encode_uint16((int16_t)(p_chunk->coords.y * size + i / size), out + 2);
+			encode_uint16(source, out + 4);
+			encode_uint16(local % columns, out + 6);
+			encode_uint16(local / columns, out + 8);
+			encode_uint16(alternative, out + 10);
+			out += TILE_MAP_DATA_CELL_SIZE;
+			cell_count++;
+		}
+
+		layer.cells.resize(cell_count > 0 ? TILE_MAP_DATA_HEADER_SIZE + cell_count * TILE_MAP_DATA_CELL_SIZE : 0);
+	}
+}
+
+Ref<TileSet> HatchTileStreamer::_create_tile_set() const {
+	Ref<TileSet> set;
+	set.instantiate();
+	set->set_tile_size(map.tile_size);
+
+	//source ids follow the TMX tileset order, the same as the cell data assumes
+	for (uint32_t i = 0; i < map.tilesets.size(); i++){
+		const HatchTMXTileset &tileset = map.tilesets[i];
+
+		Ref<TileSetAtlasSource> source;
+		source.instantiate();
+		source->set_name(tileset.name);
+		source->set_texture_region_size(tileset.tile_size);
+		source->set_margins(Vector2i(tileset.margin, tileset.margin));
+		source->set_separation(Vector2i(tileset.spacing, tileset.spacing));
+
+		PackedByteArray bytes;
+		Ref<Image> image;
+		if (not tileset.image_path.is_empty() and HatchArchiveReader::load_path(tileset.image_path, bytes) == OK){
+			image = HatchGIFDecoder::decode_sheet(bytes);
+		}
+
+		if (image.is_valid() and tileset_lookup[i].columns > 0){
+			source->set_texture(ImageTexture::create_from_image(image));
+
+			int columns = tileset_lookup[i].columns;
+			int tile_count = tileset.tile_count;
+			if (tile_count <= 0){
+				int rows = (image->get_height() - tileset.margin * 2 + tileset.spacing) / MAX(tileset.tile_size.y + tileset.spacing, 1);
+				tile_count = rows * columns;
+			}
+
+			for (int tile = 0; tile < tile_count; tile++){
+				source->create_tile(Vector2i(tile % columns, tile / columns));
+			}
+		} else {
+			WARN_PRINT("Could not load the image for tileset \"" + tileset.name + "\".");
+		}
+
+		set->add_source(source, i);
+	}
+
+	return set;
+}
+
+Rect2i HatchTileStreamer::_get_chunk_range(float p_margin) const {
+	Rect2 view = get_global_transform_with_canvas().affine_inverse().xform(get_viewport_rect()).grow(p_margin);
+	Vector2 chunk_pixels = Vector2(map.tile_size * chunk_tiles);
+
+	Vector2i from = (view.position / chunk_pixels).floor();
+	Vector2i to = (view.get_end() / chunk_pixels).ceil();
+
+	from = from.clamp(Vector2i(), chunk_count);
+	to = to.clamp(Vector2i(), chunk_count);
+
+	return Rect2i(from, to - from);
+}
+
+void HatchTileStreamer::_activate(uint32_t p_index){
+	Chunk &chunk = chunks[p_index];
+
+	for (uint32_t i = 0; i < chunk.layers.size(); i++){
+		ChunkLayer &layer = chunk.layers[i];
+		if (layer.cells.is_empty()){
+			continue;
+		}
+
+		layer.node = memnew(TileMapLayer);
+		layer.node->set_name(vformat("Chunk%d_%d", chunk.coords.x, chunk.coords.y));
+		layer.node->set_tile_set(tile_set);
+		layer.node->set_tile_map_data_from_array(layer.cells);
+		layer_nodes[i]->add_child(layer.node);
+
+		layer.cells = PackedByteArray();
+	}
+
+	chunk.state = CHUNK_ACTIVE;
+	active_chunks.push_back(p_index);
+
+	emit_signal(SNAME("chunk_activated"), chunk.coords);
+}
+
+void HatchTileStreamer::_evict(uint32_t p_index){
+	Chunk &chunk = chunks[p_index];
+
+	for (ChunkLayer &layer : chunk.layers){
+		if (layer.node != nullptr){
+			layer.node->queue_free();
+			layer.node = nullptr;
+		}
+	}
+
+	chunk.state = CHUNK_IDLE;
+
+	emit_signal(SNAME("chunk_evicted"), chunk.coords);
+}
+
+void HatchTileStreamer::_update_streaming(){
+	if (chunks.is_empty() or tile_set.is_null()){
+		return;
+	}
+
+	Rect2i wanted = _get_chunk_range(activation_margin);
+	Rect2i keep = _get_chunk_range(MAX(activation_margin, eviction_margin));
+
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+
+	for (uint32_t i = 0; i < building_chunks.size(); i++){
+		Chunk &chunk = chunks[building_chunks[i]];
+		if (not pool->is_task_completed(chunk.task)){
+			continue;
+		}
+
+		pool->wait_for_task_completion(chunk.task);
+		chunk.task = WorkerThreadPool::INVALID_TASK_ID;
+		chunk.state = CHUNK_READY;
+
+		ready_chunks.push_back(building_chunks[i]);
+		building_chunks.remove_at_unordered(i);
+		i--;
+	}
+
+	//turning cells into nodes is the only main thread cost, so it is spread over frames
+	int activations = 0;
+	for (uint32_t i = 0; i < ready_chunks.size(); i++){
+		Chunk &chunk = chunks[ready_chunks[i]];
+
+		if (not keep.has_point(chunk.coords)){
+			//the view moved on before it was needed
+			for (ChunkLayer &layer : chunk.layers){
+				layer.cells = PackedByteArray();
+			}
+			chunk.state = CHUNK_IDLE;
+		} else if (activations < max_activations_per_frame){
+			_activate(ready_chunks[i]);
+			activations++;
+		} else {
+			continue;
+		}
+
+		ready_chunks.remove_at_unordered(i);
+		i--;
+	}
+
+	if (building_chunks.size() < (uint32_t)max_builds_in_flight){
+		struct Candidate {
+			uint32_t index;
+			int distance;
+
+			bool operator<(const Candidate &p_other) const { return distance < p_other.distance; }
+		};
+
+		LocalVector<Candidate> candidates;
+		Vector2i center = wanted.get_center();
+
+		for (int y = wanted.position.y; y < wanted.get_end().y; y++){
+			for (int x = wanted.position.x; x < wanted.get_end().x; x++){
+				uint32_t index = y * chunk_count.x + x;
+				if (chunks[index].state == CHUNK_IDLE){
+					candidates.push_back({ index, ABS(x - center.x) + ABS(y - center.y) });
+				}
+			}
+		}
+
+		//nearest first, so the middle of the screen fills in before the edges
+		candidates.sort();
+
+		for (const Candidate &candidate : candidates){
+			if (building_chunks.size() >= (uint32_t)max_builds_in_flight){
+				break;
+			}
+
+			Chunk &chunk = chunks[candidate.index];
+			chunk.state = CHUNK_BUILDING;
+			chunk.task = pool->add_template_task(this, &HatchTileStreamer::_build_chunk, &chunk, false, "Hatch tile chunk");
+			building_chunks.push_back(candidate.index);
+		}
+	}
+
+	int evictions = 0;
+	for (uint32_t i = 0; i < active_chunks.size() and evictions < max_evictions_per_frame; i++){
+		if (keep.has_point(chunks[active_chunks[i]].coords)){
+			continue;
+		}
+
+		_evict(active_chunks[i]);
+		evictions++;
+
+		active_chunks.remove_at_unordered(i);
+		i--;
+	}
+}
+
+void HatchTileStreamer::_wait_for_builds(){
+	for (uint32_t index : building_chunks){
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(chunks[index].task);
+		chunks[index].task = WorkerThreadPool::INVALID_TASK_ID;
+		chunks[index].state = CHUNK_READY;
+		ready_chunks.push_back(index);
+	}
+	building_chunks.clear();
+}
+
+Error HatchTileStreamer::load_scene(String path){
+	clear();
+
+	PackedByteArray bytes;
+	Error err = HatchArchiveReader::load_path(path, bytes);
+	ERR_FAIL_COND_V_MSG(err != OK, err, "Could not read Hatch scene \"" + path + "\".");
+
+	chunk_tiles = chunk_size;
+
+	err = HatchTMXReader::parse(bytes, path.get_base_dir(), map, _add_layer, this);
+	if (err != OK){
+		clear();
+		return err;
+	}
+
+	if (map.size.x > HATCH_TILE_STREAMER_MAX_MAP_SIZE or map.size.y > HATCH_TILE_STREAMER_MAX_MAP_SIZE){
+		clear();
+		ERR_FAIL_V_MSG(ERR_INVALID_DATA, vformat("Hatch scene \"%s\" is %dx%d tiles; scenes can be at most %d tiles on a side.", path, map.size.x, map.size.y, HATCH_TILE_STREAMER_MAX_MAP_SIZE));
+	}
+
+	for (const HatchTMXTileset &tileset : map.tilesets){
+		TilesetLookup lookup;
+		lookup.first_gid = tileset.first_gid;
+		lookup.columns = tileset.columns;
+
+		//older tilesets only give the image size
+		if (lookup.columns <= 0 and tileset.tile_size.x > 0){
+			lookup.columns = (tileset.image_size.x - tileset.margin * 2 + tileset.spacing) / (tileset.tile_size.x + tileset.spacing);
+		}
+
+		tileset_lookup.push_back(lookup);
+	}
+
+	if (tile_set.is_null()){
+		tile_set = _create_tile_set();
+		generated_tile_set = true;
+	}
+
+	scene_path = path;
+	return OK;
+}
+
+void HatchTileStreamer::_count_layer(void *p_userdata, const HatchTMXLayer &p_layer, const uint32_t *p_gids){
+	*(int64_t *)p_userdata += (int64_t)p_layer.size.x * p_layer.size.y;
+}
+
+int64_t HatchTileStreamer::parse_scene(String path){
+	PackedByteArray bytes;
+	Error err = HatchArchiveReader::load_path(path, bytes);
+	ERR_FAIL_COND_V_MSG(err != OK, -1, "Could not read Hatch scene \"" + path + "\".");
+
+	HatchTMXMap parsed;
+	int64_t tiles = 0;
+	err = HatchTMXReader::parse(bytes, path.get_base_dir(), parsed, _count_layer, &tiles);
+	return err == OK ? tiles : -1;
+}
+
+void HatchTileStreamer::clear(){
+	_wait_for_builds();
+
+	for (Node2D *layer_node : layer_nodes){
+		remove_child(layer_node);
+		memdelete(layer_node);
+	}
+
+	if (generated_tile_set){
+		tile_set.unref();
+		generated_tile_set = false;
+	}
+
+	layer_nodes.clear();
+	chunks.clear();
+	tileset_lookup.clear();
+	building_chunks.clear();
+	ready_chunks.clear();
+	active_chunks.clear();
+
+	map = HatchTMXMap();
+	chunk_count = Vector2i();
+}
+
+void HatchTileStreamer::set_scene_path(String path){
+	scene_path = path;
+
+	if (is_inside_tree()){
+		if (path.is_empty()){
+			clear();
+		} else {
+			load_scene(path);
+		}
+	}
+}
+
+String HatchTileStreamer::get_scene_path() const {
+	return scene_path;
+}
+
+void HatchTileStreamer::set_tile_set(Ref<TileSet> p_tile_set){
+	ERR_FAIL_COND_MSG(not chunks.is_empty(), "Set the tile set before loading a scene.");
+	tile_set = p_tile_set;
+	generated_tile_set = false;
+}
+
+Ref<TileSet> HatchTileStreamer::get_tile_set() const {
+	return tile_set;
+}
+
+void HatchTileStreamer::set_chunk_size(int tiles){
+	ERR_FAIL_COND(tiles < 4 or tiles > 256);
+	chunk_size = tiles;
+}
+
+int HatchTileStreamer::get_chunk_size() const {
+	return chunk_size;
+}
+
+void HatchTileStreamer::set_activation_margin(float pixels){
+	activation_margin = MAX(pixels, 0.0f);
+}
+
+float HatchTileStreamer::get_activation_margin() const {
+	return activation_margin;
+}
+
+void HatchTileStreamer::set_eviction_margin(float pixels){
+	eviction_margin = MAX(pixels, 0.0f);
+}
+
+float HatchTileStreamer::get_eviction_margin() const {
+	return eviction_margin;
+}
+
+void HatchTileStreamer::set_max_activations_per_frame(int count){
+	max_activations_per_frame = MAX(count, 1);
+}
+
+int HatchTileStreamer::get_max_activations_per_frame() const {
+	return max_activations_per_frame;
+}
+
+void HatchTileStreamer::set_max_evictions_per_frame(int count){
+	max_evictions_per_frame = MAX(count, 1);
+}
+
+int HatchTileStreamer::get_max_evictions_per_frame() const {
+	return max_evictions_per_frame;
+}
+
+void HatchTileStreamer::set_max_builds_in_flight(int count){
+	max_builds_in_flight = MAX(count, 1);
+}
+
+int HatchTileStreamer::get_max_builds_in_flight() const {
+	return max_builds_in_flight;
+}
+
+Vector2i HatchTileStreamer::get_map_size() const {
+	return map.size;
+}
+
+Vector2i HatchTileStreamer::get_tile_size() const {
+	return map.tile_size;
+}
+
+int HatchTileStreamer::get_chunk_count() const {
+	return chunks.size();
+}
+
+int HatchTileStreamer::get_active_chunk_count() const {
+	return active_chunks.size();
+}
+
+void HatchTileStreamer::_notification(int p_what){
+	switch (p_what){
+		case NOTIFICATION_READY: {
+			if (chunks.is_empty() and not scene_path.is_empty()){
+				load_scene(scene_path);
+			}
+			set_process_internal(true);
+		} break;
+
+		case NOTIFICATION_INTERNAL_PROCESS: {
+			_update_streaming();
+		} break;
+	}
+}
+
+void HatchTileStreamer::_bind_methods(){
+	ClassDB::bind_method(D_METHOD("load_scene", "path"), &HatchTileStreamer::load_scene);
+	ClassDB::bind_method(D_METHOD("clear"), &HatchTileStreamer::clear);
+	ClassDB::bind_static_method("HatchTileStreamer", D_METHOD("parse_scene", "path"), &HatchTileStreamer::parse_scene);
+
+	ClassDB::bind_method(D_METHOD("set_scene_path", "path"), &HatchTileStreamer::set_scene_path);
+	ClassDB::bind_method(D_METHOD("get_scene_path"), &HatchTileStreamer::get_scene_path);
+	ClassDB::bind_method(D_METHOD("set_tile_set", "tile_set"), &HatchTileStreamer::set_tile_set);
+	ClassDB::bind_method(D_METHOD("get_tile_set"), &HatchTileStreamer::get_tile_set);
+	ClassDB::bind_method(D_METHOD("set_chunk_size", "tiles"), &HatchTileStreamer::set_chunk_size);
+	ClassDB::bind_method(D_METHOD("get_chunk_size"), &HatchTileStreamer::get_chunk_size);
+	ClassDB::bind_method(D_METHOD("set_activation_margin", "pixels"), &HatchTileStreamer::set_activation_margin);
+	ClassDB::bind_method(D_METHOD("get_activation_margin"), &HatchTileStreamer::get_activation_margin);
+	ClassDB::bind_method(D_METHOD("set_eviction_margin", "pixels"), &HatchTileStreamer::set_eviction_margin);
+	ClassDB::bind_method(D_METHOD("get_eviction_margin"), &HatchTileStreamer::get_eviction_margin);
+	ClassDB::bind_method(D_METHOD("set_max_activations_per_frame", "count"), &HatchTileStreamer::set_max_activations_per_frame);
+	ClassDB::bind_method(D_METHOD("get_max_activations_per_frame"), &HatchTileStreamer::get_max_activations_per_frame);
+	ClassDB::bind_method(D_METHOD("set_max_evictions_per_frame", "count"), &HatchTileStreamer::set_max_evictions_per_frame);
+	ClassDB::bind_method(D_METHOD("get_max_evictions_per_frame"), &HatchTileStreamer::get_max_evictions_per_frame);
+	ClassDB::bind_method(D_METHOD("set_max_builds_in_flight", "count"), &HatchTileStreamer::set_max_builds_in_flight);
+	ClassDB::bind_method(D_METHOD("get_max_builds_in_flight"), &HatchTileStreamer::get_max_builds_in_flight);
+
+	ClassDB::bind_method(D_METHOD("get_map_size"), &HatchTileStreamer::get_map_size);
+	ClassDB::bind_method(D_METHOD("get_tile_size"), &HatchTileStreamer::get_tile_size);
+	ClassDB::bind_method(D_METHOD("get_chunk_count"), &HatchTileStreamer::get_chunk_count);
+	ClassDB::bind_method(D_METHOD("get_active_chunk_count"), &HatchTileStreamer::get_active_chunk_count);
+
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "scene_path"), "set_scene_path", "get_scene_path");
+	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "tile_set", PROPERTY_HINT_RESOURCE_TYPE, "TileSet"), "set_tile_set", "get_tile_set");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "chunk_size", PROPERTY_HINT_RANGE, "4,256,1,suffix:tiles"), "set_chunk_size", "get_chunk_size");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "activation_margin", PROPERTY_HINT_RANGE, "0,4096,1,suffix:px"), "set_activation_margin", "get_activation_margin");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "eviction_margin", PROPERTY_HINT_RANGE, "0,8192,1,suffix:px"), "set_eviction_margin", "get_eviction_margin");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_activations_per_frame", PROPERTY_HINT_RANGE, "1,64,1"), "set_max_activations_per_frame", "get_max_activations_per_frame");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_evictions_per_frame", PROPERTY_HINT_RANGE, "1,64,1"), "set_max_evictions_per_frame", "get_max_evictions_per_frame");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_builds_in_flight", PROPERTY_HINT_RANGE, "1,64,1"), "set_max_builds_in_flight", "get_max_builds_in_flight");
+
+	ADD_SIGNAL(MethodInfo("chunk_activated", PropertyInfo(Variant::VECTOR2I, "chunk")));
+	ADD_SIGNAL(MethodInfo("chunk_evicted", PropertyInfo(Variant::VECTOR2I, "chunk")));
+}
+
+HatchTileStreamer::~HatchTileStreamer(){
+	_wait_for_builds();
+}
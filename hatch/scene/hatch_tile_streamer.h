@@ -0,0 +1,127 @@
+#ifndef HATCH_TILE_STREAMER_H
+#define HATCH_TILE_STREAMER_H
+
+#include "hatch_tmx_reader.h"
+
+#include "core/object/worker_thread_pool.h"
+#include "scene/2d/node_2d.h"
+#include "scene/2d/tile_map_layer.h"
+#include "scene/resources/2d/tile_set.h"
+
+//TileMapLayer cell data packs coordinates into int16
+#define HATCH_TILE_STREAMER_MAX_MAP_SIZE 32767
+
+/*
+ Streams the tile layers of a Hatch scene (.tmx) around the view. On load, every layer is cut
+ into fixed-size chunks that are kept compressed; nothing is built yet. While running, chunks
+ near the visible area are expanded into TileMapLayer cell data on worker threads and turned
+ into nodes a few per frame, and chunks that fall far outside it are freed again a few per
+ frame. Memory and per-frame work follow what is on screen rather than the size of the level.
+ */
+class HatchTileStreamer : public Node2D {
+	GDCLASS(HatchTileStreamer, Node2D);
+
+	enum ChunkState {
+		CHUNK_EMPTY, //no tiles on any layer
+		CHUNK_IDLE,
+		CHUNK_BUILDING,
+		CHUNK_READY,
+		CHUNK_ACTIVE,
+	};
+
+	struct ChunkLayer {
+		PackedByteArray compressed; //global ids, empty if the layer has no tiles here
+		PackedByteArray cells; //TileMapLayer data, only while ready
+		TileMapLayer *node = nullptr;
+	};
+
+	struct Chunk {
+		Vector2i coords;
+		ChunkState state = CHUNK_EMPTY;
+		WorkerThreadPool::TaskID task = WorkerThreadPool::INVALID_TASK_ID;
+		LocalVector<ChunkLayer> layers;
+	};
+
+	//one layer being cut into chunks, shared by the compression tasks
+	struct LayerJob {
+		const HatchTMXLayer *layer;
+		const uint32_t *gids;
+		uint32_t layer_index;
+	};
+
+	struct TilesetLookup {
+		uint32_t first_gid;
+		int columns;
+	};
+
+	String scene_path;
+	Ref<TileSet> tile_set;
+	int chunk_size = 32;
+	float activation_margin = 256.0;
+	float eviction_margin = 1024.0;
+	int max_activations_per_frame = 4;
+	int max_evictions_per_frame = 8;
+	int max_builds_in_flight = 8;
+
+	HatchTMXMap map;
+	int chunk_tiles = 32; //chunk_size when the scene was loaded
+	bool generated_tile_set = false;
+	Vector2i chunk_count;
+	LocalVector<Chunk> chunks;
+	LocalVector<TilesetLookup> tileset_lookup;
+	LocalVector<Node2D *> layer_nodes;
+
+	LocalVector<uint32_t> building_chunks;
+	LocalVector<uint32_t> ready_chunks;
+	LocalVector<uint32_t> active_chunks;
+
+	static void _add_layer(void *p_userdata, const HatchTMXLayer &p_layer, const uint32_t *p_gids);
+	void _compress_chunk(uint32_t p_index, const LayerJob *p_job);
+	static void _count_layer(void *p_userdata, const HatchTMXLayer &p_layer, const uint32_t *p_gids);
+	void _build_chunk(Chunk *p_chunk);
+
+	Ref<TileSet> _create_tile_set() const;
+	Rect2i _get_chunk_range(float p_margin) const;
+
+	void _activate(uint32_t p_index);
+	void _evict(uint32_t p_index);
+	void _update_streaming();
+	void _wait_for_builds();
+
+protected:
+	static void _bind_methods();
+	void _notification(int p_what);
+
+public:
+	Error load_scene(String path);
+	void clear();
+	//Only parses a scene, building nothing, and returns how many tiles its layers hold or -1;
+	//what load_scene spends besides building layers, for benchmarks
+	static int64_t parse_scene(String path);
+
+	void set_scene_path(String path);
+	String get_scene_path() const;
+	void set_tile_set(Ref<TileSet> tile_set);
+	Ref<TileSet> get_tile_set() const;
+	void set_chunk_size(int tiles);
+	int get_chunk_size() const;
+	void set_activation_margin(float pixels);
+	float get_activation_margin() const;
+	void set_eviction_margin(float pixels);
+	float get_eviction_margin() const;
+	void set_max_activations_per_frame(int count);
+	int get_max_activations_per_frame() const;
+	void set_max_evictions_per_frame(int count);
+	int get_max_evictions_per_frame() const;
+	void set_max_builds_in_flight(int count);
+	int get_max_builds_in_flight() const;
+
+	Vector2i get_map_size() const;
+	Vector2i get_tile_size() const;
+	int get_chunk_count() const;
+	int get_active_chunk_count() const;
+
+	~HatchTileStreamer();
+};
+
+#endif
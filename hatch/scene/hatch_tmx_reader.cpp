@@ -0,0 +1,415 @@
+#include "hatch_tmx_reader.h"
+#include "../file_io/hatch_archive_reader.h"
+#include "../file_io/hatch_xml_reader.h"
+#include "../hatch_performance.h"
+
+#include "core/crypto/crypto_core.h"
+#include "core/io/compression.h"
+#include "core/io/marshalls.h"
+
+//Every element and attribute the reader looks at, interned once per parse
+struct TMXNames {
+	HatchXMLNames table;
+
+	uint32_t map, tileset, image, tile, layer, data, properties, objectgroup, imagelayer, wangsets;
+	uint32_t name, width, height, tilewidth, tileheight, columns, tilecount, spacing, margin;
+	uint32_t source, firstgid, visible, offsetx, offsety, opacity, encoding, compression, gid, infinite;
+
+	TMXNames(){
+		map = table.intern("map");
+		tileset = table.intern("tileset");
+		image = table.intern("image");
+		tile = table.intern("tile");
+		layer = table.intern("layer");
+		data = table.intern("data");
+		properties = table.intern("properties");
+		objectgroup = table.intern("objectgroup");
+		imagelayer = table.intern("imagelayer");
+		wangsets = table.intern("wangsets");
+
+		name = table.intern("name");
+		width = table.intern("width");
+		height = table.intern("height");
+		tilewidth = table.intern("tilewidth");
+		tileheight = table.intern("tileheight");
+		columns = table.intern("columns");
+		tilecount = table.intern("tilecount");
+		spacing = table.intern("spacing");
+		margin = table.intern("margin");
+		source = table.intern("source");
+		firstgid = table.intern("firstgid");
+		visible = table.intern("visible");
+		offsetx = table.intern("offsetx");
+		offsety = table.intern("offsety");
+		opacity = table.intern("opacity");
+		encoding = table.intern("encoding");
+		compression = table.intern("compression");
+		gid = table.intern("gid");
+		infinite = table.intern("infinite");
+	}
+};
+
+static Error _xml_error(const HatchXMLReader &p_reader){
+	ERR_FAIL_V_MSG(ERR_FILE_CORRUPT, "Invalid TMX data: " + p_reader.get_error() + ".");
+}
+
+static void _read_tileset_attributes(const HatchXMLReader &p_reader, const TMXNames &p_names, HatchTMXTileset &r_tileset){
+	r_tileset.name = p_reader.get_attribute(p_names.name).to_string();
+	r_tileset.tile_size.x = p_reader.get_attribute(p_names.tilewidth).to_int();
+	r_tileset.tile_size.y = p_reader.get_attribute(p_names.tileheight).to_int();
+	r_tileset.columns = p_reader.get_attribute(p_names.columns).to_int();
+	r_tileset.tile_count = p_reader.get_attribute(p_names.tilecount).to_int();
+	r_tileset.spacing = p_reader.get_attribute(p_names.spacing).to_int();
+	r_tileset.margin = p_reader.get_attribute(p_names.margin).to_int();
+}
+
+//Reads a <tileset> element's children up to its closing tag
+static Error _read_tileset_body(HatchXMLReader &p_reader, const TMXNames &p_names, const String &p_base_dir, HatchTMXTileset &r_tileset){
+	uint32_t depth = p_reader.get_depth();
+
+	while (true){
+		HatchXMLReader::Event event = p_reader.next();
+
+		if (event == HatchXMLReader::EVENT_END and p_reader.get_depth() < depth){
+			return OK;
+		}
+		if (event == HatchXMLReader::EVENT_ERROR or event == HatchXMLReader::EVENT_EOF){
+			return _xml_error(p_reader);
+		}
+		if (event != HatchXMLReader::EVENT_START){
+			continue;
+		}
+
+		uint32_t name = p_reader.get_name();
+
+		if (name == p_names.image){
+			r_tileset.image_path = p_base_dir.path_join(p_reader.get_attribute(p_names.source).to_string());
+			r_tileset.image_size.x = p_reader.get_attribute(p_names.width).to_int();
+			r_tileset.image_size.y = p_reader.get_attribute(p_names.height).to_int();
+		}
+
+		//per-tile properties, collision and animations aren't used for drawing
+		if (name == p_names.tile or name == p_names.image or name == p_names.properties or name == p_names.wangsets){
+			if (p_reader.skip_element() != OK){
+				return _xml_error(p_reader);
+			}
+		}
+	}
+}
+
+static Error _read_external_tileset(const String &p_path, TMXNames &p_names, HatchTMXTileset &r_tileset){
+	PackedByteArray bytes;
+	Error err = HatchArchiveReader::load_path(p_path, bytes);
+	ERR_FAIL_COND_V_MSG(err != OK, err, "Could not read tileset \"" + p_path + "\".");
+
+	HatchXMLReader reader(bytes.ptr(), bytes.size(), p_names.table);
+
+	while (true){
+		HatchXMLReader::Event event = reader.next();
+
+		if (event == HatchXMLReader::EVENT_ERROR){
+			return _xml_error(reader);
+		}
+		if (event == HatchXMLReader::EVENT_EOF){
+			break;
+		}
+
+		if (event == HatchXMLReader::EVENT_START and reader.get_name() == p_names.tileset){
+			_read_tileset_attributes(reader, p_names, r_tileset);
+			return _read_tileset_body(reader, p_names, p_path.get_base_dir(), r_tileset);
+		}
+	}
+
+	ERR_FAIL_V_MSG(ERR_FILE_CORRUPT, "\"" + p_path + "\" has no tileset.");
+}
+
+//CSV tile data can arrive split over text and CDATA runs, so numbers carry over between calls
+struct TMXCSVState {
+	uint32_t *gids;
+	int64_t count;
+	int64_t index = 0;
+	uint64_t value = 0;
+	bool in_number = false;
+};
+
+static Error _decode_csv(const char *p_text, uint32_t p_length, TMXCSVState &r_state){
+	for (uint32_t i = 0; i <= p_length; i++){
+		char c = i < p_length ? p_text[i] : ',';
+
+		if (c >= '0' and c <= '9'){
+			r_state.value = r_state.value * 10 + (c - '0');
+			r_state.in_number = true;
+			continue;
+		}
+
+		//the end of a run isn't the end of a number, the next run may continue it
+		if (i == p_length){
+			break;
+		}
+
+		if (r_state.in_number){
+			ERR_FAIL_COND_V_MSG(r_state.index >= r_state.count, ERR_FILE_CORRUPT, "TMX layer has more tiles than its size.");
+			r_state.gids[r_state.index++] = r_state.value;
+			r_state.value = 0;
+			r_state.in_number = false;
+		}
+	}
+
+	return OK;
+}
+
+static Error _decode_base64(const LocalVector<uint8_t> &p_encoded, const HatchXMLSpan &p_compression, uint32_t *r_gids, int64_t p_count){
+	PackedByteArray decoded;
+	decoded.resize(p_encoded.size() / 4 * 3 + 3);
+
+	size_t decoded_length = 0;
+	Error err = CryptoCore::b64_decode(decoded.ptrw(), decoded.size(), &decoded_length, p_encoded.ptr(), p_encoded.size());
+	ERR_FAIL_COND_V_MSG(err != OK, ERR_FILE_CORRUPT, "Invalid base64 in TMX layer data.");
+
+	int64_t expected = p_count * 4;
+	const uint8_t *bytes = decoded.ptr();
+
+	PackedByteArray inflated;
+	if (not p_compression.is_empty()){
+		Compression::Mode mode;
+		if (p_compression == "zlib"){
+			mode = Compression::MODE_DEFLATE;
+		} else if (p_compression == "gzip"){
+			mode = Compression::MODE_GZIP;
+		} else if (p_compression == "zstd"){
+			mode = Compression::MODE_ZSTD;
+		} else {
+			ERR_FAIL_V_MSG(ERR_UNAVAILABLE, "Unsupported TMX layer compression \"" + p_compression.to_string() + "\".");
+		}
+
+		inflated.resize(expected);
+		int64_t out_size = Compression::decompress(inflated.ptrw(), expected, bytes, decoded_length, mode);
+		ERR_FAIL_COND_V_MSG(out_size != expected, ERR_FILE_CORRUPT, "TMX layer data doesn't match the layer size.");
+
+		bytes = inflated.ptr();
+	} else {
+		ERR_FAIL_COND_V_MSG((int64_t)decoded_length != expected, ERR_FILE_CORRUPT, "TMX layer data doesn't match the layer size.");
+	}
+
+	for (int64_t i = 0; i < p_count; i++){
+		r_gids[i] = decode_uint32(bytes + i * 4);
+	}
+
+	return OK;
+}
+
+//Reads a <data> element's contents up to its closing tag
+static Error _read_layer_data(HatchXMLReader &p_reader, const TMXNames &p_names, uint32_t *r_gids, int64_t p_count){
+	uint32_t depth = p_reader.get_depth();
+	HatchXMLSpan encoding = p_reader.get_attribute(p_names.encoding);
+	HatchXMLSpan compression = p_reader.get_attribute(p_names.compression);
+
+	bool csv = encoding == "csv";
+	bool base64 = encoding == "base64";
+	ERR_FAIL_COND_V_MSG(not encoding.is_empty() and not csv and not base64, ERR_UNAVAILABLE, "Unsupported TMX layer encoding \"" + encoding.to_string() + "\".");
+
+	TMXCSVState csv_state;
+	csv_state.gids = r_gids;
+	csv_state.count = p_count;
+
+	LocalVector<uint8_t> encoded;
+	int64_t index = 0;
+
+	while (true){
+		HatchXMLReader::Event event = p_reader.next();
+
+		if (event == HatchXMLReader::EVENT_END and p_reader.get_depth() < depth){
+			break;
+		}
+		if (event == HatchXMLReader::EVENT_ERROR or event == HatchXMLReader::EVENT_EOF){
+			return _xml_error(p_reader);
+		}
+
+		if (event == HatchXMLReader::EVENT_START){
+			//the oldest TMX files list every tile as its own element, and never with an encoding
+			if (p_reader.get_name() == p_names.tile){
+				ERR_FAIL_COND_V_MSG(not encoding.is_empty(), ERR_FILE_CORRUPT, "TMX layer has tile elements inside encoded layer data.");
+				ERR_FAIL_COND_V(index >= p_count, ERR_FILE_CORRUPT);
+				r_gids[index++] = p_reader.get_attribute(p_names.gid).to_int();
+				continue;
+			}
+
+			//anything else in encoded data is a chunk
+			ERR_FAIL_COND_V_MSG(not encoding.is_empty(), ERR_UNAVAILABLE, "Infinite TMX maps aren't supported.");
+			continue;
+		}
+
+		if (event != HatchXMLReader::EVENT_TEXT){
+			continue;
+		}
+
+		const HatchXMLSpan &text = p_reader.get_text();
+
+		if (csv){
+			Error err = _decode_csv(text.ptr, text.length, csv_state);
+			if (err != OK){
+				return err;
+			}
+		} else if (base64){
+			uint32_t offset = encoded.size();
+			encoded.resize(offset + text.length);
+
+			uint32_t length = offset;
+			for (uint32_t i = 0; i < text.length; i++){
+				char c = text.ptr[i];
+				if (c != ' ' and c != '\t' and c != '\n' and c != '\r'){
+					encoded[length++] = c;
+				}
+			}
+			encoded.resize(length);
+		}
+	}
+
+	if (csv){
+		//flush a number that ran up to the closing tag
+		return _decode_csv(",", 1, csv_state);
+	}
+	if (base64){
+		return _decode_base64(encoded, compression, r_gids, p_count);
+	}
+
+	return OK;
+}
+
+static Error _read_layer(HatchXMLReader &p_reader, const TMXNames &p_names, HatchTMXLayer &r_layer, LocalVector<uint32_t> &r_gids){
+	r_layer.name = p_reader.get_attribute(p_names.name).to_string();
+	r_layer.size.x = p_reader.get_attribute(p_names.width).to_int();
+	r_layer.size.y = p_reader.get_attribute(p_names.height).to_int();
+	r_layer.visible = p_reader.get_attribute(p_names.visible) != "0";
+	r_layer.offset.x = p_reader.get_attribute(p_names.offsetx).to_int();
+	r_layer.offset.y = p_reader.get_attribute(p_names.offsety).to_int();
+
+	HatchXMLSpan opacity = p_reader.get_attribute(p_names.opacity);
+	r_layer.opacity = opacity.is_empty() ? 1.0 : opacity.to_float();
+
+	ERR_FAIL_COND_V(r_layer.size.x <= 0 or r_layer.size.y <= 0, ERR_FILE_CORRUPT);
+
+	int64_t count = (int64_t)r_layer.size.x * r_layer.size.y;
+	r_gids.resize(count);
+	memset(r_gids.ptr(), 0, count * sizeof(uint32_t));
+
+	uint32_t depth = p_reader.get_depth();
+
+	while (true){
+		HatchXMLReader::Event event = p_reader.next();
+
+		if (event == HatchXMLReader::EVENT_END and p_reader.get_depth() < depth){
+			return OK;
+		}
+		if (event == HatchXMLReader::EVENT_ERROR or event == HatchXMLReader::EVENT_EOF){
+			return _xml_error(p_reader);
+		}
+		if (event != HatchXMLReader::EVENT_START){
+			continue;
+		}
+
+		uint32_t name = p_reader.get_name();
+
+		if (name == p_names.data){
+			Error err = _read_layer_data(p_reader, p_names, r_gids.ptr(), count);
+			if (err != OK){
+				return err;
+			}
+		} else if (p_reader.skip_element() != OK){
+			return _xml_error(p_reader);
+		}
+	}
+}
+
+Error HatchTMXReader::parse(const PackedByteArray &p_buffer, const String &p_base_dir, HatchTMXMap &r_map, LayerCallback p_callback, void *p_userdata){
+	HATCH_SCOPED_TIMER("hatch_tmx_parse", XML_PARSE_USEC);
+
+	TMXNames names;
+	HatchXMLReader reader(p_buffer.ptr(), p_buffer.size(), names.table);
+
+	bool has_map = false;
+	LocalVector<uint32_t> gids;
+	Error err = OK;
+
+	while (true){
+		HatchXMLReader::Event event = reader.next();
+
+		if (event == HatchXMLReader::EVENT_ERROR){
+			return _xml_error(reader);
+		}
+		if (event == HatchXMLReader::EVENT_EOF){
+			break;
+		}
+		if (event != HatchXMLReader::EVENT_START){
+			continue;
+		}
+
+		uint32_t name = reader.get_name();
+
+		if (name == names.map){
+			ERR_FAIL_COND_V_MSG(reader.get_attribute(names.infinite) == "1", ERR_UNAVAILABLE, "Infinite TMX maps aren't supported.");
+
+			r_map.size.x = reader.get_attribute(names.width).to_int();
+			r_map.size.y = reader.get_attribute(names.height).to_int();
+			r_map.tile_size.x = reader.get_attribute(names.tilewidth).to_int();
+			r_map.tile_size.y = reader.get_attribute(names.tileheight).to_int();
+			has_map = true;
+		} else if (name == names.tileset){
+			HatchTMXTileset tileset;
+			tileset.first_gid = reader.get_attribute(names.firstgid).to_int();
+
+			HatchXMLSpan source = reader.get_attribute(names.source);
+			if (not source.is_empty()){
+				String source_path = p_base_dir.path_join(source.to_string());
+				if (reader.skip_element() != OK){
+					return _xml_error(reader);
+				}
+				err = _read_external_tileset(source_path, names, tileset);
+			} else {
+				_read_tileset_attributes(reader, names, tileset);
+				err = _read_tileset_body(reader, names, p_base_dir, tileset);
+			}
+
+			if (err != OK){
+				return err;
+			}
+
+			r_map.tilesets.push_back(tileset);
+		} else if (name == names.layer){
+			HatchTMXLayer layer;
+			layer.index = r_map.layer_count;
+
+			err = _read_layer(reader, names, layer, gids);
+			if (err != OK){
+				return err;
+			}
+
+			p_callback(p_userdata, layer, gids.ptr());
+			r_map.layer_count++;
+		} else if (name == names.objectgroup or name == names.imagelayer or name == names.properties){
+			if (reader.skip_element() != OK){
+				return _xml_error(reader);
+			}
+		}
+	}
+
+	ERR_FAIL_COND_V_MSG(not has_map, ERR_FILE_CORRUPT, "TMX data has no map.");
+	ERR_FAIL_COND_V(r_map.tile_size.x <= 0 or r_map.tile_size.y <= 0, ERR_FILE_CORRUPT);
+
+	return OK;
+}
+
+int HatchTMXReader::find_tileset(const HatchTMXMap &p_map, uint32_t p_gid){
+	if (p_gid == 0){
+		return -1;
+	}
+
+	//tilesets are listed in ascending firstgid order
+	for (int i = (int)p_map.tilesets.size() - 1; i >= 0; i--){
+		if (p_map.tilesets[i].first_gid <= p_gid){
+			return i;
+		}
+	}
+
+	return -1;
+}
@@ -0,0 +1,58 @@
+#ifndef HATCH_TMX_READER_H
+#define HATCH_TMX_READER_H
+
+#include "core/math/rect2i.h"
+#include "core/string/ustring.h"
+#include "core/templates/local_vector.h"
+
+//Tiled stores flips in the top bits of every global tile id
+#define HATCH_TMX_FLIP_H 0x80000000U
+#define HATCH_TMX_FLIP_V 0x40000000U
+#define HATCH_TMX_FLIP_DIAGONAL 0x20000000U
+#define HATCH_TMX_GID_MASK 0x1FFFFFFFU
+
+struct HatchTMXTileset {
+	uint32_t first_gid = 1;
+	String name;
+	Size2i tile_size;
+	int columns = 0;
+	int tile_count = 0;
+	int spacing = 0;
+	int margin = 0;
+	String image_path;
+	Size2i image_size;
+};
+
+struct HatchTMXLayer {
+	String name;
+	int index = 0;
+	Size2i size;
+	bool visible = true;
+	float opacity = 1.0;
+	Vector2i offset;
+};
+
+struct HatchTMXMap {
+	Size2i size;
+	Size2i tile_size;
+	LocalVector<HatchTMXTileset> tilesets;
+	int layer_count = 0;
+};
+
+/*
+ Reads Tiled (.tmx) scenes, the format Hatch levels are authored in. Tile layers are handed
+ to the callback one at a time as decoded global ids and are not kept, so only one layer's
+ tiles are ever fully expanded in memory while a scene loads.
+ */
+class HatchTMXReader {
+public:
+	typedef void (*LayerCallback)(void *p_userdata, const HatchTMXLayer &p_layer, const uint32_t *p_gids);
+
+	//p_base_dir is where external tilesets and images are resolved from
+	static Error parse(const PackedByteArray &p_buffer, const String &p_base_dir, HatchTMXMap &r_map, LayerCallback p_callback, void *p_userdata);
+
+	//Index into r_map.tilesets for a global id (flip bits removed), or -1
+	static int find_tileset(const HatchTMXMap &p_map, uint32_t p_gid);
+};
+
+#endif